@@ -0,0 +1,295 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Header-only chunked bump allocator used for suffix tree nodes.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#include <unistd.h>
+#define ARENA_CAN_MAP 1
+#endif
+
+/**
+ * Arena: hands out memory from a list of large blocks by bumping an offset.
+ * Objects are never freed individually; rewind() makes all blocks available
+ * again without returning them to the system, so rebuilding a structure of
+ * similar size performs no heap allocation at all.
+ */
+class Arena {
+public:
+    explicit Arena(size_t firstBlockSize = 64 * 1024)
+        : firstBlockSize(firstBlockSize), current(0), offset(0) {}
+
+    ~Arena() { release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Moving hands the blocks over; the source is left empty
+    Arena(Arena &&other) noexcept
+        : blocks(std::move(other.blocks)), firstBlockSize(other.firstBlockSize),
+          current(other.current), offset(other.offset) {
+        other.blocks.clear();
+        other.current = 0;
+        other.offset = 0;
+    }
+
+    Arena& operator=(Arena &&other) noexcept {
+        if (this != &other) {
+            release();
+            blocks = std::move(other.blocks);
+            firstBlockSize = other.firstBlockSize;
+            current = other.current;
+            offset = other.offset;
+            other.blocks.clear();
+            other.current = 0;
+            other.offset = 0;
+        }
+        return *this;
+    }
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        while (current < blocks.size()) {
+            Block &b = blocks[current];
+            size_t aligned = (offset + align - 1) & ~(align - 1);
+            if (aligned + bytes <= b.size) {
+                offset = aligned + bytes;
+                return b.data + aligned;
+            }
+            // Move on to the next retained block (the tail of this one is wasted)
+            current++;
+            offset = 0;
+        }
+
+        // Out of retained blocks: grow geometrically
+        size_t size = blocks.empty() ? firstBlockSize : blocks.back().size * 2;
+        if (size > MAX_BLOCK_SIZE) size = MAX_BLOCK_SIZE;
+        if (size < bytes + align) size = bytes + align;
+        size = (size + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1);
+        blocks.push_back({newBlock(size), size});
+        current = blocks.size() - 1;
+        offset = 0;
+        return allocate(bytes, align);
+    }
+
+    // Constructs a T in arena memory. T's destructor is never run.
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Reuse every block from the start; previous allocations become invalid
+    void rewind() {
+        current = 0;
+        offset = 0;
+    }
+
+    // Return every block to the system
+    void release() {
+        for (Block &b : blocks) {
+#ifdef ARENA_CAN_MAP
+            if (b.mapped) {
+                ::munmap(b.data, b.mapped);
+                continue;
+            }
+#endif
+            ::operator delete(b.data, std::align_val_t(BLOCK_ALIGN));
+        }
+        blocks.clear();
+        current = 0;
+        offset = 0;
+    }
+
+    // Where one block of the source went in a clone()
+    struct Relocation {
+        const char *from;
+        size_t size;   // Bytes in use: no valid pointer reaches past them
+        char *to;
+    };
+
+    /**
+     * @brief Copies the used part of every block into a new arena with the
+     * same block sizes, one memcpy per block. Pointers stored inside the
+     * copied objects still point into this arena; fix them up with
+     * relocate() and the returned 'relocations'.
+     */
+    Arena clone(std::vector<Relocation> &relocations) const {
+        Arena copy(firstBlockSize);
+        relocations.clear();
+        size_t used = blocks.empty() ? 0 : current + 1;
+        for (size_t i = 0; i < used; i++) {
+            size_t bytes = (i == current) ? offset : blocks[i].size;
+            char *data = newBlock(blocks[i].size);
+            std::memcpy(data, blocks[i].data, bytes);
+            copy.blocks.push_back({data, blocks[i].size});
+            relocations.push_back({blocks[i].data, bytes, data});
+        }
+        copy.current = used ? used - 1 : 0;
+        copy.offset = offset;
+        std::sort(relocations.begin(), relocations.end(),
+                  [](const Relocation &a, const Relocation &b) { return a.from < b.from; });
+        return copy;
+    }
+
+    // Writes the used part of every block, tagged with its address, so a
+    // reader can rebase pointers stored in it (see read()). On seekable
+    // streams each block's bytes start at a BLOCK_ALIGN file offset, so
+    // mapFile() can map them back in place.
+    void write(std::ostream &out) const {
+        uint64_t used = blocks.empty() ? 0 : current + 1;
+        out.write((const char*)&used, sizeof(used));
+        for (size_t i = 0; i < used; i++) {
+            uint64_t header[4] = {(uint64_t)(uintptr_t)blocks[i].data, blocks[i].size,
+                                  i == current ? offset : blocks[i].size, 0};
+            std::streamoff pos = out.tellp();
+            if (pos >= 0) header[3] = (BLOCK_ALIGN - (pos + sizeof(header)) % BLOCK_ALIGN) % BLOCK_ALIGN;
+            out.write((const char*)header, sizeof(header));
+            for (uint64_t k = 0; k < header[3]; k++) out.put(0);
+            out.write(blocks[i].data, header[2]);
+        }
+    }
+
+    // Replaces 'into' with blocks written by write(); 'relocations' map the
+    // stored addresses to the new blocks. False on a truncated stream or
+    // impossible block sizes.
+    static bool read(std::istream &in, Arena &into, std::vector<Relocation> &relocations) {
+        Arena copy(into.firstBlockSize);
+        relocations.clear();
+        uint64_t used;
+        if (!in.read((char*)&used, sizeof(used))) return false;
+        for (uint64_t i = 0; i < used; i++) {
+            uint64_t header[4];
+            // Blocks are BLOCK_ALIGN multiples no larger than MAX_BLOCK_SIZE
+            // (nodes and child arrays are far smaller than that)
+            if (!in.read((char*)header, sizeof(header)) || header[1] == 0 || header[1] % BLOCK_ALIGN ||
+                header[1] > MAX_BLOCK_SIZE || header[2] > header[1]) {
+                return false;
+            }
+            char *data = newBlock(header[1]);
+            copy.blocks.push_back({data, header[1]});
+            if (!in.ignore(header[3]) || !in.read(data, header[2])) return false;
+            relocations.push_back({(const char*)(uintptr_t)header[0], header[2], data});
+            copy.offset = header[2];
+        }
+        copy.current = used ? used - 1 : 0;
+        std::sort(relocations.begin(), relocations.end(),
+                  [](const Relocation &a, const Relocation &b) { return a.from < b.from; });
+        into = std::move(copy);
+        return true;
+    }
+
+    /**
+     * @brief Maps blocks written by write() at file offset 'at' of 'fd'
+     * back at their original addresses (copy-on-write), so pointers stored
+     * in them stay valid with no relocation pass and pages are read only
+     * when touched. Returns false, leaving 'into' unchanged, if the image
+     * is unaligned or any address range is taken; use read() then.
+     */
+    static bool mapFile(int fd, uint64_t at, Arena &into) {
+#ifdef ARENA_CAN_MAP
+        Arena mapped(into.firstBlockSize);
+        uint64_t used;
+        if (::pread(fd, &used, sizeof(used), at) != sizeof(used)) return false;
+        at += sizeof(used);
+        for (uint64_t i = 0; i < used; i++) {
+            uint64_t header[4];
+            if (::pread(fd, header, sizeof(header), at) != sizeof(header)) return false;
+            at += sizeof(header) + header[3];
+            char *address = (char*)(uintptr_t)header[0];
+            if (at % BLOCK_ALIGN || (uintptr_t)address % BLOCK_ALIGN || header[2] == 0 || header[2] > header[1]) {
+                return false;
+            }
+#ifdef MAP_FIXED_NOREPLACE
+            int flags = MAP_PRIVATE | MAP_FIXED_NOREPLACE;
+#else
+            int flags = MAP_PRIVATE; // 'address' is only a hint; checked below
+#endif
+            void *p = ::mmap(address, header[2], PROT_READ | PROT_WRITE, flags, fd, at);
+            if (p == MAP_FAILED) return false;
+            // The last block is cut to its used bytes: nothing past the file end
+            // is ever handed out
+            mapped.blocks.push_back({(char*)p, i + 1 == used ? header[2] : header[1], header[2]});
+            if (p != address) return false;
+            at += header[2];
+        }
+        mapped.current = used ? used - 1 : 0;
+        mapped.offset = used ? mapped.blocks.back().size : 0;
+        into = std::move(mapped);
+        return true;
+#else
+        (void)fd; (void)at; (void)into;
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Maps a pointer into the cloned arena to the same spot in the
+     * clone. Throws std::runtime_error unless the 'bytes' at 'p' lie in the
+     * used part of one block and 'p' is aligned for T, so pointers read
+     * from a file can never lead outside the arena.
+     */
+    template <typename T>
+    static T* relocate(T *p, const std::vector<Relocation> &relocations, size_t bytes = sizeof(T)) {
+        if (!p) return p;
+        uintptr_t c = (uintptr_t)p;
+        auto it = std::upper_bound(relocations.begin(), relocations.end(), c,
+                                   [](uintptr_t c, const Relocation &r) { return c < (uintptr_t)r.from; });
+        // 'p' can only lie in the last block starting at or before it
+        if (it != relocations.begin() && c % alignof(T) == 0) {
+            --it;
+            size_t at = c - (uintptr_t)it->from;
+            if (at <= it->size && bytes <= it->size - at) return (T*)(it->to + at);
+        }
+        throw std::runtime_error("Arena::relocate: pointer outside the arena");
+    }
+
+    // Total bytes held in blocks (used or not)
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block &b : blocks) total += b.size;
+        return total;
+    }
+
+private:
+    static constexpr size_t MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+
+    // Blocks are aligned to, and sized in multiples of, 64 KiB: no two
+    // blocks share a page, whatever the page size, so each can be mapped
+    // from a file on its own
+    static constexpr size_t BLOCK_ALIGN = 64 * 1024;
+
+    struct Block {
+        char *data;
+        size_t size;
+        size_t mapped = 0;  // Bytes mapped by mapFile() (munmap, not delete)
+    };
+
+    static char* newBlock(size_t size) {
+        return static_cast<char*>(::operator new(size, std::align_val_t(BLOCK_ALIGN)));
+    }
+
+    std::vector<Block> blocks;
+    size_t firstBlockSize;
+    size_t current;   // Block currently being filled
+    size_t offset;    // Bump offset inside blocks[current]
+};
+
+#endif // ARENA_H
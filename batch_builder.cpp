@@ -0,0 +1,50 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "batch_builder.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+std::vector<std::unique_ptr<SuffixTree>> buildMany(const std::vector<std::string_view> &inputs, int threads,
+                                                   BuildReport *report) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::unique_ptr<SuffixTree>> trees(inputs.size());
+    std::vector<double> latency(inputs.size(), 0.0);
+
+    // Largest inputs first
+    std::vector<size_t> order(inputs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return inputs[a].size() > inputs[b].size();
+    });
+
+    auto batchStart = Clock::now();
+    {
+        WorkStealingPool pool(threads);
+        for (size_t k = 0; k < order.size(); k++) {
+            size_t i = order[k];
+            pool.submit([&, i] {
+                auto start = Clock::now();
+                trees[i] = std::make_unique<SuffixTree>(std::string(inputs[i]));
+                latency[i] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            }, (int)k);
+        }
+        pool.wait();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - batchStart).count();
+
+    if (report) {
+        size_t chars = 0;
+        for (auto in : inputs) chars += in.size();
+        report->seconds = seconds;
+        report->charsPerSecond = seconds > 0 ? chars / seconds : 0;
+        report->latencyMs = std::move(latency);
+    }
+    return trees;
+}
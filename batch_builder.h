@@ -0,0 +1,38 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef BATCH_BUILDER_H
+#define BATCH_BUILDER_H
+
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "suffixtree.h"
+
+/**
+ * Timing of a buildMany() call.
+ */
+struct BuildReport {
+    double seconds = 0;              // Wall time of the whole batch
+    double charsPerSecond = 0;       // Total input characters / seconds
+    std::vector<double> latencyMs;   // Build time of each input, in input order
+};
+
+/**
+ * buildMany:
+ * Builds one SuffixTree per input on a work-stealing pool of 'threads'
+ * workers (hardware concurrency if <= 0). Inputs are started largest
+ * first and dealt round-robin to the workers, so the long builds do not
+ * end up as stragglers. Every tree allocates from its own arena, so the
+ * workers do not contend on the global allocator.
+ *
+ * Trees are returned in input order; pass 'report' to receive timings.
+ */
+std::vector<std::unique_ptr<SuffixTree>> buildMany(const std::vector<std::string_view> &inputs, int threads = 0,
+                                                   BuildReport *report = nullptr);
+
+#endif // BATCH_BUILDER_H
@@ -0,0 +1,78 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Header-only map between positions in a separator-joined corpus and the
+ * documents (records) they fall in. Shared by the multi-document indexes.
+ */
+
+#ifndef DOCUMENT_MAP_H
+#define DOCUMENT_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * DocumentMap: global start offset of every document in the concatenated
+ * position space, where each document is followed by one separator.
+ *
+ * The starts either live in the map or are viewed in place from storage
+ * that the map keeps alive (e.g. a mapped file, see view()), so opening a
+ * saved index does not rebuild them.
+ */
+class DocumentMap {
+public:
+    DocumentMap() = default;
+
+    /**
+     * @brief Views 'count' documents whose count + 1 ascending starts are
+     * at 'starts' (starts[0] == 0, starts[count] one past the end). 'owner'
+     * keeps that memory alive as long as the map or a copy of it exists.
+     */
+    static DocumentMap view(const int64_t *starts, int count, std::shared_ptr<const void> owner) {
+        DocumentMap map;
+        map.viewed = starts;
+        map.viewedCount = count;
+        map.owner = std::move(owner);
+        return map;
+    }
+
+    // Appends a document of 'length' bytes and returns its ID. A viewed
+    // map is copied into the map first.
+    int add(int64_t length) {
+        if (viewed) {
+            owned.assign(viewed, viewed + viewedCount + 1);
+            viewed = nullptr;
+            owner.reset();
+        }
+        owned.push_back(owned.back() + length + 1);
+        return size() - 1;
+    }
+
+    // Document containing global position 'pos' (pos must be in range)
+    int documentAt(int64_t pos) const {
+        const int64_t *first = starts();
+        return (int)(std::upper_bound(first, first + size() + 1, pos) - first) - 1;
+    }
+
+    int64_t start(int doc) const { return starts()[doc]; }
+    int64_t length(int doc) const { return starts()[doc + 1] - starts()[doc] - 1; }
+    int size() const { return viewed ? viewedCount : (int)owned.size() - 1; }
+
+    // The size() + 1 starts, for writing them out
+    const int64_t* data() const { return starts(); }
+
+private:
+    std::vector<int64_t> owned = {0}; // owned[size()] is one past the end
+    const int64_t *viewed = nullptr;   // Used instead of 'owned' when set
+    int viewedCount = 0;
+    std::shared_ptr<const void> owner;
+
+    const int64_t* starts() const { return viewed ? viewed : owned.data(); }
+};
+
+#endif // DOCUMENT_MAP_H
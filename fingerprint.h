@@ -0,0 +1,106 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Header-only Karp-Rabin prefix fingerprints modulo the Mersenne prime
+ * 2^61 - 1, for O(1) comparison of any two substrings.
+ */
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * PrefixFingerprints: h[i] is the fingerprint of text[0, i), so the
+ * fingerprint of text[pos, pos + len) is h[pos + len] - h[pos] * B^len.
+ * Equal strings always have equal fingerprints; different strings of
+ * length n collide with probability about n / 2^61, so callers verify a
+ * final match with a plain comparison.
+ */
+class PrefixFingerprints {
+public:
+    static constexpr uint64_t MOD = (1ULL << 61) - 1;
+    static constexpr uint64_t BASE = 0x1f3d5b79a2c4e681ULL % MOD;
+
+    PrefixFingerprints() : h(1, 0), power(1, 1) {
+        b[0] = 1;
+        for (int k = 1; k <= 4; k++) b[k] = mul(b[k - 1], BASE);
+    }
+
+    // Appends text[0, n) to the fingerprinted text
+    void extend(const char *text, size_t n) {
+        h.reserve(h.size() + n);
+        power.reserve(power.size() + n);
+        for (size_t i = 0; i < n; i++) {
+            h.push_back(add(mul(h.back(), BASE), (unsigned char)text[i] + 1));
+            power.push_back(mul(power.back(), BASE));
+        }
+    }
+
+    /**
+     * @brief Fingerprint of p[0, n), comparable with substring(). Four
+     * characters are folded in per step as h * B^4 + c0 * B^3 + ... + c3:
+     * the four products are independent and summed in 128 bits with a
+     * single reduction, so the serial dependency is one multiply per four
+     * characters instead of one per character.
+     */
+    uint64_t hash(const char *p, size_t n) const {
+        const unsigned char *s = (const unsigned char*)p;
+        uint64_t x = 0;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __uint128_t acc = (__uint128_t)x * b[4]
+                            + (__uint128_t)(s[i] + 1u) * b[3]
+                            + (__uint128_t)(s[i + 1] + 1u) * b[2]
+                            + (__uint128_t)(s[i + 2] + 1u) * b[1]
+                            + (s[i + 3] + 1u);
+            x = reduce(acc);
+        }
+        for (; i < n; i++) x = add(mul(x, BASE), s[i] + 1u);
+        return x;
+    }
+
+    void clear() {
+        h.assign(1, 0);
+        power.assign(1, 1);
+    }
+
+    // Characters fingerprinted so far
+    size_t size() const { return h.size() - 1; }
+
+    // Fingerprint of text[pos, pos + len)
+    uint64_t substring(size_t pos, size_t len) const {
+        return sub(h[pos + len], mul(h[pos], power[len]));
+    }
+
+    size_t memoryBytes() const { return (h.capacity() + power.capacity()) * sizeof(uint64_t); }
+
+private:
+    std::vector<uint64_t> h;      // h[i]: fingerprint of text[0, i)
+    std::vector<uint64_t> power;  // power[i]: BASE^i
+    uint64_t b[5];                // BASE^0 .. BASE^4 for hash()
+
+    // Reduction mod 2^61 - 1 needs only shifts and adds (x < 2^125)
+    static uint64_t reduce(__uint128_t x) {
+        uint64_t r = (uint64_t)(x & MOD) + (uint64_t)(x >> 61);
+        r = (r & MOD) + (r >> 61);
+        return r >= MOD ? r - MOD : r;
+    }
+    static uint64_t mul(uint64_t a, uint64_t c) {
+        return reduce((__uint128_t)a * c);
+    }
+    static uint64_t add(uint64_t a, uint64_t b) {
+        uint64_t r = a + b;
+        return r >= MOD ? r - MOD : r;
+    }
+    static uint64_t sub(uint64_t a, uint64_t b) {
+        return a >= b ? a - b : a + MOD - b;
+    }
+};
+
+#endif // FINGERPRINT_H
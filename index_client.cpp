@@ -0,0 +1,91 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "index_client.h"
+#include <stdexcept>
+#include <sys/un.h>
+
+using namespace IndexProtocol;
+
+IndexClient::IndexClient(const std::string &socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("IndexClient: socket path too long");
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("IndexClient: cannot connect to " + socketPath + ": " + std::strerror(errno));
+    }
+}
+
+IndexClient::~IndexClient() {
+    ::close(fd);
+}
+
+const char* IndexClient::receive(uint32_t &id) {
+    if (!readFrame(fd, payload) || payload.size() < RESPONSE_HEADER) {
+        throw std::runtime_error("IndexClient: connection lost");
+    }
+    id = get<uint32_t>(payload.data());
+    if ((Status)get<uint8_t>(payload.data() + 4) != Status::Ok) {
+        throw std::runtime_error("IndexClient: request rejected by server");
+    }
+    return payload.data() + RESPONSE_HEADER;
+}
+
+const char* IndexClient::call(Op op, const std::string &pattern) {
+    std::string frame;
+    uint32_t id = nextId++;
+    putRequest(frame, id, op, pattern);
+    if (!writeFully(fd, frame.data(), frame.size())) throw std::runtime_error("IndexClient: connection lost");
+
+    uint32_t answered;
+    const char *body = receive(answered);
+    if (answered != id) throw std::runtime_error("IndexClient: response out of sequence");
+    return body;
+}
+
+bool IndexClient::search(const std::string &pattern) {
+    return get<uint8_t>(call(Op::Search, pattern)) != 0;
+}
+
+int64_t IndexClient::count(const std::string &pattern) {
+    return get<int64_t>(call(Op::Count, pattern));
+}
+
+std::vector<int64_t> IndexClient::findAll(const std::string &pattern) {
+    const char *body = call(Op::FindAll, pattern);
+    uint32_t n = get<uint32_t>(body);
+    if (payload.size() != RESPONSE_HEADER + 4 + (size_t)n * 8) {
+        throw std::runtime_error("IndexClient: malformed response");
+    }
+    std::vector<int64_t> positions(n);
+    for (uint32_t i = 0; i < n; i++) positions[i] = get<int64_t>(body + 4 + 8 * (size_t)i);
+    return positions;
+}
+
+std::vector<bool> IndexClient::searchMany(const std::vector<std::string> &patterns) {
+    std::string frames;
+    uint32_t first = nextId;
+    for (const std::string &p : patterns) putRequest(frames, nextId++, Op::Search, p);
+    if (!writeFully(fd, frames.data(), frames.size())) throw std::runtime_error("IndexClient: connection lost");
+
+    // Responses may come back in any order
+    std::vector<bool> found(patterns.size());
+    for (size_t k = 0; k < patterns.size(); k++) {
+        uint32_t id;
+        const char *body = receive(id);
+        uint32_t index = id - first;
+        if (index >= patterns.size()) throw std::runtime_error("IndexClient: response out of sequence");
+        found[index] = get<uint8_t>(body) != 0;
+    }
+    return found;
+}
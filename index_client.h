@@ -0,0 +1,49 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef INDEX_CLIENT_H
+#define INDEX_CLIENT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "index_protocol.h"
+
+/**
+ * IndexClient: one connection to an IndexServer (ukkonen-server).
+ * Calls block until answered and throw std::runtime_error if the
+ * connection fails or the server rejects a request. A client is not
+ * thread-safe; use one per thread.
+ */
+class IndexClient {
+public:
+    explicit IndexClient(const std::string &socketPath);
+    ~IndexClient();
+
+    IndexClient(const IndexClient&) = delete;
+    IndexClient& operator=(const IndexClient&) = delete;
+
+    bool search(const std::string &pattern);
+    int64_t count(const std::string &pattern);
+    // Throws if the pattern has more occurrences than the server's cap
+    // (IndexProtocol::MAX_FIND_ALL at most)
+    std::vector<int64_t> findAll(const std::string &pattern);
+
+    // Pipelined: sends every request in one write, then reads the answers
+    std::vector<bool> searchMany(const std::vector<std::string> &patterns);
+
+private:
+    int fd;
+    uint32_t nextId = 0;
+    std::string payload; // Last response payload, reused
+
+    // Sends one request and returns the response payload after its header
+    const char* call(IndexProtocol::Op op, const std::string &pattern);
+    const char* receive(uint32_t &id);
+};
+
+#endif // INDEX_CLIENT_H
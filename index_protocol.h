@@ -0,0 +1,107 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Header-only wire format shared by ukkonen-server and its clients.
+ *
+ * Every message is a frame: a u32 payload length followed by the payload.
+ * Integers are little-endian.
+ *
+ *   request  payload: u32 id, u8 op, pattern bytes (rest of the frame)
+ *   response payload: u32 id, u8 status, then for status Ok
+ *       Search:  u8 found
+ *       Count:   i64 occurrences
+ *       FindAll: u32 n, n x i64 positions (sorted)
+ *
+ * A FindAll answer must fit in one frame: patterns with more than
+ * MAX_FIND_ALL occurrences are answered with BadRequest (use Count).
+ *
+ * Requests on one connection may be pipelined. Responses carry the
+ * request's id and can arrive in any order.
+ */
+
+#ifndef INDEX_PROTOCOL_H
+#define INDEX_PROTOCOL_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace IndexProtocol {
+
+enum class Op : uint8_t { Search = 1, Count = 2, FindAll = 3 };
+enum class Status : uint8_t { Ok = 0, BadRequest = 1 };
+
+constexpr uint32_t MAX_FRAME = 64u << 20;
+constexpr size_t REQUEST_HEADER = 5;   // id + op
+constexpr size_t RESPONSE_HEADER = 5;  // id + status
+constexpr uint32_t MAX_FIND_ALL = (MAX_FRAME - RESPONSE_HEADER - 4) / 8;
+
+template <typename T>
+inline void put(std::string &out, T value) {
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); i++) bytes[i] = (char)((uint64_t)value >> (8 * i));
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+inline T get(const char *in) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(T); i++) value |= (uint64_t)(uint8_t)in[i] << (8 * i);
+    return (T)value;
+}
+
+// Appends a complete request frame to 'out'
+inline void putRequest(std::string &out, uint32_t id, Op op, std::string_view pattern) {
+    put<uint32_t>(out, REQUEST_HEADER + pattern.size());
+    put<uint32_t>(out, id);
+    put<uint8_t>(out, (uint8_t)op);
+    out.append(pattern);
+}
+
+inline bool writeFully(int fd, const char *data, size_t n) {
+    while (n > 0) {
+#ifdef MSG_NOSIGNAL
+        ssize_t k = ::send(fd, data, n, MSG_NOSIGNAL); // A closed peer must not raise SIGPIPE
+#else
+        ssize_t k = ::write(fd, data, n);
+#endif
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        data += k;
+        n -= k;
+    }
+    return true;
+}
+
+inline bool readFully(int fd, char *data, size_t n) {
+    while (n > 0) {
+        ssize_t k = ::read(fd, data, n);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        data += k;
+        n -= k;
+    }
+    return true;
+}
+
+// Reads one frame's payload; false on EOF, I/O error or an oversized frame
+inline bool readFrame(int fd, std::string &payload) {
+    char header[4];
+    if (!readFully(fd, header, 4)) return false;
+    uint32_t length = get<uint32_t>(header);
+    if (length > MAX_FRAME) return false;
+    payload.resize(length);
+    return readFully(fd, payload.data(), length);
+}
+
+} // namespace IndexProtocol
+
+#endif // INDEX_PROTOCOL_H
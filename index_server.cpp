@@ -0,0 +1,283 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "index_server.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <unordered_map>
+#include <sys/un.h>
+
+using namespace IndexProtocol;
+
+IndexServer::IndexServer(SuffixTree &tree, const IndexServerOptions &options) : tree(tree), options(options) {
+    if (this->options.maxBatch < 1) this->options.maxBatch = 1;
+    if (this->options.maxPendingPerConnection < 1) this->options.maxPendingPerConnection = 1;
+    this->options.maxFindAll = std::min(this->options.maxFindAll, MAX_FIND_ALL);
+    if (this->options.dispatchers <= 0) {
+        this->options.dispatchers = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+IndexServer::~IndexServer() {
+    stop();
+}
+
+void IndexServer::start() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (options.socketPath.empty() || options.socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("IndexServer: invalid socket path '" + options.socketPath + "'");
+    }
+    std::strcpy(address.sun_path, options.socketPath.c_str());
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) throw std::runtime_error("IndexServer: socket() failed");
+    ::unlink(options.socketPath.c_str()); // Stale socket of a previous run
+    if (::bind(listenFd, (sockaddr*)&address, sizeof(address)) < 0 || ::listen(listenFd, 128) < 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        throw std::runtime_error("IndexServer: cannot listen on " + options.socketPath + ": " + std::strerror(errno));
+    }
+
+    stopping = false;
+    for (int i = 0; i < options.dispatchers; i++) dispatchers.emplace_back([this] { dispatchLoop(); });
+    acceptor = std::thread([this] { acceptLoop(); });
+}
+
+void IndexServer::stop() {
+    if (listenFd < 0) return;
+
+    // Unblocks accept() and every read()
+    ::shutdown(listenFd, SHUT_RDWR);
+    acceptor.join();
+    ::close(listenFd);
+    listenFd = -1;
+    ::unlink(options.socketPath.c_str());
+
+    // Unblocks every read() and send(), and readers waiting for their
+    // writer; answers still queued are dropped
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        for (auto &c : connections) {
+            ::shutdown(c->fd, SHUT_RDWR);
+            std::lock_guard<std::mutex> connectionLock(c->mutex);
+            c->failed = true;
+            c->changed.notify_all();
+        }
+    }
+    for (auto &c : connections) {
+        c->reader.join();
+        c->writer.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queued.notify_all();
+    for (auto &d : dispatchers) d.join();
+    dispatchers.clear();
+    queue.clear();
+    connections.clear();
+}
+
+IndexServerStats IndexServer::stats() const {
+    IndexServerStats s;
+    s.requests = requests;
+    s.batches = batches;
+    s.connections = accepted;
+    return s;
+}
+
+// --- Connections ---
+
+void IndexServer::acceptLoop() {
+    while (true) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return; // Listening socket shut down
+        }
+        accepted++;
+
+        auto connection = std::make_shared<Connection>();
+        connection->fd = fd;
+        std::lock_guard<std::mutex> lock(connectionMutex);
+
+        // Reap connections whose threads have both exited (queued requests
+        // keep them alive until answered)
+        connections.erase(std::remove_if(connections.begin(), connections.end(), [](auto &c) {
+            if (c->running) return false;
+            c->reader.join();
+            c->writer.join();
+            return true;
+        }), connections.end());
+
+        connection->reader = std::thread([this, connection] { readLoop(connection); });
+        connection->writer = std::thread([this, connection] { writeLoop(connection); });
+        connections.push_back(connection);
+    }
+}
+
+void IndexServer::readLoop(std::shared_ptr<Connection> connection) {
+    Connection &c = *connection;
+    std::string payload;
+    while (readFrame(c.fd, payload)) {
+        Request request;
+        request.connection = connection;
+        if (payload.size() < REQUEST_HEADER) break; // Malformed: drop the connection
+        request.id = get<uint32_t>(payload.data());
+        request.op = get<uint8_t>(payload.data() + 4);
+        request.pattern.assign(payload, REQUEST_HEADER);
+        {
+            // Backpressure: a client that does not read its answers stops
+            // being read from, instead of filling the shared queue
+            std::unique_lock<std::mutex> lock(c.mutex);
+            c.changed.wait(lock, [&] {
+                return c.failed || (c.pending < options.maxPendingPerConnection && c.outbox.size() < MAX_FRAME);
+            });
+            if (c.failed) break;
+            c.pending++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(std::move(request));
+        }
+        queued.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(c.mutex);
+        c.readerDone = true;
+    }
+    c.changed.notify_all();
+    c.running--;
+}
+
+/**
+ * writeLoop:
+ * Sends whatever the dispatchers appended to the outbox, one send per
+ * wakeup. Exits once the reader is done and every request it read has
+ * been answered, or on the first write error (the client is gone).
+ */
+void IndexServer::writeLoop(std::shared_ptr<Connection> connection) {
+    Connection &c = *connection;
+    std::string sending;
+    std::unique_lock<std::mutex> lock(c.mutex);
+    while (true) {
+        c.changed.wait(lock, [&] { return c.failed || !c.outbox.empty() || (c.readerDone && c.pending == 0); });
+        if (c.failed || c.outbox.empty()) break;
+        sending.swap(c.outbox);
+        int frames = c.outboxFrames;
+        c.outbox.clear();
+        c.outboxFrames = 0;
+
+        lock.unlock();
+        bool sent = writeFully(c.fd, sending.data(), sending.size());
+        lock.lock();
+        if (!sent) {
+            c.failed = true;
+            ::shutdown(c.fd, SHUT_RDWR); // Also ends the reader
+            break;
+        }
+        c.pending -= frames;
+        c.changed.notify_all(); // Room for the reader
+    }
+    c.changed.notify_all();
+    lock.unlock();
+    c.running--;
+}
+
+// --- Dispatch ---
+
+void IndexServer::dispatchLoop() {
+    std::vector<Request> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queued.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            if (options.batchWindowMicros > 0 && (int)queue.size() < options.maxBatch) {
+                queued.wait_for(lock, std::chrono::microseconds(options.batchWindowMicros), [this] {
+                    return stopping || (int)queue.size() >= options.maxBatch;
+                });
+            }
+            size_t take = std::min(queue.size(), (size_t)options.maxBatch);
+            batch.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.begin() + take));
+            queue.erase(queue.begin(), queue.begin() + take);
+        }
+        if (batch.empty()) continue;
+        answer(batch);
+        requests += batch.size();
+        batches++;
+        batch.clear();
+    }
+}
+
+/**
+ * answer:
+ * Runs all searches of the batch through one searchBatchSorted() call and
+ * the other ops one by one, then hands one buffer per connection to its
+ * writer. Never blocks on a socket.
+ */
+void IndexServer::answer(std::vector<Request> &batch) {
+    std::vector<std::string> searches;
+    std::vector<size_t> searchIndex;
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (batch[i].op == (uint8_t)Op::Search) {
+            searches.push_back(batch[i].pattern);
+            searchIndex.push_back(i);
+        }
+    }
+    std::vector<bool> found = tree.searchBatchSorted(searches);
+    std::vector<int8_t> searchResult(batch.size(), -1);
+    for (size_t k = 0; k < searchIndex.size(); k++) searchResult[searchIndex[k]] = found[k];
+
+    std::unordered_map<Connection*, std::pair<std::string, int>> out;
+    for (size_t i = 0; i < batch.size(); i++) {
+        Request &r = batch[i];
+        std::string body;
+        put<uint32_t>(body, r.id);
+        switch ((Op)r.op) {
+        case Op::Search:
+            put<uint8_t>(body, (uint8_t)Status::Ok);
+            put<uint8_t>(body, searchResult[i]);
+            break;
+        case Op::Count:
+            put<uint8_t>(body, (uint8_t)Status::Ok);
+            put<int64_t>(body, tree.count(r.pattern));
+            break;
+        case Op::FindAll: {
+            // Counted first, so an oversized answer is never materialized
+            if ((uint32_t)tree.count(r.pattern) > options.maxFindAll) {
+                put<uint8_t>(body, (uint8_t)Status::BadRequest);
+                break;
+            }
+            std::vector<int> positions = tree.findAll(r.pattern);
+            std::sort(positions.begin(), positions.end());
+            put<uint8_t>(body, (uint8_t)Status::Ok);
+            put<uint32_t>(body, positions.size());
+            for (int p : positions) put<int64_t>(body, p);
+            break;
+        }
+        default:
+            put<uint8_t>(body, (uint8_t)Status::BadRequest);
+        }
+        auto &[buffer, frames] = out[r.connection.get()];
+        put<uint32_t>(buffer, body.size());
+        buffer += body;
+        frames++;
+    }
+
+    for (auto &[connection, answers] : out) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->failed) continue; // A gone client just loses its answers
+        connection->outbox += answers.first;
+        connection->outboxFrames += answers.second;
+        connection->changed.notify_all();
+    }
+}
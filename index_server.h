@@ -0,0 +1,124 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef INDEX_SERVER_H
+#define INDEX_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "index_protocol.h"
+#include "suffixtree.h"
+
+struct IndexServerOptions {
+    std::string socketPath;        // UNIX socket to listen on (replaced if present)
+    int maxBatch = 256;            // Requests handled per dispatch
+    int batchWindowMicros = 0;     // Extra wait for a batch to fill (0: take what is queued)
+    int dispatchers = 0;           // Query threads, <= 0 for hardware concurrency
+    int maxPendingPerConnection = 1024; // Unanswered requests before a connection
+                                        // is no longer read from
+    uint32_t maxFindAll = IndexProtocol::MAX_FIND_ALL; // Larger answers get BadRequest
+};
+
+struct IndexServerStats {
+    int64_t requests = 0;
+    int64_t batches = 0;
+    int64_t connections = 0;
+};
+
+/**
+ * IndexServer: serves search/count/findAll on one SuffixTree over a UNIX
+ * socket using the protocol in index_protocol.h.
+ *
+ * One reader thread per connection decodes requests into a shared queue.
+ * Dispatcher threads drain the queue in batches: the searches of a batch
+ * go through searchBatchSorted() together, whatever connection they came
+ * from, and each connection's responses are appended to its outbox. While
+ * a batch runs, new requests pile up, so batches grow with load without
+ * adding latency when the server is idle.
+ *
+ * A writer thread per connection sends its outbox, so dispatchers never
+ * wait on a socket. A client that pipelines requests without reading the
+ * answers only stalls itself: once it has maxPendingPerConnection
+ * requests unanswered (or a frame's worth of unsent bytes), its reader
+ * stops taking requests until the writer catches up.
+ *
+ * The tree must not be modified while the server runs.
+ */
+class IndexServer {
+public:
+    IndexServer(SuffixTree &tree, const IndexServerOptions &options);
+    ~IndexServer();
+
+    IndexServer(const IndexServer&) = delete;
+    IndexServer& operator=(const IndexServer&) = delete;
+
+    // Binds the socket and starts serving; throws std::runtime_error
+    void start();
+
+    // Closes the socket and every connection, then joins all threads
+    void stop();
+
+    IndexServerStats stats() const;
+
+private:
+    // Closed by its last owner (connection list or a queued request)
+    struct Connection {
+        ~Connection() { ::close(fd); }
+        int fd;
+        std::thread reader;
+        std::thread writer;
+        std::atomic<int> running{2};  // Reader and writer threads not yet done
+
+        std::mutex mutex;             // Guards the fields below
+        std::condition_variable changed;
+        std::string outbox;           // Response frames not yet sent
+        int outboxFrames = 0;
+        int pending = 0;              // Requests read but not yet sent back
+        bool readerDone = false;
+        bool failed = false;          // Write error or stop(): drop answers
+    };
+
+    struct Request {
+        std::shared_ptr<Connection> connection;
+        uint32_t id;
+        uint8_t op;
+        std::string pattern;
+    };
+
+    SuffixTree &tree;
+    IndexServerOptions options;
+    int listenFd = -1;
+    std::thread acceptor;
+    std::vector<std::thread> dispatchers;
+
+    std::mutex connectionMutex;
+    std::vector<std::shared_ptr<Connection>> connections;
+
+    std::mutex queueMutex;
+    std::condition_variable queued;
+    std::deque<Request> queue;
+    bool stopping = false;
+
+    std::atomic<int64_t> requests{0};
+    std::atomic<int64_t> batches{0};
+    std::atomic<int64_t> accepted{0};
+
+    void acceptLoop();
+    void readLoop(std::shared_ptr<Connection> connection);
+    void writeLoop(std::shared_ptr<Connection> connection);
+    void dispatchLoop();
+    void answer(std::vector<Request> &batch);
+};
+
+#endif // INDEX_SERVER_H
@@ -0,0 +1,338 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "lsm_index.h"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+LsmSuffixIndex::LsmSuffixIndex(const LsmOptions &opts) : options(opts), live(std::make_unique<SuffixTree>()) {
+    if (options.liveLimit < 1 || options.mergeFactor < 2 || options.maxPerLevel < options.mergeFactor) {
+        throw std::invalid_argument("LsmSuffixIndex: liveLimit must be >= 1, mergeFactor >= 2 and "
+                                    "maxPerLevel >= mergeFactor");
+    }
+    // Segment positions are int inside each tree
+    options.maxSegment = std::min<int64_t>(options.maxSegment, INT_MAX - 1);
+    options.liveLimit = std::min(options.liveLimit, options.maxSegment);
+    if (options.background) compactor = std::thread([this] { compactorLoop(); });
+}
+
+LsmSuffixIndex::~LsmSuffixIndex() {
+    if (compactor.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        compactor.join();
+    }
+}
+
+// --- Ingest ---
+
+/**
+ * append:
+ * Feeds the live tree, freezing it each time it reaches liveLimit bytes,
+ * so a large chunk becomes several level-0 segments of equal size.
+ */
+void LsmSuffixIndex::append(std::string_view chunk) {
+    if (chunk.find('$') != std::string_view::npos) {
+        throw std::invalid_argument("LsmSuffixIndex: '$' is reserved as the segment terminator");
+    }
+    while (!chunk.empty()) {
+        bool froze = false;
+        {
+            std::lock_guard<std::mutex> lock(liveMutex);
+            int64_t room = options.liveLimit - (int64_t)live->getText().size();
+            size_t take = std::min<int64_t>(room, chunk.size());
+            live->append(chunk.substr(0, take));
+            chunk.remove_prefix(take);
+            if ((int64_t)live->getText().size() >= options.liveLimit) froze = freezeLive();
+        }
+        if (froze) scheduleCompaction();
+    }
+}
+
+void LsmSuffixIndex::flush() {
+    bool froze;
+    {
+        std::lock_guard<std::mutex> lock(liveMutex);
+        froze = freezeLive();
+    }
+    if (froze) scheduleCompaction();
+}
+
+bool LsmSuffixIndex::freezeLive() {
+    int64_t length = live->getText().size();
+    if (length == 0) return false;
+
+    live->finish();
+    auto segment = std::make_shared<Segment>();
+    segment->base = liveBase;
+    segment->length = length;
+    segment->level = 0;
+    segment->tree = std::move(live);
+    live = std::make_unique<SuffixTree>();
+    liveBase += length;
+    freezes++;
+
+    std::unique_lock<std::shared_mutex> lock(segmentMutex);
+    frozen.push_back(std::move(segment));
+    return true;
+}
+
+// --- Compaction ---
+
+/**
+ * scheduleCompaction:
+ * Wakes the compactor after a freeze. If it has left a level with more
+ * than maxPerLevel segments (at nice 19 under sustained ingest it may
+ * never run), the calling thread merges runs of that level until it is
+ * back under the limit, lowest level first, which throttles append() to
+ * the merge rate.
+ */
+void LsmSuffixIndex::scheduleCompaction() {
+    if (!options.background) {
+        compact();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        work = true;
+    }
+    wake.notify_one();
+
+    for (int level = 0;; level++) {
+        std::vector<int> sizes = levelSizes();
+        if (level >= (int)sizes.size()) break;
+        if (sizes[level] > options.maxPerLevel && mergeOnce(level)) {
+            inlineMerges++;
+            level--; // Check the same level again
+        }
+    }
+}
+
+// Number of frozen segments on each level
+std::vector<int> LsmSuffixIndex::levelSizes() const {
+    std::shared_lock<std::shared_mutex> lock(segmentMutex);
+    std::vector<int> sizes;
+    for (auto &segment : frozen) {
+        if (segment->level >= (int)sizes.size()) sizes.resize(segment->level + 1);
+        sizes[segment->level]++;
+    }
+    return sizes;
+}
+
+void LsmSuffixIndex::compact() {
+    while (mergeOnce()) {}
+}
+
+void LsmSuffixIndex::compactorLoop() {
+#if defined(__linux__)
+    // Linux applies nice values per thread: only merges are deprioritized
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), options.compactorNice);
+#endif
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (true) {
+        wake.wait(lock, [this] { return work || stopping; });
+        if (stopping) return;
+        work = false;
+        lock.unlock();
+        compact();
+        lock.lock();
+    }
+}
+
+/**
+ * mergeOnce:
+ * Picks the first run of mergeFactor adjacent segments on one level (on
+ * 'level' if it is not negative) whose total fits maxSegment and rebuilds
+ * their concatenation as one segment of the next level. The build runs without holding segmentMutex; only this
+ * function removes segments, so the run is still in place for the swap.
+ */
+bool LsmSuffixIndex::mergeOnce(int level) {
+    std::lock_guard<std::mutex> merging(compactMutex);
+    SegmentList run;
+    {
+        std::shared_lock<std::shared_mutex> lock(segmentMutex);
+        for (size_t i = 0; i + options.mergeFactor <= frozen.size() && run.empty(); i++) {
+            if (level >= 0 && frozen[i]->level != level) continue;
+            int64_t total = 0;
+            size_t j = i;
+            while (j < i + options.mergeFactor && frozen[j]->level == frozen[i]->level) {
+                total += frozen[j++]->length;
+            }
+            if (j == i + options.mergeFactor && total <= options.maxSegment) {
+                run.assign(frozen.begin() + i, frozen.begin() + j);
+            }
+        }
+    }
+    if (run.empty()) return false;
+
+    auto merged = std::make_shared<Segment>();
+    merged->base = run.front()->base;
+    merged->length = 0;
+    merged->level = run.front()->level + 1;
+    for (auto &segment : run) merged->length += segment->length;
+    std::string text;
+    text.reserve(merged->length + 1);
+    for (auto &segment : run) text.append(segment->text());
+    merged->tree = std::make_unique<SuffixTree>(std::move(text));
+
+    int64_t length = merged->length;
+    {
+        std::unique_lock<std::shared_mutex> lock(segmentMutex);
+        auto first = std::find(frozen.begin(), frozen.end(), run.front());
+        first = frozen.erase(first, first + run.size());
+        frozen.insert(first, std::move(merged));
+    }
+    merges++;
+    bytesMerged += length;
+    return true;
+}
+
+// --- Queries ---
+
+/**
+ * takeSnapshot:
+ * Answers the live tree under liveMutex and copies the frozen list while
+ * still holding it, so no segment frozen in between is seen twice or
+ * missed. Merges replace segments by one covering the same range, so the
+ * copy stays valid without further locking. The pending suffixes are
+ * copied and scanned after the lock is released, so ingest waits only
+ * for the tree query and a memcpy.
+ */
+LsmSuffixIndex::Snapshot LsmSuffixIndex::takeSnapshot(const std::string &pattern, Mode mode) {
+    Snapshot snap;
+    int64_t m = pattern.size();
+    std::string pending;     // Text of the suffixes without a leaf yet
+    int64_t pendingBase;
+    {
+        std::lock_guard<std::mutex> lock(liveMutex);
+        {
+            std::shared_lock<std::shared_mutex> segments(segmentMutex);
+            snap.frozen = frozen;
+        }
+
+        std::string_view text = live->getText();
+        snap.liveHead = std::string(text.substr(0, m - 1));
+
+        // An open tree sees every substring, but its last getPendingSuffixes()
+        // suffixes have no leaf yet: those are checked directly below
+        if (mode == Mode::Search) {
+            snap.liveCount = live->search(pattern);
+            return snap;
+        }
+        if (mode == Mode::Count) {
+            snap.liveCount = live->count(pattern);
+        } else {
+            for (int p : live->findAll(pattern)) snap.livePositions.push_back(liveBase + p);
+        }
+        int64_t pendingStart = std::max<int64_t>((int64_t)text.size() - live->getPendingSuffixes(), 0);
+        pending = std::string(text.substr(pendingStart));
+        pendingBase = liveBase + pendingStart;
+    }
+
+    for (size_t p = pending.find(pattern); p != std::string::npos; p = pending.find(pattern, p + 1)) {
+        if (mode == Mode::Count) snap.liveCount++;
+        else snap.livePositions.push_back(pendingBase + (int64_t)p);
+    }
+    return snap;
+}
+
+/**
+ * scanBoundaries:
+ * A match crossing the end b of segment k starts in [b-m+1, b) and ends
+ * before b+m-1, possibly beyond several short segments. Each is reported
+ * once, at the end of the segment it starts in.
+ */
+template <typename Visit>
+void LsmSuffixIndex::scanBoundaries(const Snapshot &snap, const std::string &pattern, Visit visit) {
+    int64_t m = pattern.size();
+    if (m < 2) return;
+
+    std::string window;
+    for (size_t k = 0; k < snap.frozen.size(); k++) {
+        const Segment &segment = *snap.frozen[k];
+        int64_t end = segment.base + segment.length;
+        int64_t start = std::max(segment.base, end - (m - 1));
+        size_t need = (end - start) + m - 1;
+
+        window.assign(segment.text().substr(start - segment.base));
+        for (size_t j = k + 1; j < snap.frozen.size() && window.size() < need; j++) {
+            window.append(snap.frozen[j]->text().substr(0, need - window.size()));
+        }
+        if (window.size() < need) window.append(snap.liveHead, 0, need - window.size());
+
+        for (size_t at = window.find(pattern); at != std::string::npos && (int64_t)at < end - start;
+             at = window.find(pattern, at + 1)) {
+            if (!visit(start + (int64_t)at)) return;
+        }
+    }
+}
+
+bool LsmSuffixIndex::acceptsPattern(const std::string &pattern) {
+    return !pattern.empty() && pattern.find('$') == std::string::npos;
+}
+
+bool LsmSuffixIndex::search(const std::string &pattern) {
+    if (!acceptsPattern(pattern)) return false;
+    Snapshot snap = takeSnapshot(pattern, Mode::Search);
+    if (snap.liveCount) return true;
+
+    for (auto &segment : snap.frozen) {
+        if (segment->tree->search(pattern)) return true;
+    }
+    bool found = false;
+    scanBoundaries(snap, pattern, [&](int64_t) { found = true; return false; });
+    return found;
+}
+
+int64_t LsmSuffixIndex::count(const std::string &pattern) {
+    if (!acceptsPattern(pattern)) return 0;
+    Snapshot snap = takeSnapshot(pattern, Mode::Count);
+    int64_t total = snap.liveCount;
+
+    for (auto &segment : snap.frozen) total += segment->tree->count(pattern);
+    scanBoundaries(snap, pattern, [&](int64_t) { total++; return true; });
+    return total;
+}
+
+std::vector<int64_t> LsmSuffixIndex::findAll(const std::string &pattern) {
+    if (!acceptsPattern(pattern)) return {};
+    Snapshot snap = takeSnapshot(pattern, Mode::FindAll);
+    std::vector<int64_t> positions = std::move(snap.livePositions);
+
+    for (auto &segment : snap.frozen) {
+        for (int p : segment->tree->findAll(pattern)) positions.push_back(segment->base + p);
+    }
+    scanBoundaries(snap, pattern, [&](int64_t p) { positions.push_back(p); return true; });
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+LsmStats LsmSuffixIndex::stats() const {
+    LsmStats s;
+    {
+        std::lock_guard<std::mutex> lock(liveMutex);
+        s.size = liveBase + live->getText().size();
+        s.freezes = freezes;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(segmentMutex);
+        s.frozenSegments = frozen.size();
+    }
+    s.merges = merges;
+    s.bytesMerged = bytesMerged;
+    s.inlineMerges = inlineMerges;
+    return s;
+}
@@ -0,0 +1,148 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef LSM_INDEX_H
+#define LSM_INDEX_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "suffixtree.h"
+
+struct LsmOptions {
+    int64_t liveLimit = 1 << 20;      // Freeze the live tree at this many bytes
+    int mergeFactor = 4;              // Merge this many same-level segments
+    int64_t maxSegment = 1 << 30;     // Never build a merged segment larger than this
+    bool background = true;           // Compact on a background thread (else inline)
+    int maxPerLevel = 8;              // Segments a level may hold while the compactor lags;
+                                      // past this, append() merges the level itself
+    int compactorNice = 19;           // Linux: nice value of the compactor thread, so
+                                      // merges yield the CPU to ingest and queries
+};
+
+struct LsmStats {
+    int64_t size = 0;             // Bytes ingested
+    int frozenSegments = 0;
+    int64_t freezes = 0;
+    int64_t merges = 0;
+    int64_t bytesMerged = 0;      // Bytes rebuilt by compaction
+    int64_t inlineMerges = 0;     // Merges run by append() because a level was full
+};
+
+/**
+ * LsmSuffixIndex: one growing text indexed as a small live SuffixTree that
+ * receives appends plus a list of immutable frozen trees, in the style of
+ * a log-structured merge tree.
+ *
+ * When the live tree reaches liveLimit bytes it is finished and frozen in
+ * O(1). A compactor merges runs of mergeFactor frozen segments of the same
+ * level into one segment of the next level, rebuilding the merged text
+ * in one pass of the constructor outside any lock, then swaps it in. Appends
+ * touch only the live tree and do not wait for the compactor, unless it
+ * has fallen behind: once a level holds more than maxPerLevel segments,
+ * the append that froze the last one merges that level itself. Ingest is
+ * then throttled to the merge rate, and a query walks at most
+ * maxPerLevel segments per level, O(maxPerLevel * log(size / liveLimit)).
+ *
+ * Queries see a consistent snapshot: the live tree is queried under its
+ * lock and frozen segments without one. Matches that span segment
+ * boundaries are found by scanning a window of 2(m-1) bytes around each
+ * boundary. Positions are offsets in the whole ingested text.
+ */
+class LsmSuffixIndex {
+public:
+    explicit LsmSuffixIndex(const LsmOptions &options = LsmOptions());
+    ~LsmSuffixIndex();
+
+    LsmSuffixIndex(const LsmSuffixIndex&) = delete;
+    LsmSuffixIndex& operator=(const LsmSuffixIndex&) = delete;
+
+    // '$' terminates each segment's tree, so chunks must not contain it
+    // (std::invalid_argument); patterns containing it match nothing
+    void append(std::string_view chunk);
+
+    // Freezes the live tree now (no-op if it is empty)
+    void flush();
+
+    // Runs merges until no run qualifies (background compactions included)
+    void compact();
+
+    bool search(const std::string &pattern);
+    int64_t count(const std::string &pattern);
+
+    // Sorted start positions of every occurrence
+    std::vector<int64_t> findAll(const std::string &pattern);
+
+    LsmStats stats() const;
+
+private:
+    struct Segment {
+        int64_t base;          // Global position of the first byte
+        int64_t length;        // Bytes, without the terminator
+        int level;             // 0 for frozen live trees, +1 per merge
+        std::unique_ptr<SuffixTree> tree;
+
+        std::string_view text() const { return tree->getText().substr(0, length); }
+    };
+    using SegmentList = std::vector<std::shared_ptr<const Segment>>;
+
+    enum class Mode { Search, Count, FindAll };
+
+    // What a query sees: frozen segments, the live tree's answer and the
+    // live tree's first bytes (for windows crossing into it)
+    struct Snapshot {
+        SegmentList frozen;
+        std::string liveHead;
+        int64_t liveCount = 0;               // Search: 0/1, Count: occurrences
+        std::vector<int64_t> livePositions;  // FindAll only
+    };
+
+    LsmOptions options;
+
+    mutable std::mutex liveMutex;   // live, liveBase, counters
+    std::unique_ptr<SuffixTree> live;
+    int64_t liveBase = 0;
+    int64_t freezes = 0;
+
+    mutable std::shared_mutex segmentMutex;  // frozen (writers: freeze, merge swap)
+    SegmentList frozen;
+
+    std::mutex compactMutex;        // One merge at a time
+    std::atomic<int64_t> merges{0};
+    std::atomic<int64_t> bytesMerged{0};
+    std::atomic<int64_t> inlineMerges{0};
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    bool work = false;
+    std::thread compactor;
+
+    bool freezeLive();                  // Caller holds liveMutex
+    void scheduleCompaction();
+    std::vector<int> levelSizes() const;
+    bool mergeOnce(int level = -1);             // level < 0: any level
+    void compactorLoop();
+
+    Snapshot takeSnapshot(const std::string &pattern, Mode mode);
+
+    static bool acceptsPattern(const std::string &pattern);
+
+    // Calls visit(pos) for each match starting in one segment and ending
+    // in a later one; stops early when visit returns false
+    template <typename Visit>
+    static void scanBoundaries(const Snapshot &snap, const std::string &pattern, Visit visit);
+};
+
+#endif // LSM_INDEX_H
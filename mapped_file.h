@@ -0,0 +1,67 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Header-only read-only memory mapping of a whole file (POSIX mmap), used
+ * to index and print from large inputs without reading them into memory.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile {
+public:
+    // Maps 'path' read-only; throws std::runtime_error on failure
+    explicit MappedFile(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) < 0) {
+            if (fd >= 0) ::close(fd);
+            throw std::runtime_error("MappedFile: cannot open " + path + ": " + std::strerror(errno));
+        }
+        length = st.st_size;
+        if (length > 0) {
+            void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("MappedFile: cannot map " + path + ": " + std::strerror(errno));
+            }
+            bytes = static_cast<const char*>(p);
+        }
+        ::close(fd); // The mapping stays valid
+    }
+
+    ~MappedFile() {
+        if (bytes) ::munmap(const_cast<char*>(bytes), length);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Hints the kernel about the coming access pattern (MADV_SEQUENTIAL etc.)
+    void advise(int advice) const {
+        if (bytes) ::madvise(const_cast<char*>(bytes), length, advice);
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(bytes ? bytes : "", length); }
+
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+};
+
+#endif // MAPPED_FILE_H
@@ -9,7 +9,10 @@ PYBIND11_MODULE(pyukkonen, m) {
 
     py::class_<SuffixTree>(m, "SuffixTree")
         .def(py::init<std::string>(), "Initialize with text (automatically appends $ if missing)")
+        .def(py::init<std::string, bool>(), py::arg("text"), py::arg("case_insensitive") = false,
+             "Initialize with text; case_insensitive folds ASCII case at index time and in queries")
         .def("search", &SuffixTree::search, "Check if pattern exists in text")
         .def("print_tree", &SuffixTree::printTree, "Print tree structure to stdout")
-        .def("get_text", &SuffixTree::getText, "Get the original text");
+        .def("get_text", &SuffixTree::getText, "Get the indexed (folded) text")
+        .def("is_case_insensitive", &SuffixTree::isCaseInsensitive, "Whether the tree folds ASCII case");
 }
\ No newline at end of file
@@ -0,0 +1,118 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Header-only byte mapping applied to text at index time and to queries,
+ * e.g. ASCII case folding. Every byte maps to exactly one byte, so
+ * positions in the folded text are positions in the original text.
+ */
+
+#ifndef BYTE_FOLDING_H
+#define BYTE_FOLDING_H
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+class ByteFolding {
+public:
+    // Identity mapping (no folding)
+    ByteFolding() : kind(Kind::Identity) {
+        for (int c = 0; c < 256; c++) table[c] = (uint8_t)c;
+    }
+
+    // 'A'-'Z' -> 'a'-'z', all other bytes unchanged
+    static ByteFolding asciiCaseFold() {
+        ByteFolding f;
+        for (int c = 'A'; c <= 'Z'; c++) f.table[c] = (uint8_t)(c + 32);
+        f.kind = Kind::AsciiLower;
+        return f;
+    }
+
+    // Arbitrary user-supplied byte -> byte mapping
+    static ByteFolding fromTable(const std::array<uint8_t, 256> &mapping) {
+        ByteFolding f;
+        f.table = mapping;
+        f.kind = Kind::Table;
+        return f;
+    }
+
+    bool isIdentity() const { return kind == Kind::Identity; }
+    const std::array<uint8_t, 256>& getTable() const { return table; }
+
+    char fold(char c) const { return (char)table[(uint8_t)c]; }
+
+    /**
+     * @brief Bulk transform of n bytes ('in' may equal 'out').
+     * ASCII case folding runs 16 bytes per step with SSE2 / NEON; custom
+     * tables use an unrolled lookup loop.
+     */
+    void apply(const char *in, char *out, size_t n) const {
+        if (kind == Kind::Identity) {
+            if (in != out) std::copy(in, in + n, out);
+            return;
+        }
+
+        size_t i = 0;
+        if (kind == Kind::AsciiLower) {
+#if defined(__SSE2__)
+            const __m128i upperA = _mm_set1_epi8('A' - 1);
+            const __m128i upperZ = _mm_set1_epi8('Z' + 1);
+            const __m128i caseBit = _mm_set1_epi8(0x20);
+            for (; i + 16 <= n; i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+                // Signed compares: bytes >= 0x80 are negative, hence never in range
+                __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi8(v, upperA), _mm_cmplt_epi8(v, upperZ));
+                v = _mm_add_epi8(v, _mm_and_si128(isUpper, caseBit));
+                _mm_storeu_si128((__m128i*)(out + i), v);
+            }
+#elif defined(__ARM_NEON)
+            const uint8x16_t upperA = vdupq_n_u8('A');
+            const uint8x16_t upperZ = vdupq_n_u8('Z');
+            const uint8x16_t caseBit = vdupq_n_u8(0x20);
+            for (; i + 16 <= n; i += 16) {
+                uint8x16_t v = vld1q_u8((const uint8_t*)(in + i));
+                uint8x16_t isUpper = vandq_u8(vcgeq_u8(v, upperA), vcleq_u8(v, upperZ));
+                v = vaddq_u8(v, vandq_u8(isUpper, caseBit));
+                vst1q_u8((uint8_t*)(out + i), v);
+            }
+#endif
+        } else {
+            for (; i + 8 <= n; i += 8) {
+                out[i + 0] = fold(in[i + 0]);
+                out[i + 1] = fold(in[i + 1]);
+                out[i + 2] = fold(in[i + 2]);
+                out[i + 3] = fold(in[i + 3]);
+                out[i + 4] = fold(in[i + 4]);
+                out[i + 5] = fold(in[i + 5]);
+                out[i + 6] = fold(in[i + 6]);
+                out[i + 7] = fold(in[i + 7]);
+            }
+        }
+        // Scalar tail
+        for (; i < n; i++) out[i] = fold(in[i]);
+    }
+
+    // In-place transform of a whole string
+    void apply(std::string &s) const {
+        apply(s.data(), s.data(), s.size());
+    }
+
+private:
+    enum class Kind { Identity, AsciiLower, Table };
+
+    std::array<uint8_t, 256> table;
+    Kind kind;
+};
+
+#endif // BYTE_FOLDING_H
@@ -19,6 +19,7 @@
 #include <string>
 #include <map>
 #include <vector>
+#include "byte_folding.h"
 
 class SuffixTree {
 public:
@@ -44,6 +45,14 @@ public:
      */
     SuffixTree(std::string t);
 
+    /**
+     * @brief Construct a Suffix Tree over case-folded text.
+     * * @param caseInsensitive If true, ASCII letters are folded to lower case
+     * at index time and every query is folded the same way. Positions are
+     * unchanged because folding is byte-for-byte.
+     */
+    SuffixTree(std::string t, bool caseInsensitive);
+
     /**
      * @brief Destroy the Suffix Tree object and clean up memory.
      */
@@ -66,9 +75,15 @@ public:
      */
     std::string getText() const { return text; }
 
+    /**
+     * @brief Whether the tree was built with case folding.
+     */
+    bool isCaseInsensitive() const { return !folding.isIdentity(); }
+
 private:
     std::string text;
     int size;
+    ByteFolding folding;
     
     Node *root;
     Node *activeNode;
@@ -85,7 +100,7 @@ private:
 
     // --- Helper Functions ---
     Node* newNode(int start, int *end);
-    void freeSuffixTreeByPostOrder(Node *n);
+    void freeSubtree(Node *n);
     int edgeLength(Node *n);
     bool walkDown(Node *n);
     void extend(int pos);
@@ -99,7 +114,14 @@ private:
 // Implementation Details
 // =========================================================
 
-inline SuffixTree::SuffixTree(std::string t) : text(t) {
+inline SuffixTree::SuffixTree(std::string t) : SuffixTree(std::move(t), false) {}
+
+inline SuffixTree::SuffixTree(std::string t, bool caseInsensitive) : text(std::move(t)) {
+    if (caseInsensitive) {
+        folding = ByteFolding::asciiCaseFold();
+        folding.apply(text);
+    }
+
     // Ideally, append '$' if not present for proper suffix counting.
     if (text.empty() || text.back() != '$') {
         text += "$";
@@ -127,7 +149,7 @@ inline SuffixTree::SuffixTree(std::string t) : text(t) {
 }
 
 inline SuffixTree::~SuffixTree() {
-    freeSuffixTreeByPostOrder(root);
+    freeSubtree(root);
     delete rootEnd;
 }
 
@@ -137,15 +159,22 @@ inline SuffixTree::Node* SuffixTree::newNode(int start, int *end) {
     return node;
 }
 
-inline void SuffixTree::freeSuffixTreeByPostOrder(Node *n) {
-    if (!n) return;
-    for (auto const& [key, child] : n->children) {
-        freeSuffixTreeByPostOrder(child);
-    }
-    if (n->end != &leafEnd && n->end != rootEnd) {
-        delete n->end; // Delete allocated int for internal nodes
+inline void SuffixTree::freeSubtree(Node *n) {
+    // Explicit stack: the tree height reaches the text length on repetitive
+    // input, which would overflow the call stack if this recursed
+    std::vector<Node*> stack;
+    if (n) stack.push_back(n);
+    while (!stack.empty()) {
+        Node *cur = stack.back();
+        stack.pop_back();
+        for (auto const& [key, child] : cur->children) {
+            stack.push_back(child);
+        }
+        if (cur->end != &leafEnd && cur->end != rootEnd) {
+            delete cur->end;
+        }
+        delete cur;
     }
-    delete n;
 }
 
 inline int SuffixTree::edgeLength(Node *n) {
@@ -291,6 +320,7 @@ inline void SuffixTree::printRecursive(Node *n, int depth) {
 
 inline bool SuffixTree::search(std::string pattern) {
     if (pattern.empty()) return true;
+    folding.apply(pattern);
     return searchRecursive(root, pattern, 0);
 }
 
@@ -0,0 +1,151 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Header-only blocked Bloom filter over the q-grams of a text, used to
+ * reject absent patterns before walking the tree.
+ */
+
+#ifndef QGRAM_FILTER_H
+#define QGRAM_FILTER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * QGramFilter: every substring of length q of the text is inserted into a
+ * blocked Bloom filter. A pattern with a q-gram the filter has never seen
+ * cannot occur in the text, so mayContain() == false is exact while true
+ * may be a false positive. Each q-gram sets K bits inside one 64-byte
+ * block, so a test costs a single cache miss.
+ */
+class QGramFilter {
+public:
+    // 1 <= q <= 8: a q-gram is read as one 64-bit word
+    explicit QGramFilter(int q = 8, int bitsPerGram = 12)
+        : q(q < 1 ? 1 : (q > 8 ? 8 : q)), bitsPerGram(bitsPerGram < 4 ? 4 : bitsPerGram),
+          grams(0), capacity(0), blockShift(64) {}
+
+    // Sizes the filter for the text's q-grams and inserts all of them
+    void build(const char *text, size_t n) {
+        size_t count = n >= (size_t)q ? n - q + 1 : 0;
+        size_t blocks = 1;
+        while (blocks * BLOCK_BITS < count * bitsPerGram) blocks <<= 1;
+        words.assign(blocks * WORDS_PER_BLOCK, 0);
+        blockShift = 64 - __builtin_ctzll(blocks);
+        capacity = blocks * BLOCK_BITS / bitsPerGram;
+        grams = 0;
+        add(text, 0, n);
+    }
+
+    // Inserts the q-grams starting at 'from' or later of text[0, n)
+    void add(const char *text, size_t from, size_t n) {
+        for (size_t i = from; i + q <= n; i++) {
+            insertHash(hashGram(text + i));
+            grams++;
+        }
+    }
+
+    // The text grew past the size the filter was built for
+    bool needsRebuild() const { return grams > 2 * capacity; }
+
+    // false: 'pattern' is certainly absent. Patterns shorter than q pass.
+    bool mayContain(const char *pattern, size_t m) const {
+        if (words.empty()) return true;
+        for (size_t i = 0; i + q <= m; i++) {
+            if (!testHash(hashGram(pattern + i))) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief mayContain() for many patterns. Hashes are computed for a
+     * window of q-grams and their blocks prefetched before any is tested,
+     * so the cache misses of different patterns overlap instead of being
+     * paid one after another.
+     */
+    void mayContainBatch(const std::vector<std::string> &patterns, std::vector<char> &out) const {
+        out.assign(patterns.size(), 1);
+        if (words.empty()) return;
+
+        constexpr size_t WINDOW = 32;
+        uint64_t hashes[WINDOW];
+        uint32_t owners[WINDOW];
+        size_t pending = 0;
+
+        auto flush = [&]() {
+            for (size_t j = 0; j < pending; j++) {
+                if (out[owners[j]] && !testHash(hashes[j])) out[owners[j]] = 0;
+            }
+            pending = 0;
+        };
+
+        for (size_t p = 0; p < patterns.size(); p++) {
+            const std::string &pattern = patterns[p];
+            for (size_t i = 0; i + q <= pattern.size(); i++) {
+                uint64_t h = hashGram(pattern.data() + i);
+                __builtin_prefetch(block(h));
+                hashes[pending] = h;
+                owners[pending] = (uint32_t)p;
+                if (++pending == WINDOW) flush();
+            }
+        }
+        flush();
+    }
+
+    int getQ() const { return q; }
+    size_t memoryBytes() const { return words.size() * sizeof(uint64_t); }
+
+private:
+    static constexpr size_t BLOCK_BITS = 512;
+    static constexpr size_t WORDS_PER_BLOCK = BLOCK_BITS / 64;
+    static constexpr int K = 6; // Bits per q-gram, 9 hash bits each
+
+    int q;
+    int bitsPerGram;
+    size_t grams;      // q-grams inserted
+    size_t capacity;   // q-grams the filter was sized for
+    int blockShift;    // Top bits of the hash select the block
+    std::vector<uint64_t> words;
+
+    uint64_t hashGram(const char *p) const {
+        uint64_t x = 0;
+        std::memcpy(&x, p, q);
+        // Murmur3 finalizer: every input bit affects every output bit
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    const uint64_t* block(uint64_t h) const {
+        // Remix so the block index is independent of the low bits used below
+        size_t b = blockShift == 64 ? 0 : (size_t)((h * 0x9E3779B97F4A7C15ULL) >> blockShift);
+        return words.data() + b * WORDS_PER_BLOCK;
+    }
+
+    void insertHash(uint64_t h) {
+        uint64_t *w = const_cast<uint64_t*>(block(h));
+        for (int k = 0; k < K; k++) {
+            unsigned bit = (h >> (9 * k)) & 511;
+            w[bit >> 6] |= 1ULL << (bit & 63);
+        }
+    }
+
+    bool testHash(uint64_t h) const {
+        const uint64_t *w = block(h);
+        for (int k = 0; k < K; k++) {
+            unsigned bit = (h >> (9 * k)) & 511;
+            if (!(w[bit >> 6] & (1ULL << (bit & 63)))) return false;
+        }
+        return true;
+    }
+};
+
+#endif // QGRAM_FILTER_H
@@ -0,0 +1,141 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "query_cache.h"
+#include <functional>
+#include <mutex>
+
+QueryCache::QueryCache(size_t maxBytes, int shardCount) {
+    size_t n = 1;
+    while ((int)n < shardCount) n <<= 1;
+    shards.reserve(n);
+    for (size_t i = 0; i < n; i++) shards.push_back(std::make_unique<Shard>());
+    shardMask = n - 1;
+    shardBytes = maxBytes / n;
+}
+
+std::string QueryCache::makeKey(Op op, const std::string &pattern) {
+    std::string key;
+    key.reserve(pattern.size() + 1);
+    key += (char)op;
+    key += pattern;
+    return key;
+}
+
+size_t QueryCache::entryBytes(const std::string &key, const Result &result) {
+    // Entry, its key and positions, plus the index node and slot pointer
+    return sizeof(Entry) + key.size() + result.positions.size() * sizeof(int) +
+           2 * sizeof(void*) + sizeof(std::string) + sizeof(size_t);
+}
+
+QueryCache::Shard& QueryCache::shardFor(const std::string &key) {
+    return *shards[std::hash<std::string>()(key) & shardMask];
+}
+
+bool QueryCache::lookup(Op op, const std::string &pattern, Result &out, uint64_t &seen) {
+    std::string key = makeKey(op, pattern);
+    Shard &shard = shardFor(key);
+    uint64_t current = generation.load(std::memory_order_acquire);
+    seen = current;
+
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end() || shard.slots[it->second]->generation != current) {
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Entry &entry = *shard.slots[it->second];
+    entry.referenced.store(true, std::memory_order_relaxed);
+    out = entry.result;
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void QueryCache::insert(Op op, const std::string &pattern, const Result &result, uint64_t current) {
+    std::string key = makeKey(op, pattern);
+    size_t bytes = entryBytes(key, result);
+    if (bytes > shardBytes) return; // Would never fit
+    Shard &shard = shardFor(key);
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    // Computed before an invalidate(): the result may describe the old
+    // contents. (An invalidate() after this check only makes it stale.)
+    if (generation.load(std::memory_order_acquire) != current) return;
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        // Stale or inserted by a racing miss: refresh in place
+        Entry &entry = *shard.slots[it->second];
+        shard.bytes -= entry.bytes;
+        entry.result = result;
+        entry.bytes = bytes;
+        entry.generation = current;
+        shard.bytes += bytes;
+        while (shard.bytes > shardBytes) evictOne(shard);
+        return;
+    }
+
+    while (shard.bytes + bytes > shardBytes) evictOne(shard);
+
+    auto entry = std::make_unique<Entry>();
+    entry->key = key;
+    entry->generation = current;
+    entry->result = result;
+    entry->bytes = bytes;
+
+    size_t slot;
+    if (!shard.freeSlots.empty()) {
+        slot = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+        shard.slots[slot] = std::move(entry);
+    } else {
+        slot = shard.slots.size();
+        shard.slots.push_back(std::move(entry));
+    }
+    shard.index.emplace(std::move(key), slot);
+    shard.bytes += bytes;
+}
+
+/**
+ * evictOne:
+ * Advances the CLOCK hand to the first entry that is stale or has not been
+ * referenced since the hand last passed, clearing reference bits on the
+ * way, and evicts it. Caller holds the shard exclusively.
+ */
+void QueryCache::evictOne(Shard &shard) {
+    uint64_t current = generation.load(std::memory_order_relaxed);
+    for (;;) {
+        if (shard.hand >= shard.slots.size()) shard.hand = 0;
+        std::unique_ptr<Entry> &slot = shard.slots[shard.hand];
+        if (slot && slot->generation == current && slot->referenced.exchange(false, std::memory_order_relaxed)) {
+            shard.hand++;
+            continue;
+        }
+        if (slot) {
+            shard.bytes -= slot->bytes;
+            shard.index.erase(slot->key);
+            slot.reset();
+            shard.freeSlots.push_back(shard.hand);
+            shard.evictions++;
+            shard.hand++;
+            return;
+        }
+        shard.hand++;
+    }
+}
+
+QueryCacheStats QueryCache::stats() const {
+    QueryCacheStats total;
+    for (auto &shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        total.hits += shard->hits.load(std::memory_order_relaxed);
+        total.misses += shard->misses.load(std::memory_order_relaxed);
+        total.evictions += shard->evictions;
+        total.entries += shard->index.size();
+        total.bytes += shard->bytes;
+    }
+    return total;
+}
@@ -0,0 +1,102 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef QUERY_CACHE_H
+#define QUERY_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct QueryCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+/**
+ * QueryCache: results of recent queries keyed by (operation, pattern).
+ *
+ * The cache is split into shards by pattern hash. Lookups take only a
+ * shared lock on their shard, so concurrent readers never wait for each
+ * other; inserts take the shard exclusively. Each shard is bounded in
+ * bytes and evicts with CLOCK: a hit sets an atomic reference bit, and
+ * the eviction hand gives referenced entries a second chance.
+ *
+ * invalidate() is O(1): it bumps a generation counter, and entries from
+ * an older generation count as misses and are overwritten in place.
+ * lookup() reports the generation it saw and insert() takes it back, so a
+ * result computed before an invalidate() is never stored as current.
+ */
+class QueryCache {
+public:
+    enum class Op : char { Search = 's', Count = 'c', FindAll = 'f' };
+
+    struct Result {
+        int number = 0;              // search() as 0/1, or count()
+        std::vector<int> positions;  // findAll()
+    };
+
+    // 'maxBytes' is split evenly across 'shards' (rounded up to a power of two)
+    explicit QueryCache(size_t maxBytes, int shards = 16);
+
+    QueryCache(const QueryCache&) = delete;
+    QueryCache& operator=(const QueryCache&) = delete;
+
+    // 'generation' receives the generation the lookup ran under; compute a
+    // missing result after the call and pass it to insert()
+    bool lookup(Op op, const std::string &pattern, Result &out, uint64_t &generation);
+
+    // Stores 'result' unless invalidate() ran since the lookup() that
+    // returned 'generation'
+    void insert(Op op, const std::string &pattern, const Result &result, uint64_t generation);
+
+    // Drops every cached result
+    void invalidate() { generation.fetch_add(1, std::memory_order_release); }
+
+    QueryCacheStats stats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t generation;
+        Result result;
+        size_t bytes;
+        std::atomic<bool> referenced{false};
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, size_t> index;  // Key -> slot
+        std::vector<std::unique_ptr<Entry>> slots;      // Null slots are free
+        std::vector<size_t> freeSlots;
+        size_t hand = 0;                                // CLOCK hand
+        size_t bytes = 0;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        uint64_t evictions = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardMask;
+    size_t shardBytes;
+    std::atomic<uint64_t> generation{0};
+
+    static std::string makeKey(Op op, const std::string &pattern);
+    static size_t entryBytes(const std::string &key, const Result &result);
+    Shard& shardFor(const std::string &key);
+    void evictOne(Shard &shard);
+};
+
+#endif // QUERY_CACHE_H
@@ -0,0 +1,62 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "reclaimer.h"
+
+Reclaimer& Reclaimer::instance() {
+    static Reclaimer reclaimer;
+    return reclaimer;
+}
+
+Reclaimer::Reclaimer() : worker([this] { run(); }) {}
+
+Reclaimer::~Reclaimer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void Reclaimer::push(std::unique_ptr<Garbage> garbage) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(garbage));
+    }
+    wake.notify_one();
+}
+
+void Reclaimer::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) return; // Stopping, and nothing left to free
+
+        std::unique_ptr<Garbage> garbage = std::move(queue.front());
+        queue.pop_front();
+        inFlight++;
+
+        // The destructor runs unlocked so dispose() never waits for it
+        lock.unlock();
+        garbage.reset();
+        lock.lock();
+
+        inFlight--;
+        if (queue.empty() && inFlight == 0) idle.notify_all();
+    }
+}
+
+void Reclaimer::drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return queue.empty() && inFlight == 0; });
+}
+
+size_t Reclaimer::pending() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size() + inFlight;
+}
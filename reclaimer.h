@@ -0,0 +1,69 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef RECLAIMER_H
+#define RECLAIMER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+/**
+ * Reclaimer: one background thread that runs destructors. dispose() takes
+ * ownership of any movable object (an Arena, a string, a
+ * std::unique_ptr<SuffixTree>, ...) and returns at once; the object is
+ * destroyed later on the reclaimer thread, so freeing a large index never
+ * stalls the thread that dropped it.
+ *
+ * The thread starts on first use and finishes the queue at program exit.
+ */
+class Reclaimer {
+public:
+    static Reclaimer& instance();
+
+    template <typename T>
+    void dispose(T garbage) {
+        push(std::make_unique<Holder<T>>(std::move(garbage)));
+    }
+
+    // Blocks until everything disposed so far has been destroyed
+    void drain();
+
+    // Objects queued or being destroyed
+    size_t pending();
+
+private:
+    struct Garbage {
+        virtual ~Garbage() = default;
+    };
+
+    template <typename T>
+    struct Holder : Garbage {
+        explicit Holder(T &&value) : value(std::move(value)) {}
+        T value;
+    };
+
+    Reclaimer();
+    ~Reclaimer();
+
+    void push(std::unique_ptr<Garbage> garbage);
+    void run();
+
+    std::mutex mutex;
+    std::condition_variable wake;   // Signals the worker: work or stop
+    std::condition_variable idle;   // Signals drain(): queue is empty
+    std::deque<std::unique_ptr<Garbage>> queue;
+    size_t inFlight = 0;            // Popped but not yet destroyed
+    bool stopping = false;
+    std::thread worker;
+};
+
+#endif // RECLAIMER_H
@@ -0,0 +1,160 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "sequence_index.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/**
+ * findNewline:
+ * First '\n' in [p, end), or end. Compares 16 bytes per step; the scalar
+ * loop handles the tail (and, on NEON, locates the byte within the block).
+ */
+static inline const char* findNewline(const char *p, const char *end) {
+#if defined(__SSE2__)
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)p);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    for (; end - p >= 16; p += 16) {
+        if (vmaxvq_u8(vceqq_u8(vld1q_u8((const uint8_t*)p), newline))) break;
+    }
+#endif
+    while (p < end && *p != '\n') p++;
+    return p;
+}
+
+// --- SequenceReader ---
+
+SequenceReader::SequenceReader(const std::string &path) : file(path) {
+    file.advise(MADV_SEQUENTIAL);
+    pos = file.data();
+    end = pos + file.size();
+    while (pos < end && std::isspace((unsigned char)*pos)) pos++;
+    if (pos < end && *pos != '>' && *pos != '@') {
+        throw std::runtime_error("SequenceReader: " + path + " is not FASTA or FASTQ");
+    }
+    fastq = pos < end && *pos == '@';
+}
+
+std::string_view SequenceReader::nextLine() {
+    const char *newline = findNewline(pos, end);
+    std::string_view line(pos, newline - pos);
+    pos = newline < end ? newline + 1 : end;
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+bool SequenceReader::next(Record &record) {
+    record.lines.clear();
+    std::string_view header;
+    while (header.empty()) {
+        if (pos == end) return false;
+        header = nextLine(); // Blank lines between records are ignored
+    }
+    if (header[0] != (fastq ? '@' : '>')) {
+        throw std::runtime_error("SequenceReader: expected a record header, got '" + std::string(header) + "'");
+    }
+    record.name = header.substr(1);
+
+    if (!fastq) {
+        while (pos < end && *pos != '>') {
+            std::string_view line = nextLine();
+            if (!line.empty()) record.lines.push_back(line);
+        }
+        return true;
+    }
+
+    // FASTQ: sequence lines up to the '+' separator, then as many quality
+    // bytes as sequence bytes (quality lines may themselves start with '@')
+    size_t length = 0;
+    for (;;) {
+        if (pos == end) throw std::runtime_error("SequenceReader: truncated FASTQ record");
+        std::string_view line = nextLine();
+        if (!line.empty() && line[0] == '+') break;
+        record.lines.push_back(line);
+        length += line.size();
+    }
+    for (size_t quality = 0; quality < length;) {
+        if (pos == end) throw std::runtime_error("SequenceReader: truncated FASTQ record");
+        quality += nextLine().size();
+    }
+    return true;
+}
+
+// --- SequenceIndex ---
+
+SequenceIndex::SequenceIndex(const std::string &path, char separator) : separator(separator) {
+    SequenceReader reader(path);
+    SequenceReader::Record record;
+    int64_t total = 0;
+    while (reader.next(record)) {
+        int64_t length = 0;
+        for (std::string_view line : record.lines) {
+            if (std::memchr(line.data(), separator, line.size()) || std::memchr(line.data(), '$', line.size())) {
+                throw std::invalid_argument("SequenceIndex: record '" + std::string(record.name) +
+                                            "' contains the separator or '$'");
+            }
+            length += line.size();
+        }
+        // Checked before anything is appended: the tree holds int positions
+        total += length + 1;
+        if (total >= INT_MAX) throw std::length_error("SequenceIndex: sequences exceed 2 GiB");
+        for (std::string_view line : record.lines) tree.append(line);
+        tree.append(std::string_view(&separator, 1));
+        recordMap.add(length);
+        names.emplace_back(record.name);
+    }
+    tree.finish();
+}
+
+bool SequenceIndex::acceptsPattern(const std::string &pattern) const {
+    return !pattern.empty() && pattern.find(separator) == std::string::npos &&
+           pattern.find('$') == std::string::npos;
+}
+
+RecordPosition SequenceIndex::locate(int pos) const {
+    int record = recordMap.documentAt(pos);
+    return {record, (int)(pos - recordMap.start(record))};
+}
+
+bool SequenceIndex::search(const std::string &pattern) {
+    return acceptsPattern(pattern) && tree.search(pattern);
+}
+
+int SequenceIndex::count(const std::string &pattern) {
+    return acceptsPattern(pattern) ? tree.count(pattern) : 0;
+}
+
+std::vector<RecordPosition> SequenceIndex::findAll(const std::string &pattern) {
+    std::vector<RecordPosition> result;
+    if (!acceptsPattern(pattern)) return result;
+    for (int pos : tree.findAll(pattern)) result.push_back(locate(pos));
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<int> SequenceIndex::records(const std::string &pattern) {
+    std::vector<int> result;
+    for (const RecordPosition &p : findAll(pattern)) {
+        if (result.empty() || result.back() != p.record) result.push_back(p.record);
+    }
+    return result;
+}
@@ -0,0 +1,109 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef SEQUENCE_INDEX_H
+#define SEQUENCE_INDEX_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document_map.h"
+#include "mapped_file.h"
+#include "suffixtree.h"
+
+/**
+ * SequenceReader: FASTA/FASTQ parser over a memory-mapped file.
+ *
+ * The format is taken from the first non-blank byte ('>' FASTA, '@'
+ * FASTQ). FASTA sequences may span any number of lines; FASTQ records
+ * are header, sequence line(s), '+' line and quality line(s) of the same
+ * total length, and qualities are skipped. Line ends are found 16 bytes at
+ * a time (SSE2/NEON, scalar otherwise); '\r' before '\n' is dropped.
+ * Records are views into the mapping: nothing is copied.
+ */
+class SequenceReader {
+public:
+    struct Record {
+        std::string_view name;              // Header line without '>' / '@'
+        std::vector<std::string_view> lines; // Sequence lines, in order
+    };
+
+    // Throws std::runtime_error if the file cannot be mapped or does not
+    // start with a FASTA or FASTQ header
+    explicit SequenceReader(const std::string &path);
+
+    // Reads the next record into 'record'; false at end of file. Throws
+    // std::runtime_error on a malformed FASTQ record.
+    bool next(Record &record);
+
+    bool isFastq() const { return fastq; }
+    size_t fileSize() const { return file.size(); }
+
+private:
+    MappedFile file;
+    const char *pos;
+    const char *end;
+    bool fastq;
+
+    std::string_view nextLine(); // Advances past the line; pos == end after the last
+};
+
+// A position mapped back to its record
+struct RecordPosition {
+    int record;
+    int offset;
+
+    bool operator==(const RecordPosition &o) const { return record == o.record && offset == o.offset; }
+    bool operator<(const RecordPosition &o) const {
+        return record != o.record ? record < o.record : offset < o.offset;
+    }
+};
+
+/**
+ * SequenceIndex: one generalized suffix tree over all records of a FASTA
+ * or FASTQ file.
+ *
+ * Sequence lines are appended to the tree straight from the mapping, each
+ * record followed by a separator, so no concatenated copy is ever built
+ * and no match crosses a record boundary. Results are (record, offset)
+ * pairs; patterns containing the separator or '$' match nothing.
+ */
+class SequenceIndex {
+public:
+    // Parses 'path' and builds the tree. Throws like SequenceReader, and
+    // std::invalid_argument if a sequence contains the separator or '$'.
+    explicit SequenceIndex(const std::string &path, char separator = '\x1f');
+
+    bool search(const std::string &pattern);
+    int count(const std::string &pattern);
+
+    // All occurrences, sorted by record then offset
+    std::vector<RecordPosition> findAll(const std::string &pattern);
+
+    // Sorted IDs of the records containing 'pattern'
+    std::vector<int> records(const std::string &pattern);
+
+    int recordCount() const { return recordMap.size(); }
+    const std::string& recordName(int record) const { return names[record]; }
+    int64_t recordLength(int record) const { return recordMap.length(record); }
+
+    // Maps a position of getTree() to its record
+    RecordPosition locate(int pos) const;
+
+    SuffixTree& getTree() { return tree; }
+
+private:
+    SuffixTree tree;
+    DocumentMap recordMap;
+    std::vector<std::string> names;
+    char separator;
+
+    bool acceptsPattern(const std::string &pattern) const;
+};
+
+#endif // SEQUENCE_INDEX_H
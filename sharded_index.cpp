@@ -0,0 +1,380 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "sharded_index.h"
+#include "batch_builder.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+// --- ShardedSuffixIndex ---
+
+ShardedSuffixIndex::ShardedSuffixIndex(int threads, char separator) : separator(separator), pool(threads) {}
+
+/**
+ * planShards:
+ * Cuts the document list into contiguous runs of about total/shards bytes;
+ * a document never straddles two shards.
+ */
+void ShardedSuffixIndex::planShards(int shardCount) {
+    if (docs.size() == 0) return;
+    if (shardCount <= 0) shardCount = std::max(1u, std::thread::hardware_concurrency());
+    shardCount = std::min(shardCount, docs.size());
+    int64_t total = docs.start(docs.size());
+
+    int first = 0;
+    for (int s = 0; s < shardCount; s++) {
+        // Close the run once it reaches its share, leaving a document for
+        // every remaining shard
+        int64_t target = total * (s + 1) / shardCount;
+        int last = first + 1;
+        int maxLast = docs.size() - (shardCount - s - 1);
+        while (last < maxLast && docs.start(last) < target) last++;
+
+        auto shard = std::make_unique<Shard>();
+        shard->firstDocument = first;
+        shard->documentCount = last - first;
+        shard->base = docs.start(first);
+        if (docs.start(last) - shard->base >= INT_MAX) {
+            throw std::invalid_argument("ShardedSuffixIndex: shard exceeds 2 GiB, use more shards");
+        }
+        shards.push_back(std::move(shard));
+        first = last;
+    }
+}
+
+void ShardedSuffixIndex::buildShards(const std::vector<std::string_view> &texts, int threads) {
+    auto trees = buildMany(texts, threads);
+    for (size_t s = 0; s < shards.size(); s++) {
+        shards[s]->tree = std::move(trees[s]);
+        shards[s]->loaded.store(true, std::memory_order_release);
+    }
+}
+
+ShardedSuffixIndex::ShardedSuffixIndex(const std::vector<std::string> &documents, int shardCount, int threads,
+                                       char separator)
+    : ShardedSuffixIndex(threads, separator) {
+    for (const std::string &d : documents) {
+        if (d.find('$') != std::string::npos) {
+            throw std::invalid_argument("ShardedSuffixIndex: document " + std::to_string(docs.size()) +
+                                        " contains '$', the tree terminator");
+        }
+        docs.add(d.size());
+    }
+    planShards(shardCount);
+
+    // Each shard's text: its documents, each followed by the separator
+    std::vector<std::string> texts;
+    for (auto &shard : shards) {
+        int last = shard->firstDocument + shard->documentCount;
+        std::string text;
+        text.reserve(docs.start(last) - shard->base);
+        for (int d = shard->firstDocument; d < last; d++) {
+            text += documents[d];
+            text += separator;
+        }
+        texts.push_back(std::move(text));
+    }
+    buildShards(std::vector<std::string_view>(texts.begin(), texts.end()), threads);
+}
+
+std::unique_ptr<ShardedSuffixIndex> ShardedSuffixIndex::fromText(std::string_view text, char separator,
+                                                                 int shardCount, int threads) {
+    if (const char *dollar = (const char*)std::memchr(text.data(), '$', text.size())) {
+        throw std::invalid_argument("ShardedSuffixIndex: text contains '$', the tree terminator, at byte " +
+                                    std::to_string(dollar - text.data()));
+    }
+    std::unique_ptr<ShardedSuffixIndex> index(new ShardedSuffixIndex(threads, separator));
+    for (size_t pos = 0; pos < text.size();) {
+        const char *end = (const char*)std::memchr(text.data() + pos, separator, text.size() - pos);
+        size_t length = end ? end - (text.data() + pos) : text.size() - pos;
+        index->docs.add(length);
+        pos += length + 1;
+    }
+    index->planShards(shardCount);
+
+    // Records are already separator-terminated in 'text', except maybe the last
+    std::string tail;
+    std::vector<std::string_view> texts;
+    for (auto &shard : index->shards) {
+        int64_t end = index->docs.start(shard->firstDocument + shard->documentCount);
+        if (end > (int64_t)text.size()) {
+            tail.assign(text.substr(shard->base));
+            tail += separator;
+            texts.push_back(tail);
+        } else {
+            texts.push_back(text.substr(shard->base, end - shard->base));
+        }
+    }
+    index->buildShards(texts, threads);
+    return index;
+}
+
+ShardedSuffixIndex::~ShardedSuffixIndex() = default;
+
+SuffixTree& ShardedSuffixIndex::tree(Shard &shard) {
+    std::call_once(shard.loadOnce, [&shard] {
+        if (shard.tree) return;
+        shard.tree = std::make_unique<SuffixTree>(SuffixTree::loadMapped(shard.path));
+        shard.loaded.store(true, std::memory_order_release);
+    });
+    return *shard.tree;
+}
+
+// Bytes of the shard's text before the tree's '$' terminator
+int64_t ShardedSuffixIndex::shardLength(const Shard &shard) const {
+    return docs.start(shard.firstDocument + shard.documentCount) - shard.base;
+}
+
+bool ShardedSuffixIndex::acceptsPattern(const std::string &pattern) const {
+    return !pattern.empty() && pattern.find(separator) == std::string::npos &&
+           pattern.find('$') == std::string::npos;
+}
+
+template <typename Task>
+void ShardedSuffixIndex::fanOut(Task task) {
+    std::lock_guard<std::mutex> lock(queryMutex);
+    if (shards.size() == 1) {
+        task(0); // Nothing to overlap: skip the pool hand-off
+        return;
+    }
+    std::vector<std::exception_ptr> errors(shards.size());
+    for (size_t s = 0; s < shards.size(); s++) {
+        pool.submit([&, s] {
+            try {
+                task(s);
+            } catch (...) {
+                errors[s] = std::current_exception();
+            }
+        }, (int)s);
+    }
+    pool.wait();
+    for (auto &e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+bool ShardedSuffixIndex::search(const std::string &pattern) {
+    if (!acceptsPattern(pattern)) return false;
+    std::vector<char> found(shards.size(), 0);
+    fanOut([&](size_t s) { found[s] = tree(*shards[s]).search(pattern); });
+    return std::find(found.begin(), found.end(), 1) != found.end();
+}
+
+int64_t ShardedSuffixIndex::count(const std::string &pattern) {
+    if (!acceptsPattern(pattern)) return 0;
+    std::vector<int64_t> counts(shards.size(), 0);
+    fanOut([&](size_t s) { counts[s] = tree(*shards[s]).count(pattern); });
+    int64_t total = 0;
+    for (int64_t c : counts) total += c;
+    return total;
+}
+
+std::vector<int64_t> ShardedSuffixIndex::findAll(const std::string &pattern) {
+    std::vector<int64_t> positions;
+    if (!acceptsPattern(pattern)) return positions;
+
+    std::vector<std::vector<int64_t>> perShard(shards.size());
+    fanOut([&](size_t s) {
+        std::vector<int> local = tree(*shards[s]).findAll(pattern);
+        std::vector<int64_t> &out = perShard[s];
+        out.reserve(local.size());
+        int64_t length = shardLength(*shards[s]);
+        for (int p : local) {
+            if (p < length) out.push_back(shards[s]->base + p);
+        }
+        std::sort(out.begin(), out.end());
+    });
+
+    // Shards cover increasing position ranges: concatenating keeps the order
+    size_t total = 0;
+    for (auto &v : perShard) total += v.size();
+    positions.reserve(total);
+    for (auto &v : perShard) positions.insert(positions.end(), v.begin(), v.end());
+    return positions;
+}
+
+std::vector<int> ShardedSuffixIndex::documents(const std::string &pattern) {
+    std::vector<int> ids;
+    if (!acceptsPattern(pattern)) return ids;
+
+    std::vector<std::vector<int>> perShard(shards.size());
+    fanOut([&](size_t s) {
+        std::vector<int> local = tree(*shards[s]).findAll(pattern);
+        std::vector<int> &out = perShard[s];
+        int64_t length = shardLength(*shards[s]);
+        for (int p : local) {
+            if (p < length) out.push_back(docs.documentAt(shards[s]->base + p));
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    });
+
+    for (auto &v : perShard) ids.insert(ids.end(), v.begin(), v.end());
+    return ids;
+}
+
+std::vector<std::vector<int64_t>> ShardedSuffixIndex::findAll(const std::vector<std::string> &patterns) {
+    std::vector<std::vector<std::vector<int64_t>>> perShard(shards.size());
+    fanOut([&](size_t s) {
+        SuffixTree &t = tree(*shards[s]);
+        int64_t length = shardLength(*shards[s]);
+        perShard[s].resize(patterns.size());
+        for (size_t k = 0; k < patterns.size(); k++) {
+            if (!acceptsPattern(patterns[k])) continue;
+            std::vector<int> local = t.findAll(patterns[k]);
+            std::vector<int64_t> &out = perShard[s][k];
+            out.reserve(local.size());
+            for (int p : local) {
+                if (p < length) out.push_back(shards[s]->base + p);
+            }
+            std::sort(out.begin(), out.end());
+        }
+    });
+
+    std::vector<std::vector<int64_t>> positions(patterns.size());
+    for (auto &shardResults : perShard) {
+        for (size_t k = 0; k < patterns.size(); k++) {
+            positions[k].insert(positions[k].end(), shardResults[k].begin(), shardResults[k].end());
+        }
+    }
+    return positions;
+}
+
+std::vector<std::vector<int>> ShardedSuffixIndex::documents(const std::vector<std::string> &patterns) {
+    std::vector<std::vector<std::vector<int>>> perShard(shards.size());
+    fanOut([&](size_t s) {
+        SuffixTree &t = tree(*shards[s]);
+        int64_t length = shardLength(*shards[s]);
+        perShard[s].resize(patterns.size());
+        for (size_t k = 0; k < patterns.size(); k++) {
+            if (!acceptsPattern(patterns[k])) continue;
+            std::vector<int> &out = perShard[s][k];
+            for (int p : t.findAll(patterns[k])) {
+                if (p < length) out.push_back(docs.documentAt(shards[s]->base + p));
+            }
+            std::sort(out.begin(), out.end());
+            out.erase(std::unique(out.begin(), out.end()), out.end());
+        }
+    });
+
+    std::vector<std::vector<int>> ids(patterns.size());
+    for (auto &shardResults : perShard) {
+        for (size_t k = 0; k < patterns.size(); k++) {
+            ids[k].insert(ids[k].end(), shardResults[k].begin(), shardResults[k].end());
+        }
+    }
+    return ids;
+}
+
+// --- Persistence ---
+
+static const char *MANIFEST_NAME = "manifest.txt";
+static const char *MANIFEST_HEADER = "ukkonen-sharded-index 2";
+static const char *MANIFEST_HEADER_V1 = "ukkonen-sharded-index 1"; // Lengths inline in the manifest
+static const char *STARTS_NAME = "documents.bin";
+
+static std::string shardFile(int s) {
+    return "shard-" + std::to_string(s) + ".ukst";
+}
+
+/**
+ * save:
+ * manifest.txt holds the separator, the counts and each shard's document
+ * range; documents.bin holds the documentCount + 1 document starts as
+ * native int64s, mapped as is by load(); shard-<i>.ukst holds
+ * SuffixTree::save() of shard i.
+ */
+void ShardedSuffixIndex::save(const std::string &directory) {
+    namespace fs = std::filesystem;
+    fs::create_directories(directory);
+
+    std::ofstream starts(fs::path(directory) / STARTS_NAME, std::ios::binary);
+    starts.write((const char*)docs.data(), (docs.size() + 1) * sizeof(int64_t));
+    if (!starts) throw std::runtime_error("ShardedSuffixIndex: cannot write document starts in " + directory);
+
+    std::ofstream manifest(fs::path(directory) / MANIFEST_NAME);
+    manifest << MANIFEST_HEADER << "\n";
+    manifest << (int)(unsigned char)separator << " " << docs.size() << " " << shards.size() << "\n";
+    for (auto &shard : shards) manifest << shard->firstDocument << " " << shard->documentCount << "\n";
+    if (!manifest) throw std::runtime_error("ShardedSuffixIndex: cannot write manifest in " + directory);
+
+    for (size_t s = 0; s < shards.size(); s++) {
+        fs::path path = fs::path(directory) / shardFile(s);
+        std::ofstream out(path, std::ios::binary);
+        tree(*shards[s]).save(out);
+        if (!out) throw std::runtime_error("ShardedSuffixIndex: cannot write " + path.string());
+    }
+}
+
+/**
+ * load:
+ * Reads the few manifest lines and maps documents.bin: the document map
+ * views the mapping, so opening costs the same whatever the number of
+ * documents. Indexes saved with the inline lengths of version 1 are still
+ * read, in time linear in the number of documents.
+ */
+std::unique_ptr<ShardedSuffixIndex> ShardedSuffixIndex::load(const std::string &directory, int threads) {
+    namespace fs = std::filesystem;
+    std::ifstream manifest(fs::path(directory) / MANIFEST_NAME);
+    std::string header;
+    if (!std::getline(manifest, header) || (header != MANIFEST_HEADER && header != MANIFEST_HEADER_V1)) {
+        throw std::runtime_error("ShardedSuffixIndex: no index manifest in " + directory);
+    }
+
+    auto corrupt = [&](const std::string &what) {
+        return std::runtime_error("ShardedSuffixIndex: " + what + " in the manifest in " + directory);
+    };
+    int separator, documentCount, shardCount;
+    manifest >> separator >> documentCount >> shardCount;
+    if (!manifest) throw corrupt("truncated header");
+    if (separator < 0 || separator > 255) throw corrupt("separator out of range");
+    if (documentCount < 0 || shardCount < 0) throw corrupt("negative count");
+
+    std::unique_ptr<ShardedSuffixIndex> index(new ShardedSuffixIndex(threads, (char)separator));
+    if (header == MANIFEST_HEADER_V1) {
+        for (int d = 0; d < documentCount; d++) {
+            int64_t length;
+            if (!(manifest >> length)) throw corrupt("truncated document lengths");
+            if (length < 0) throw corrupt("negative document length");
+            index->docs.add(length);
+        }
+    } else {
+        fs::path path = fs::path(directory) / STARTS_NAME;
+        auto starts = std::make_shared<MappedFile>(path.string());
+        if (starts->size() != ((size_t)documentCount + 1) * sizeof(int64_t) ||
+            ((const int64_t*)starts->data())[0] != 0) {
+            throw std::runtime_error("ShardedSuffixIndex: " + path.string() + " does not match the manifest");
+        }
+        index->docs = DocumentMap::view((const int64_t*)starts->data(), documentCount, starts);
+    }
+
+    // The shards must cover documents [0, documentCount) in order
+    int next = 0;
+    for (int s = 0; s < shardCount; s++) {
+        auto shard = std::make_unique<Shard>();
+        if (!(manifest >> shard->firstDocument >> shard->documentCount)) throw corrupt("truncated shard list");
+        if (shard->firstDocument != next || shard->documentCount < 0 ||
+            shard->documentCount > documentCount - next) {
+            throw corrupt("shard " + std::to_string(s) + " out of order or out of range");
+        }
+        next += shard->documentCount;
+        shard->base = index->docs.start(shard->firstDocument);
+        int64_t length = index->docs.start(next) - shard->base;
+        if (length < 0 || length >= INT_MAX) throw corrupt("shard " + std::to_string(s) + " with an invalid length");
+        shard->path = (fs::path(directory) / shardFile(s)).string();
+        index->shards.push_back(std::move(shard));
+    }
+    if (next != documentCount) throw corrupt("shards not covering every document");
+    return index;
+}
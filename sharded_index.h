@@ -0,0 +1,114 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef SHARDED_INDEX_H
+#define SHARDED_INDEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document_map.h"
+#include "suffixtree.h"
+#include "thread_pool.h"
+
+/**
+ * ShardedSuffixIndex: a corpus split into document-aligned shards, one
+ * SuffixTree per shard.
+ *
+ * Documents are assigned to shards in order, in contiguous runs of about
+ * equal size, so shard i covers one range of global positions. Shards are
+ * built in parallel and every query fans out to all shards on a thread
+ * pool; results are merged with each shard's global offset. Positions are
+ * global: document d occupies [start(d), start(d) + length(d)).
+ *
+ * A loaded index reads each shard's snapshot on its first query. Queries
+ * are serialized (one fan-out at a time); the empty pattern and patterns
+ * containing the separator or '$' match nothing.
+ */
+class ShardedSuffixIndex {
+public:
+    // shards <= 0 uses one shard per hardware thread; threads <= 0 likewise.
+    // Throws std::invalid_argument if a document contains '$', the trees'
+    // terminator.
+    explicit ShardedSuffixIndex(const std::vector<std::string> &documents, int shards = 0, int threads = 0,
+                                char separator = '\x1f');
+    ~ShardedSuffixIndex();
+
+    // Indexes 'text' as separator-terminated records (e.g. lines with '\n')
+    // without copying it into per-document strings; shard trees are built
+    // straight from slices of 'text'. Throws like the constructor.
+    static std::unique_ptr<ShardedSuffixIndex> fromText(std::string_view text, char separator, int shards = 0,
+                                                        int threads = 0);
+
+    ShardedSuffixIndex(const ShardedSuffixIndex&) = delete;
+    ShardedSuffixIndex& operator=(const ShardedSuffixIndex&) = delete;
+
+    bool search(const std::string &pattern);
+    int64_t count(const std::string &pattern);
+
+    // Sorted global start positions of all occurrences
+    std::vector<int64_t> findAll(const std::string &pattern);
+
+    // Sorted IDs of the documents containing 'pattern'
+    std::vector<int> documents(const std::string &pattern);
+
+    // Batch forms: one fan-out for the whole batch, each shard task
+    // answering every pattern. Results are in input order.
+    std::vector<std::vector<int64_t>> findAll(const std::vector<std::string> &patterns);
+    std::vector<std::vector<int>> documents(const std::vector<std::string> &patterns);
+
+    // Writes a manifest and one snapshot per shard into 'directory'
+    // (created if missing). Throws std::runtime_error on I/O failure.
+    void save(const std::string &directory);
+
+    // Opens an index written by save(); each shard is mapped on its first
+    // query (see SuffixTree::loadMapped), so opening costs no tree I/O.
+    // Throws std::runtime_error if the manifest is missing or inconsistent
+    // (shards not covering the documents in order, bad counts or separator).
+    static std::unique_ptr<ShardedSuffixIndex> load(const std::string &directory, int threads = 0);
+
+    int shardCount() const { return (int)shards.size(); }
+    bool isLoaded(int shard) const { return shards[shard]->loaded.load(std::memory_order_acquire); }
+    const DocumentMap& getDocuments() const { return docs; }
+
+private:
+    struct Shard {
+        int firstDocument;
+        int documentCount;
+        int64_t base;                   // Global position of the shard's first byte
+        std::string path;               // Snapshot file, empty if built in memory
+        std::unique_ptr<SuffixTree> tree;
+        std::once_flag loadOnce;
+        std::atomic<bool> loaded{false};
+    };
+
+    DocumentMap docs;
+    char separator;
+    std::vector<std::unique_ptr<Shard>> shards;
+    WorkStealingPool pool;
+    std::mutex queryMutex; // One fan-out at a time
+
+    ShardedSuffixIndex(int threads, char separator);
+
+    // Cuts docs into shardCount contiguous runs of about equal size
+    void planShards(int shardCount);
+    void buildShards(const std::vector<std::string_view> &texts, int threads);
+
+    SuffixTree& tree(Shard &shard);
+    int64_t shardLength(const Shard &shard) const;
+    bool acceptsPattern(const std::string &pattern) const;
+
+    // Runs task(i) for every shard on the pool and waits
+    template <typename Task>
+    void fanOut(Task task);
+};
+
+#endif // SHARDED_INDEX_H
@@ -0,0 +1,372 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "sparse_suffixtree.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+
+/**
+ * suffixArray:
+ * SA-IS suffix sorting of s[0, n) over the alphabet [0, upper] in O(n).
+ * A suffix sorts before every longer suffix it is a prefix of.
+ */
+static std::vector<int> suffixArray(const std::vector<int> &s, int upper) {
+    int n = s.size();
+    if (n == 0) return {};
+    if (n == 1) return {0};
+    if (n == 2) return s[0] < s[1] ? std::vector<int>{0, 1} : std::vector<int>{1, 0};
+
+    // S-type suffixes are smaller than the suffix that follows them
+    std::vector<int> sa(n);
+    std::vector<bool> isS(n);
+    for (int i = n - 2; i >= 0; i--) {
+        isS[i] = s[i] == s[i + 1] ? isS[i + 1] : s[i] < s[i + 1];
+    }
+
+    // Bucket starts: L-type suffixes of each character first, then S-type
+    std::vector<int> startL(upper + 1), startS(upper + 1);
+    for (int i = 0; i < n; i++) {
+        if (!isS[i]) startS[s[i]]++;
+        else startL[s[i] + 1]++;
+    }
+    for (int c = 0; c <= upper; c++) {
+        startS[c] += startL[c];
+        if (c < upper) startL[c + 1] += startS[c];
+    }
+
+    std::vector<int> bucket(upper + 1);
+    auto induce = [&](const std::vector<int> &lms) {
+        std::fill(sa.begin(), sa.end(), -1);
+        bucket = startS;
+        for (int p : lms) sa[bucket[s[p]]++] = p;
+        bucket = startL;
+        sa[bucket[s[n - 1]]++] = n - 1;
+        for (int i = 0; i < n; i++) {
+            int p = sa[i];
+            if (p >= 1 && !isS[p - 1]) sa[bucket[s[p - 1]]++] = p - 1;
+        }
+        bucket = startL;
+        for (int i = n - 1; i >= 0; i--) {
+            int p = sa[i];
+            if (p >= 1 && isS[p - 1]) sa[--bucket[s[p - 1] + 1]] = p - 1;
+        }
+    };
+
+    // Leftmost S-type positions, numbered in text order
+    std::vector<int> lmsIndex(n + 1, -1);
+    std::vector<int> lms;
+    for (int i = 1; i < n; i++) {
+        if (!isS[i - 1] && isS[i]) {
+            lmsIndex[i] = lms.size();
+            lms.push_back(i);
+        }
+    }
+    int m = lms.size();
+    induce(lms);
+    if (m == 0) return sa;
+
+    // Name the LMS substrings in sorted order; equal substrings share a name
+    std::vector<int> sortedLms;
+    sortedLms.reserve(m);
+    for (int p : sa) {
+        if (lmsIndex[p] != -1) sortedLms.push_back(p);
+    }
+    std::vector<int> reduced(m);
+    int names = 0;
+    reduced[lmsIndex[sortedLms[0]]] = 0;
+    for (int i = 1; i < m; i++) {
+        int l = sortedLms[i - 1], r = sortedLms[i];
+        int endL = lmsIndex[l] + 1 < m ? lms[lmsIndex[l] + 1] : n;
+        int endR = lmsIndex[r] + 1 < m ? lms[lmsIndex[r] + 1] : n;
+        bool same = endL - l == endR - r;
+        if (same) {
+            while (l < endL && s[l] == s[r]) {
+                l++;
+                r++;
+            }
+            if (l == n || s[l] != s[r]) same = false;
+        }
+        if (!same) names++;
+        reduced[lmsIndex[sortedLms[i]]] = names;
+    }
+    lmsIndex = std::vector<int>();
+
+    // Sort the LMS suffixes by their reduced string, then induce the rest
+    std::vector<int> reducedSa = suffixArray(reduced, names);
+    for (int i = 0; i < m; i++) sortedLms[i] = lms[reducedSa[i]];
+    induce(sortedLms);
+    return sa;
+}
+
+SparseSuffixTree::SparseSuffixTree(std::string t, const std::vector<int> &positions) {
+    init(t);
+    std::vector<bool> selected(size);
+    for (int pos : positions) {
+        if (pos >= 0 && pos < size - 1) selected[pos] = true;
+    }
+    build(selected);
+}
+
+SparseSuffixTree::SparseSuffixTree(std::string t, const std::function<bool(const std::string&, int)> &select) {
+    // Selected before init() appends the terminator, so the predicate sees
+    // the caller's text exactly
+    std::vector<bool> selected(t.size() + 1);
+    for (int i = 0; i < (int)t.size(); i++) {
+        if (select(t, i)) selected[i] = true;
+    }
+    init(t);
+    selected.resize(size);
+    selected[size - 1] = false;
+    build(selected);
+}
+
+void SparseSuffixTree::init(std::string &t) {
+    text = std::move(t);
+    // Same convention as SuffixTree: the terminator is not indexed itself
+    if (text.empty() || text.back() != '$') {
+        text += "$";
+    }
+    size = text.length();
+    nodeCount = 0;
+    indexedCount = 0;
+    root = newNode(-1, -1, -1);
+}
+
+SparseSuffixTree::SparseSuffixTree(SparseSuffixTree &&other) noexcept
+    : text(std::move(other.text)), arena(std::move(other.arena)), root(other.root), size(other.size),
+      nodeCount(other.nodeCount), indexedCount(other.indexedCount) {
+    other.root = nullptr;
+    other.size = 0;
+    other.nodeCount = 0;
+    other.indexedCount = 0;
+}
+
+SparseSuffixTree& SparseSuffixTree::operator=(SparseSuffixTree &&other) noexcept {
+    if (this != &other) {
+        text = std::move(other.text);
+        arena = std::move(other.arena);
+        root = other.root;
+        size = other.size;
+        nodeCount = other.nodeCount;
+        indexedCount = other.indexedCount;
+        other.root = nullptr;
+        other.size = 0;
+        other.nodeCount = 0;
+        other.indexedCount = 0;
+    }
+    return *this;
+}
+
+SparseNode* SparseSuffixTree::newNode(int start, int end, int suffix) {
+    return arena.create<SparseNode>(start, end, suffix, nodeCount++);
+}
+
+SparseNode* SparseSuffixTree::findChild(const SparseNode *n, char c) const {
+    const unsigned char *keys = n->keys();
+    unsigned char key = (unsigned char)c;
+    int lo = 0, hi = n->childCount;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (keys[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return (lo < n->childCount && keys[lo] == key) ? n->children[lo] : nullptr;
+}
+
+/**
+ * build:
+ * Sorts all suffixes (SA-IS), derives the LCP of neighbours with Kasai's
+ * Phi method, and keeps the selected suffixes: the LCP of two selected
+ * neighbours is the minimum over the ranks between them. The tree is then
+ * built left to right from that sparse LCP array, keeping the rightmost
+ * path on a stack. A node's children are final once it leaves the stack
+ * and are packed into one arena array then.
+ */
+void SparseSuffixTree::build(const std::vector<bool> &selected) {
+    std::vector<int> sa;
+    {
+        std::vector<int> s(text.begin(), text.end());
+        for (int &c : s) c = (unsigned char)c;
+        sa = suffixArray(s, 255);
+    }
+
+    // plcp[i]: LCP of suffix i with the suffix ranked just before it
+    std::vector<int> plcp(size);
+    plcp[sa[0]] = -1;
+    for (int r = 1; r < size; r++) plcp[sa[r]] = sa[r - 1];
+    for (int i = 0, h = 0; i < size; i++) {
+        int j = plcp[i];
+        if (j < 0) {
+            plcp[i] = h = 0;
+            continue;
+        }
+        while (i + h < size && j + h < size && text[i + h] == text[j + h]) h++;
+        plcp[i] = h;
+        if (h > 0) h--;
+    }
+
+    struct Level {
+        SparseNode *node;
+        int depth;                        // String depth of the node
+        std::vector<SparseNode*> children; // Sorted: added in suffix order
+    };
+    std::vector<Level> path(1);
+    path[0].node = root;
+    path[0].depth = 0;
+    size_t top = 0; // Levels past 'top' are kept only to reuse their vectors
+
+    auto pack = [&](Level &level) {
+        int count = level.children.size();
+        if (count == 0) return;
+        SparseNode *n = level.node;
+        n->children = (SparseNode**)arena.allocate(count * (sizeof(SparseNode*) + 1), alignof(SparseNode*));
+        n->childCount = count;
+        for (int i = 0; i < count; i++) {
+            n->children[i] = level.children[i];
+            n->keys()[i] = (unsigned char)text[level.children[i]->start];
+        }
+        level.children.clear();
+    };
+    auto push = [&](SparseNode *n, int depth) {
+        if (++top == path.size()) path.emplace_back();
+        path[top].node = n;
+        path[top].depth = depth;
+    };
+
+    int lcp = INT_MAX;
+    bool first = true;
+    for (int r = 0; r < size; r++) {
+        if (r > 0) lcp = std::min(lcp, plcp[sa[r]]);
+        int pos = sa[r];
+        if (!selected[pos]) continue;
+        if (first) lcp = 0;
+        first = false;
+
+        // Close the nodes deeper than the shared prefix
+        SparseNode *last = nullptr;
+        while (path[top].depth > lcp) {
+            pack(path[top]);
+            last = path[top].node;
+            top--;
+        }
+        if (path[top].depth < lcp) {
+            // The shared prefix ends inside the edge to 'last': split it
+            int cut = lcp - path[top].depth;
+            SparseNode *split = newNode(last->start, last->start + cut - 1, -1);
+            last->start += cut;
+            path[top].children.back() = split;
+            push(split, lcp);
+            path[top].children.push_back(last);
+        }
+
+        // A suffix never ends at the shared prefix: a proper prefix of
+        // another suffix sorts before it
+        SparseNode *leaf = newNode(pos + lcp, size - 1, pos);
+        path[top].children.push_back(leaf);
+        push(leaf, size - pos);
+        indexedCount++;
+        lcp = INT_MAX;
+    }
+    for (;; top--) {
+        pack(path[top]);
+        if (top == 0) break;
+    }
+}
+
+// --- Position Selectors ---
+
+std::vector<int> SparseSuffixTree::wordBoundaries(const std::string &text) {
+    std::vector<int> positions;
+    for (int i = 0; i < (int)text.length(); i++) {
+        bool word = std::isalnum((unsigned char)text[i]);
+        if (word && (i == 0 || !std::isalnum((unsigned char)text[i - 1]))) {
+            positions.push_back(i);
+        }
+    }
+    return positions;
+}
+
+std::vector<int> SparseSuffixTree::everyKth(const std::string &text, int k) {
+    std::vector<int> positions;
+    if (k <= 0) return positions;
+    for (int i = 0; i < (int)text.length(); i += k) {
+        positions.push_back(i);
+    }
+    return positions;
+}
+
+// --- Visualization and Search Helpers ---
+
+void SparseSuffixTree::printTree() {
+    std::cout << "\n--- Sparse Suffix Tree Structure ---\n";
+    if (root) printRecursive(root, 0);
+    std::cout << "------------------------------------\n";
+}
+
+void SparseSuffixTree::printRecursive(SparseNode *n, int depth) {
+    if (!n) return;
+
+    if (n != root) {
+        for (int i = 0; i < depth; i++) std::cout << "  ";
+        std::cout << "Edge [" << n->start << "," << n->end << "]: ";
+        for (int i = n->start; i <= n->end; i++) {
+            std::cout << text[i];
+        }
+        std::cout << " (Node " << n->id;
+        if (n->suffix >= 0) std::cout << ", suffix " << n->suffix;
+        std::cout << ")" << std::endl;
+    } else {
+        std::cout << "Root (Node " << n->id << ")" << std::endl;
+    }
+
+    for (int i = 0; i < n->childCount; i++) {
+        printRecursive(n->children[i], depth + 1);
+    }
+}
+
+SparseNode* SparseSuffixTree::locate(const std::string &pattern) {
+    if (!root) return nullptr;
+    SparseNode *n = root;
+    int idx = 0;
+    int m = pattern.length();
+
+    while (idx < m) {
+        SparseNode *child = findChild(n, pattern[idx]);
+        if (!child) return nullptr;
+
+        int edgeLen = child->end - child->start + 1;
+        for (int i = 0; i < edgeLen && idx + i < m; i++) {
+            if (text[child->start + i] != pattern[idx + i]) return nullptr;
+        }
+        n = child;
+        idx += edgeLen;
+    }
+    return n;
+}
+
+bool SparseSuffixTree::search(const std::string &pattern) {
+    if (pattern.empty()) return root != nullptr;
+    return locate(pattern) != nullptr;
+}
+
+std::vector<int> SparseSuffixTree::findAll(const std::string &pattern) {
+    std::vector<int> positions;
+    SparseNode *locus = locate(pattern);
+    if (!locus) return positions;
+
+    std::vector<SparseNode*> stack = {locus};
+    while (!stack.empty()) {
+        SparseNode *n = stack.back();
+        stack.pop_back();
+        if (n->suffix >= 0) positions.push_back(n->suffix);
+        for (int i = 0; i < n->childCount; i++) {
+            stack.push_back(n->children[i]);
+        }
+    }
+    return positions;
+}
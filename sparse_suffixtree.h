@@ -0,0 +1,116 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef SPARSE_SUFFIX_TREE_H
+#define SPARSE_SUFFIX_TREE_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <iostream>
+#include "arena.h"
+
+/**
+ * Node structure for the Sparse Suffix Tree.
+ * Edges are fixed once built, so 'end' is stored inline instead of
+ * through a shared pointer as in the full tree.
+ */
+struct SparseNode {
+    // [start, end] represents the substring on the edge leading to this node.
+    int start;
+    int end;
+
+    // Starting position of the indexed suffix (-1 if none ends here)
+    int suffix;
+
+    // Unique ID for visualization/debugging
+    int id;
+
+    // Children sorted by the first byte of their edge; the key bytes follow
+    // the pointers in the same arena allocation
+    SparseNode **children;
+    int childCount;
+
+    SparseNode(int start, int end, int suffix, int id)
+        : start(start), end(end), suffix(suffix), id(id), children(nullptr), childCount(0) {}
+
+    unsigned char* keys() const { return (unsigned char*)(children + childCount); }
+};
+
+/**
+ * SparseSuffixTree: a compacted trie over a caller-selected subset of the
+ * suffixes of the text (e.g. word starts, or every k-th position).
+ *
+ * Only the selected suffixes are stored, so the tree has at most
+ * 2 * k + 1 nodes for k indexed positions, all in one arena. Construction
+ * is O(n) whatever the text: a suffix array (SA-IS) and LCP array of the
+ * whole text are filtered down to the selected positions, and the tree is
+ * built from the resulting sparse LCP intervals with one stack pass. The
+ * int arrays over the whole text (about 16 bytes per text byte at peak)
+ * are freed before the constructor returns.
+ */
+class SparseSuffixTree {
+public:
+    // Constructor: Indexes the suffixes starting at the given positions
+    SparseSuffixTree(std::string text, const std::vector<int> &positions);
+
+    // Constructor: Indexes every position for which select(text, i) holds.
+    // 'select' sees the text as passed, without the '$' terminator.
+    SparseSuffixTree(std::string text, const std::function<bool(const std::string&, int)> &select);
+
+    // The tree owns its node arena: copying would free it twice. A
+    // moved-from tree is empty and matches nothing.
+    SparseSuffixTree(const SparseSuffixTree&) = delete;
+    SparseSuffixTree& operator=(const SparseSuffixTree&) = delete;
+    SparseSuffixTree(SparseSuffixTree &&other) noexcept;
+    SparseSuffixTree& operator=(SparseSuffixTree &&other) noexcept;
+
+    // Utility: Visualization (Printing the tree structure)
+    void printTree();
+
+    // Utility: Search if a pattern starts at any indexed position
+    bool search(const std::string &pattern);
+
+    // Utility: Indexed positions at which pattern starts (unsorted)
+    std::vector<int> findAll(const std::string &pattern);
+
+    int getNodeCount() const { return nodeCount; }
+    int getIndexedCount() const { return indexedCount; }
+
+    // -- Position selectors --
+
+    // Positions that start a word (alphanumeric run)
+    static std::vector<int> wordBoundaries(const std::string &text);
+
+    // Every k-th position: 0, k, 2k, ...
+    static std::vector<int> everyKth(const std::string &text, int k);
+
+private:
+    std::string text;
+    Arena arena;
+    SparseNode *root;
+    int size;            // Length of input text (including terminator)
+    int nodeCount;       // Counter to assign IDs to nodes
+    int indexedCount;    // Number of suffixes inserted
+
+    // -- Internal Helper Functions --
+
+    void init(std::string &t);
+    SparseNode* newNode(int start, int end, int suffix);
+    SparseNode* findChild(const SparseNode *n, char c) const;
+
+    // Builds the tree over the suffixes at the marked positions
+    void build(const std::vector<bool> &selected);
+
+    // Walks the pattern from the root; returns the node whose edge contains
+    // the end of the pattern, or nullptr if the pattern is absent.
+    SparseNode* locate(const std::string &pattern);
+
+    void printRecursive(SparseNode *n, int depth);
+};
+
+#endif // SPARSE_SUFFIX_TREE_H
@@ -0,0 +1,125 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Header-only lock-free single-producer / single-consumer ring buffer.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * SpscRing: fixed-capacity FIFO for exactly one producer thread and one
+ * consumer thread. The capacity is rounded up to a power of two so slots
+ * are addressed with a mask. head and tail sit on separate cache lines so
+ * the two threads do not false-share; each side caches the other side's
+ * index and only reloads it when the ring looks full (or empty).
+ *
+ * push() and pop() block instead of failing: the caller sleeps on a
+ * condition variable until the other side makes room (or data). The mutex
+ * is only taken when a side has to sleep or the other side is asleep, so
+ * the uncontended path stays lock-free.
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer side: false if the ring is full
+    bool tryPush(const T &value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - headCache > mask) {
+            headCache = head.load(std::memory_order_acquire);
+            if (t - headCache > mask) return false;
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: false if the ring is empty
+    bool tryPop(T &value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tailCache) {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h == tailCache) return false;
+        }
+        value = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side: waits while the ring is full
+    void push(const T &value) {
+        if (!tryPush(value)) {
+            std::unique_lock<std::mutex> lock(mutex);
+            sleep(producerAsleep);
+            notFull.wait(lock, [&] { return tryPush(value); });
+            producerAsleep.store(false, std::memory_order_relaxed);
+        }
+        wake(consumerAsleep, notEmpty);
+    }
+
+    // Consumer side: waits while the ring is empty
+    void pop(T &value) {
+        if (!tryPop(value)) {
+            std::unique_lock<std::mutex> lock(mutex);
+            sleep(consumerAsleep);
+            notEmpty.wait(lock, [&] { return tryPop(value); });
+            consumerAsleep.store(false, std::memory_order_relaxed);
+        }
+        wake(producerAsleep, notFull);
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    // The fences pair up (Dekker style): either the sleeper's re-check sees
+    // the other side's update, or the other side sees the sleeper's flag
+    static void sleep(std::atomic<bool> &asleep) {
+        asleep.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void wake(std::atomic<bool> &asleep, std::condition_variable &cv) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (asleep.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_one();
+        }
+    }
+
+    std::vector<T> slots;
+    size_t mask;
+
+    alignas(CACHE_LINE) std::atomic<size_t> head{0};  // Next slot to pop
+    size_t tailCache = 0;                             // Consumer's view of tail
+    alignas(CACHE_LINE) std::atomic<size_t> tail{0};  // Next slot to push
+    size_t headCache = 0;                             // Producer's view of head
+
+    // Only touched by a side about to sleep, or waking the other one
+    alignas(CACHE_LINE) std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+    std::atomic<bool> consumerAsleep{false};
+    std::atomic<bool> producerAsleep{false};
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,181 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "streaming_builder.h"
+#include "spsc_ring.h"
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// --- Decoders ---
+
+size_t FastaDecoder::decode(char *data, size_t n) {
+    size_t out = 0;
+    for (size_t i = 0; i < n; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            inHeader = false;
+            atLineStart = true;
+            continue;
+        }
+        if (atLineStart && c == '>') {
+            inHeader = true;
+            // The '>' itself makes room for the separator
+            if (separator && hasSequence) {
+                data[out++] = separator;
+                hasSequence = false;
+            }
+        }
+        atLineStart = false;
+        if (inHeader || c == '\r') continue;
+        data[out++] = c;
+        hasSequence = true;
+    }
+    return out;
+}
+
+size_t LineDecoder::decode(char *data, size_t n) {
+    size_t out = 0;
+    for (size_t i = 0; i < n; i++) {
+        char c = data[i];
+        if (c == '\r') continue;
+        if (c == '\n') {
+            if (!atLineStart) data[out++] = separator;
+            atLineStart = true;
+            continue;
+        }
+        data[out++] = c;
+        atLineStart = false;
+    }
+    return out;
+}
+
+// --- Pipeline ---
+
+namespace {
+
+// A filled buffer handed from the I/O thread to the build thread
+struct Chunk {
+    int slot;       // Buffer index, -1 marks the end of the stream
+    size_t length;  // Decoded bytes in the buffer
+};
+
+} // namespace
+
+std::unique_ptr<SuffixTree> buildStreaming(const ReadFunction &read, ChunkDecoder &decoder,
+                                           const StreamingOptions &options, StreamingReport *report) {
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::time_point from) {
+        return std::chrono::duration<double>(Clock::now() - from).count();
+    };
+
+    int chunks = options.chunks < 2 ? 2 : options.chunks;
+    size_t chunkSize = options.chunkSize == 0 ? 1 : options.chunkSize;
+    std::vector<std::vector<char>> buffers(chunks, std::vector<char>(chunkSize));
+
+    // Buffers cycle: free -> I/O thread fills -> filled -> build thread -> free.
+    // Both threads sleep rather than spin when their ring is empty or full,
+    // so neither steals CPU time from the other.
+    SpscRing<int> freeSlots(chunks);
+    SpscRing<Chunk> filled(chunks);
+    for (int i = 0; i < chunks; i++) freeSlots.tryPush(i);
+
+    StreamingReport stats;
+    std::exception_ptr failure;
+    std::atomic<bool> cancelled{false};  // The build side failed: stop reading
+    auto start = Clock::now();
+
+    std::thread io([&] {
+        double readSeconds = 0;
+        try {
+            for (;;) {
+                int slot;
+                freeSlots.pop(slot);
+                if (cancelled.load(std::memory_order_acquire)) break;
+
+                auto t = Clock::now();
+                size_t n = read(buffers[slot].data(), chunkSize);
+                if (n == 0) {
+                    readSeconds += seconds(t);
+                    break;
+                }
+                stats.bytesRead += n;
+                size_t length = decoder.decode(buffers[slot].data(), n);
+                readSeconds += seconds(t);
+
+                filled.push({slot, length});
+            }
+        } catch (...) {
+            failure = std::current_exception();
+        }
+        stats.readSeconds = readSeconds;
+        filled.push({-1, 0});
+    });
+
+    std::unique_ptr<SuffixTree> tree;
+    int held = -1;  // Slot being indexed, not yet handed back
+    try {
+        tree = std::make_unique<SuffixTree>();
+        for (;;) {
+            Chunk chunk;
+            auto t = Clock::now();
+            filled.pop(chunk);
+            stats.waitSeconds += seconds(t);
+            if (chunk.slot < 0) break;
+            held = chunk.slot;
+
+            t = Clock::now();
+            tree->append(std::string_view(buffers[chunk.slot].data(), chunk.length));
+            stats.buildSeconds += seconds(t);
+            stats.bytesIndexed += chunk.length;
+
+            // Never waits (the ring has room for every buffer), but wakes the
+            // I/O thread if it ran out of buffers
+            freeSlots.push(chunk.slot);
+            held = -1;
+        }
+    } catch (...) {
+        // Stop the I/O thread before unwinding: hand every buffer back so
+        // it cannot stay asleep waiting for one, and drain what it filled
+        // until its end marker
+        cancelled.store(true, std::memory_order_release);
+        if (held >= 0) freeSlots.push(held);
+        for (Chunk chunk;;) {
+            filled.pop(chunk);
+            if (chunk.slot < 0) break;
+            freeSlots.push(chunk.slot);
+        }
+        io.join();
+        throw;
+    }
+    io.join();
+    if (failure) std::rethrow_exception(failure);
+
+    auto t = Clock::now();
+    tree->finish();
+    stats.buildSeconds += seconds(t);
+    stats.seconds = seconds(start);
+
+    if (report) *report = stats;
+    return tree;
+}
+
+std::unique_ptr<SuffixTree> buildFromFile(const std::string &path, ChunkDecoder &decoder,
+                                          const StreamingOptions &options, StreamingReport *report) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("buildFromFile: cannot open " + path);
+    }
+    return buildStreaming([&in](char *buffer, size_t capacity) {
+        in.read(buffer, capacity);
+        return (size_t)in.gcount();
+    }, decoder, options, report);
+}
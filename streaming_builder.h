@@ -0,0 +1,105 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef STREAMING_BUILDER_H
+#define STREAMING_BUILDER_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include "suffixtree.h"
+
+/**
+ * ChunkDecoder: turns raw input bytes into text to index. Decoding is done
+ * in place on the I/O thread and may only shrink a chunk; state that spans
+ * chunk boundaries (e.g. "inside a header line") lives in the decoder.
+ */
+class ChunkDecoder {
+public:
+    virtual ~ChunkDecoder() = default;
+
+    // Rewrites data[0, n) in place and returns the decoded length (<= n)
+    virtual size_t decode(char *data, size_t n) = 0;
+};
+
+// Indexes the input as is
+class PlainDecoder : public ChunkDecoder {
+public:
+    size_t decode(char *, size_t n) override { return n; }
+};
+
+// FASTA: drops '>' header lines and line breaks, keeping the sequence
+// only. A non-zero 'separator' is emitted between consecutive records so
+// matches cannot span two of them.
+class FastaDecoder : public ChunkDecoder {
+public:
+    explicit FastaDecoder(char separator = 0) : separator(separator) {}
+    size_t decode(char *data, size_t n) override;
+
+private:
+    char separator;
+    bool atLineStart = true;
+    bool inHeader = false;
+    bool hasSequence = false;  // Sequence emitted since the last separator
+};
+
+// One record per line: line breaks become 'separator', '\r' and empty
+// lines are dropped
+class LineDecoder : public ChunkDecoder {
+public:
+    explicit LineDecoder(char separator = '#') : separator(separator) {}
+    size_t decode(char *data, size_t n) override;
+
+private:
+    char separator;
+    bool atLineStart = true;
+};
+
+struct StreamingOptions {
+    size_t chunkSize = 1 << 20;  // Bytes per read
+    int chunks = 8;              // Buffers in flight between the two threads
+};
+
+/**
+ * Timing of a streaming build. When waitSeconds is close to zero the
+ * build was CPU bound; when it is close to seconds, I/O bound.
+ */
+struct StreamingReport {
+    double seconds = 0;        // Wall time of the whole build
+    double readSeconds = 0;    // I/O thread: reading and decoding
+    double buildSeconds = 0;   // Build thread: extending the tree
+    double waitSeconds = 0;    // Build thread: waiting for input
+    size_t bytesRead = 0;
+    size_t bytesIndexed = 0;   // After decoding
+};
+
+// Fills 'buffer' with up to 'capacity' bytes; returns 0 at end of input
+using ReadFunction = std::function<size_t(char *buffer, size_t capacity)>;
+
+/**
+ * buildStreaming:
+ * Builds a SuffixTree from a stream without holding the raw input in
+ * memory. An I/O thread reads and decodes fixed-size chunks into a small
+ * set of recycled buffers and hands them over through an SPSC ring; the
+ * calling thread appends each chunk to the tree online, so reading chunk
+ * k+1 overlaps with indexing chunk k. A thread whose ring is empty (or
+ * full) sleeps until the other one catches up instead of spinning.
+ *
+ * Exceptions thrown by 'read' or the decoder are rethrown here.
+ */
+std::unique_ptr<SuffixTree> buildStreaming(const ReadFunction &read, ChunkDecoder &decoder,
+                                           const StreamingOptions &options = StreamingOptions(),
+                                           StreamingReport *report = nullptr);
+
+// Same as above, reading the file at 'path' (throws std::runtime_error if
+// it cannot be opened)
+std::unique_ptr<SuffixTree> buildFromFile(const std::string &path, ChunkDecoder &decoder,
+                                          const StreamingOptions &options = StreamingOptions(),
+                                          StreamingReport *report = nullptr);
+
+#endif // STREAMING_BUILDER_H
@@ -0,0 +1,331 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "suffix_forest.h"
+#include <algorithm>
+#include <iostream>
+
+SuffixForest::SuffixForest(const std::vector<std::string> &records) : SuffixForest() {
+    size_t totalChars = 0;
+    for (auto const& r : records) totalChars += r.size() + 1;
+    reserve(records.size(), totalChars);
+    for (auto const& r : records) add(r);
+}
+
+void SuffixForest::reserve(size_t records, size_t totalChars) {
+    trees.reserve(records);
+    text.reserve(totalChars);
+    // A suffix tree over n characters has at most 2n nodes, each the child
+    // of one other; doubling leaves up to half of an array unused
+    nodes.reserve(2 * totalChars + records);
+    childPool.reserve(4 * totalChars);
+    keyPool.reserve(4 * totalChars);
+}
+
+void SuffixForest::clear() {
+    // Keeps capacity: the next batch reuses the same buffers
+    text.clear();
+    nodes.clear();
+    trees.clear();
+    childPool.clear();
+    keyPool.clear();
+    for (int k = 0; k < CHILD_CLASSES; k++) freeChildArrays[k] = -1;
+}
+
+int SuffixForest::newNode(int start, int end, int root) {
+    nodes.push_back({start, end, root, -1, 0, 0});
+    return (int)nodes.size() - 1;
+}
+
+int SuffixForest::edgeLength(int n, int leafEnd) const {
+    const ForestNode &node = nodes[n];
+    if (node.start < 0) return 0; // Root
+    int end = (node.end == LEAF_END) ? leafEnd : node.end;
+    return end - node.start + 1;
+}
+
+// --- Sorted Child Arrays ---
+
+// Slot of the first key >= 'key' in n's child array
+static int lowerBound(const unsigned char *keys, int count, unsigned char key) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (keys[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int SuffixForest::findChild(int n, char c) const {
+    const ForestNode &node = nodes[n];
+    if (node.childCount == 0) return -1;
+    const unsigned char *keys = keyPool.data() + node.children;
+    int slot = lowerBound(keys, node.childCount, (unsigned char)c);
+    return (slot < node.childCount && keys[slot] == (unsigned char)c) ? childPool[node.children + slot] : -1;
+}
+
+/**
+ * addChild:
+ * Inserts 'child' keyed by the first character of its edge, keeping keys
+ * sorted. A full array is moved to one of twice the capacity (taken from
+ * the free list for that size when possible) and the old one is freed.
+ */
+void SuffixForest::addChild(int parent, int child) {
+    if (nodes[parent].childCount == nodes[parent].childCapacity) {
+        int capacity = nodes[parent].childCapacity ? nodes[parent].childCapacity * 2 : 2;
+        int cls = __builtin_ctz(capacity);
+
+        int grown = freeChildArrays[cls];
+        if (grown >= 0) {
+            freeChildArrays[cls] = childPool[grown];
+        } else {
+            grown = (int)childPool.size();
+            childPool.resize(grown + capacity);
+            keyPool.resize(grown + capacity);
+        }
+
+        ForestNode &p = nodes[parent];
+        if (p.childCount) {
+            std::copy_n(childPool.begin() + p.children, p.childCount, childPool.begin() + grown);
+            std::copy_n(keyPool.begin() + p.children, p.childCount, keyPool.begin() + grown);
+            int oldCls = __builtin_ctz(p.childCapacity);
+            childPool[p.children] = freeChildArrays[oldCls];
+            freeChildArrays[oldCls] = p.children;
+        }
+        p.children = grown;
+        p.childCapacity = capacity;
+    }
+
+    ForestNode &p = nodes[parent];
+    unsigned char key = (unsigned char)text[nodes[child].start];
+    int *slots = childPool.data() + p.children;
+    unsigned char *keys = keyPool.data() + p.children;
+    int slot = lowerBound(keys, p.childCount, key);
+    for (int i = p.childCount; i > slot; i--) {
+        slots[i] = slots[i - 1];
+        keys[i] = keys[i - 1];
+    }
+    slots[slot] = child;
+    keys[slot] = key;
+    p.childCount++;
+}
+
+// 'newChild' takes over the slot of 'oldChild'; both edges start with
+// the same character
+void SuffixForest::replaceChild(int parent, int oldChild, int newChild) {
+    const ForestNode &p = nodes[parent];
+    int slot = lowerBound(keyPool.data() + p.children, p.childCount, (unsigned char)text[nodes[oldChild].start]);
+    childPool[p.children + slot] = newChild;
+}
+
+/**
+ * add:
+ * Appends the record to the shared buffer and runs Ukkonen's algorithm
+ * over it. The active point lives in locals since only one tree is under
+ * construction at a time; leaves need no end pointer because every leaf of
+ * a finished tree ends at the tree's last character.
+ */
+int SuffixForest::add(std::string_view record) {
+    ForestTree tree;
+    tree.textStart = text.size();
+    text.append(record);
+    if (record.empty() || record.back() != '$') {
+        text += '$';
+    }
+    tree.textLength = (int)text.size() - tree.textStart;
+
+    int root = newNode(-1, -1, -1);
+    nodes[root].suffixLink = root;
+    tree.root = root;
+
+    int activeNode = root;
+    int activeEdge = -1;
+    int activeLength = 0;
+    int remainder = 0;
+    int last = tree.textStart + tree.textLength;
+
+    for (int pos = tree.textStart; pos < last; pos++) {
+        int leafEnd = pos; // Rule 1: all leaves grow implicitly
+        remainder++;
+        int lastNewNode = -1;
+
+        while (remainder > 0) {
+            if (activeLength == 0) {
+                activeEdge = pos;
+            }
+
+            int next = findChild(activeNode, text[activeEdge]);
+            if (next < 0) {
+                // Rule 2: New leaf
+                addChild(activeNode, newNode(pos, LEAF_END, root));
+                if (lastNewNode >= 0) {
+                    nodes[lastNewNode].suffixLink = activeNode;
+                    lastNewNode = -1;
+                }
+            }
+            else {
+                // Skip/Count trick
+                int len = edgeLength(next, leafEnd);
+                if (activeLength >= len) {
+                    activeEdge += len;
+                    activeLength -= len;
+                    activeNode = next;
+                    continue;
+                }
+
+                if (text[nodes[next].start + activeLength] == text[pos]) {
+                    // Rule 3: Showstopper
+                    if (lastNewNode >= 0 && activeNode != root) {
+                        nodes[lastNewNode].suffixLink = activeNode;
+                        lastNewNode = -1;
+                    }
+                    activeLength++;
+                    break;
+                }
+
+                // Rule 2 (Split)
+                int split = newNode(nodes[next].start, nodes[next].start + activeLength - 1, root);
+                replaceChild(activeNode, next, split);
+                nodes[next].start += activeLength;
+                addChild(split, next);
+                addChild(split, newNode(pos, LEAF_END, root));
+
+                if (lastNewNode >= 0) {
+                    nodes[lastNewNode].suffixLink = split;
+                }
+                lastNewNode = split;
+            }
+
+            remainder--;
+            if (activeNode == root && activeLength > 0) {
+                activeLength--;
+                activeEdge = pos - remainder + 1;
+            } else if (activeNode != root) {
+                activeNode = nodes[activeNode].suffixLink;
+            }
+        }
+    }
+
+    tree.nodeCount = (int)nodes.size() - tree.root;
+    trees.push_back(tree);
+    return (int)trees.size() - 1;
+}
+
+// --- Queries ---
+
+int SuffixForest::locate(const ForestTree &tree, std::string_view pattern, int &depth) const {
+    int leafEnd = tree.textStart + tree.textLength - 1;
+    int n = tree.root;
+    depth = 0;
+    int idx = 0;
+    int m = pattern.length();
+
+    while (idx < m) {
+        int child = findChild(n, pattern[idx]);
+        if (child < 0) return -1;
+
+        int edgeLen = edgeLength(child, leafEnd);
+        int start = nodes[child].start;
+        for (int i = 1; i < edgeLen && idx + i < m; i++) {
+            if (text[start + i] != pattern[idx + i]) return -1;
+        }
+        n = child;
+        depth += edgeLen;
+        idx += edgeLen;
+    }
+    return n;
+}
+
+bool SuffixForest::search(int tree, std::string_view pattern) const {
+    int depth;
+    return locate(trees[tree], pattern, depth) >= 0;
+}
+
+std::vector<int> SuffixForest::findAll(int tree, std::string_view pattern) const {
+    std::vector<int> positions;
+    const ForestTree &t = trees[tree];
+    int depth;
+    int locus = locate(t, pattern, depth);
+    if (locus < 0) return positions;
+
+    // A leaf at string depth d starts at (tree end) - d, relative to the record
+    int leafEnd = t.textStart + t.textLength - 1;
+    std::vector<std::pair<int, int>> stack = {{locus, depth}};
+    while (!stack.empty()) {
+        auto [n, d] = stack.back();
+        stack.pop_back();
+        if (nodes[n].childCount == 0) {
+            positions.push_back(t.textLength - d);
+            continue;
+        }
+        for (int i = 0; i < nodes[n].childCount; i++) {
+            int child = childPool[nodes[n].children + i];
+            stack.push_back({child, d + edgeLength(child, leafEnd)});
+        }
+    }
+    return positions;
+}
+
+int SuffixForest::count(int tree, std::string_view pattern) const {
+    const ForestTree &t = trees[tree];
+    int depth;
+    int locus = locate(t, pattern, depth);
+    if (locus < 0) return 0;
+
+    int leaves = 0;
+    std::vector<int> stack = {locus};
+    while (!stack.empty()) {
+        int n = stack.back();
+        stack.pop_back();
+        if (nodes[n].childCount == 0) {
+            leaves++;
+            continue;
+        }
+        for (int i = 0; i < nodes[n].childCount; i++) {
+            stack.push_back(childPool[nodes[n].children + i]);
+        }
+    }
+    return leaves;
+}
+
+std::vector<int> SuffixForest::searchAll(std::string_view pattern) const {
+    std::vector<int> matches;
+    for (int t = 0; t < size(); t++) {
+        if (search(t, pattern)) matches.push_back(t);
+    }
+    return matches;
+}
+
+// --- Visualization ---
+
+void SuffixForest::printTree(int tree) const {
+    std::cout << "\n--- Suffix Tree Structure (Forest tree " << tree << ") ---\n";
+    printRecursive(trees[tree], trees[tree].root, 0);
+    std::cout << "-----------------------------\n";
+}
+
+void SuffixForest::printRecursive(const ForestTree &tree, int n, int depth) const {
+    int leafEnd = tree.textStart + tree.textLength - 1;
+    const ForestNode &node = nodes[n];
+
+    if (node.start >= 0) {
+        for (int i = 0; i < depth; i++) std::cout << "  ";
+
+        // Positions are printed relative to the record
+        int end = (node.end == LEAF_END) ? leafEnd : node.end;
+        std::cout << "Edge [" << node.start - tree.textStart << "," << end - tree.textStart << "]: ";
+        std::cout << std::string_view(text).substr(node.start, end - node.start + 1);
+        std::cout << " (Node " << n - tree.root << ")" << std::endl;
+    } else {
+        std::cout << "Root (Node 0)" << std::endl;
+    }
+
+    for (int i = 0; i < node.childCount; i++) {
+        printRecursive(tree, childPool[node.children + i], depth + 1);
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef SUFFIX_FOREST_H
+#define SUFFIX_FOREST_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Node structure for the Suffix Forest.
+ * Nodes of all trees live in one shared array and refer to each other by
+ * index, so a node costs 20 bytes and no separate allocation.
+ */
+struct ForestNode {
+    // [start, end] into the shared text buffer. Leaves store LEAF_END and
+    // implicitly end at their tree's last character.
+    int start;
+    int end;
+
+    int suffixLink;   // Index of the suffix link target
+
+    // Child edges sorted by first character, as in SuffixTree: slots
+    // [children, children + childCount) of the forest's child pool hold
+    // the child indices, the same slots of the key pool their first bytes
+    int children;     // -1 if none
+    uint16_t childCount;
+    uint16_t childCapacity;
+};
+
+/**
+ * Per-tree header: where the record lives in the shared text buffer and
+ * where its nodes live in the shared node array.
+ */
+struct ForestTree {
+    int textStart;   // Offset of the record in the shared buffer
+    int textLength;  // Record length including the '$' terminator
+    int root;        // Index of the root node
+    int nodeCount;   // Nodes [root, root + nodeCount) belong to this tree
+};
+
+/**
+ * SuffixForest: many small suffix trees (one per short record) built into
+ * one shared node arena and one shared text buffer.
+ *
+ * Per-tree overhead is a 16-byte header; there is no per-tree or per-node
+ * heap allocation, so building and destroying a batch costs a handful of
+ * amortized vector growths instead of one allocation per node.
+ */
+class SuffixForest {
+public:
+    SuffixForest() { clear(); }
+
+    // Builds one tree per record
+    explicit SuffixForest(const std::vector<std::string> &records);
+
+    // Builds a tree for 'record' and returns its tree ID
+    int add(std::string_view record);
+
+    // Pre-sizes the shared buffers for a batch
+    void reserve(size_t records, size_t totalChars);
+
+    // Drops all trees but keeps the buffers' capacity for the next batch
+    void clear();
+
+    // Queries against a single tree (positions are relative to the record)
+    bool search(int tree, std::string_view pattern) const;
+    std::vector<int> findAll(int tree, std::string_view pattern) const;
+    int count(int tree, std::string_view pattern) const;
+
+    // IDs of all trees whose record contains 'pattern'
+    std::vector<int> searchAll(std::string_view pattern) const;
+
+    void printTree(int tree) const;
+
+    int size() const { return (int)trees.size(); }
+    int getNodeCount() const { return (int)nodes.size(); }
+    int getNodeCount(int tree) const { return trees[tree].nodeCount; }
+
+private:
+    static constexpr int LEAF_END = -1;
+
+    static constexpr int CHILD_CLASSES = 9; // Capacities 1 .. 256
+
+    std::string text;               // All records, each terminated by '$'
+    std::vector<ForestNode> nodes;  // All nodes of all trees
+    std::vector<ForestTree> trees;
+
+    // Child arrays of all nodes. A full array moves to one of twice the
+    // capacity; the old one is chained (through its first slot) on the
+    // free list of its size class and reused by the next node that grows.
+    std::vector<int> childPool;
+    std::vector<unsigned char> keyPool;
+    int freeChildArrays[CHILD_CLASSES];
+
+    int newNode(int start, int end, int root);
+    int edgeLength(int n, int leafEnd) const;
+    int findChild(int n, char c) const;
+    void addChild(int parent, int child);
+    void replaceChild(int parent, int oldChild, int newChild);
+
+    // Returns the node at or below the end of the pattern's path in 'tree'
+    // (-1 if absent) and its string depth.
+    int locate(const ForestTree &tree, std::string_view pattern, int &depth) const;
+
+    void printRecursive(const ForestTree &tree, int n, int depth) const;
+};
+
+#endif // SUFFIX_FOREST_H
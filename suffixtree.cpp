@@ -6,8 +6,398 @@
  */ 
 
 #include "suffixtree.h"
+#include "reclaimer.h"
+#include "thread_pool.h"
+#include "wavelet_matrix.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#if __has_include(<fcntl.h>)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+SuffixTree::SuffixTree(std::string t) : SuffixTree(std::move(t), ByteFolding()) {}
+
+SuffixTree::SuffixTree(std::string t, const ByteFolding &f) : text(std::move(t)), folding(f) {
+    build();
+}
+
+SuffixTree::SuffixTree(std::string t, const ByteFolding &f, bool buildNow) : text(std::move(t)), folding(f) {
+    if (buildNow) build();
+}
+
+SuffixTree::SuffixTree() : SuffixTree(ByteFolding()) {}
+
+SuffixTree::SuffixTree(const ByteFolding &f) : folding(f) {
+    // Open tree: the text arrives through append() and finish()
+    size = 0;
+    terminated = false;
+    resetState();
+}
+
+/**
+ * append:
+ * Online extension. Every new character runs one Ukkonen phase, so after
+ * the call the tree is the implicit suffix tree of all text so far.
+ */
+void SuffixTree::append(std::string_view chunk) {
+    if (terminated) return;
+    // Positions are ints: keep room for the '$' that finish() adds
+    if (chunk.size() >= (size_t)INT_MAX - text.size()) {
+        throw std::length_error("SuffixTree::append: text exceeds 2 GiB");
+    }
+    if (!root) resetState();
+    if (cache) cache->invalidate();
+    leaves.reset();
+    disableOccurrenceBounds();
+
+    int old = text.size();
+    text.append(chunk.data(), chunk.size());
+    folding.apply(text.data() + old, text.data() + old, chunk.size());
+    size = text.length();
+
+    for (int i = old; i < size; i++) {
+        extend(i);
+    }
+    updateFilter(old);
+    if (fingerprints) fingerprints->extend(text.data() + old, size - old);
+}
+
+void SuffixTree::finish() {
+    if (terminated) return;
+    if (cache) cache->invalidate();
+    leaves.reset();
+    disableOccurrenceBounds();
+
+    // Same convention as the constructor: add '$' unless already there
+    if (text.empty() || text.back() != '$') {
+        text += "$";
+        size = text.length();
+        extend(size - 1);
+        updateFilter(size - 1);
+        if (fingerprints) fingerprints->extend(text.data() + size - 1, 1);
+    }
+    terminated = true;
+}
+
+SuffixTree::SuffixTree(SuffixTree &&other) noexcept : text(std::move(other.text)), folding(other.folding) {
+    takeFrom(other);
+}
+
+SuffixTree& SuffixTree::operator=(SuffixTree &&other) noexcept {
+    if (this != &other) {
+        text = std::move(other.text);
+        folding = other.folding;
+        takeFrom(other);
+    }
+    return *this;
+}
+
+/**
+ * takeFrom:
+ * Every node, child array and the leaf end live in the arena, so moving
+ * the arena's block list moves the whole tree; no pointer changes.
+ */
+void SuffixTree::takeFrom(SuffixTree &other) {
+    arena = std::move(other.arena);
+    heat = std::move(other.heat);
+    cache = std::move(other.cache);
+    filter = std::move(other.filter);
+    fingerprints = std::move(other.fingerprints);
+    leaves = std::move(other.leaves);
+    positionBounds = std::move(other.positionBounds);
+    root = other.root;
+    for (int k = 0; k < CHILD_CLASSES; k++) freeChildArrays[k] = other.freeChildArrays[k];
+    freeNodes = other.freeNodes;
+    hotRegion = other.hotRegion;
+    hotRegionBytes = other.hotRegionBytes;
+    activeNode = other.activeNode;
+    activeEdge = other.activeEdge;
+    activeLength = other.activeLength;
+    remainder = other.remainder;
+    phasePos = other.phasePos;
+    lastNewNode = other.lastNewNode;
+    leafEnd = other.leafEnd;
+    size = other.size;
+    terminated = other.terminated;
+    nodeCount = other.nodeCount;
+
+    other.clearState();
+}
+
+// No root and no text: every query finds nothing until a rebuild
+void SuffixTree::clearState() {
+    text.clear();
+    root = activeNode = lastNewNode = nullptr;
+    leafEnd = nullptr;
+    for (int k = 0; k < CHILD_CLASSES; k++) freeChildArrays[k] = nullptr;
+    freeNodes = hotRegion = nullptr;
+    hotRegionBytes = 0;
+    remainder = activeLength = size = nodeCount = 0;
+    terminated = true;
+}
+
+/**
+ * clone:
+ * Copies the arena block by block and then rebases the pointers stored in
+ * the copy (node ends, suffix links, child arrays, free lists) from the
+ * source blocks to the new ones. No node is allocated individually.
+ */
+SuffixTree SuffixTree::clone() const {
+    SuffixTree copy(text, folding, false);
+    std::vector<Arena::Relocation> moved;
+    copy.arena = arena.clone(moved);
+
+    copy.root = root;
+    copy.activeNode = activeNode;
+    copy.lastNewNode = lastNewNode;
+    copy.leafEnd = leafEnd;
+    for (int k = 0; k < CHILD_CLASSES; k++) copy.freeChildArrays[k] = freeChildArrays[k];
+    copy.activeEdge = activeEdge;
+    copy.activeLength = activeLength;
+    copy.remainder = remainder;
+    copy.phasePos = phasePos;
+    copy.size = size;
+    copy.terminated = terminated;
+    copy.nodeCount = nodeCount;
+
+    copy.relocateAll(moved);
+    return copy;
+}
+
+/**
+ * relocateAll:
+ * The arena's contents were copied from other blocks (clone() or load()),
+ * so every stored pointer still refers to the old blocks. Rebases the
+ * tree's own pointers, the free lists and every node's pointers.
+ *
+ * For load() these pointers come from a file, so each one is checked to
+ * land inside the arena (Arena::relocate), every node must be reached
+ * exactly once and edges must lie within the text; anything else throws
+ * std::runtime_error before a query can follow a bad pointer.
+ */
+void SuffixTree::relocateAll(const std::vector<Arena::Relocation> &moved) {
+    auto rebase = [&moved](auto *p) { return Arena::relocate(p, moved); };
+    auto corrupt = [] { throw std::runtime_error("SuffixTree::load: corrupt snapshot"); };
+    auto childBytes = [](int capacity) { return capacity * (sizeof(Node*) + 1); };
+
+    root = rebase(root);
+    activeNode = rebase(activeNode);
+    lastNewNode = rebase(lastNewNode);
+    leafEnd = rebase(leafEnd);
+    if (!root) return; // Moved-from: nothing else is in use
+    if (!leafEnd || !activeNode || nodeCount <= 0) corrupt();
+
+    // Free child arrays are chained through their first word. Every array
+    // holds distinct arena bytes, which bounds a list that loops back.
+    size_t arenaBytes = 0;
+    for (const Arena::Relocation &r : moved) arenaBytes += r.size;
+    for (int k = 0; k < CHILD_CLASSES; k++) {
+        size_t bytes = childBytes(1 << k);
+        freeChildArrays[k] = Arena::relocate((Node**)freeChildArrays[k], moved, bytes);
+        size_t length = 0;
+        for (void **a = (void**)freeChildArrays[k]; a; a = (void**)*a) {
+            if (++length > arenaBytes / bytes) corrupt();
+            *a = Arena::relocate((Node**)*a, moved, bytes);
+        }
+    }
+
+    std::vector<bool> seen(nodeCount);
+    std::vector<Node*> stack{root};
+    while (!stack.empty()) {
+        Node *n = stack.back();
+        stack.pop_back();
+        if (n->id < 0 || n->id >= nodeCount || seen[n->id]) corrupt();
+        seen[n->id] = true;
+
+        int capacity = n->childCapacity;
+        if (n->childCount > capacity || capacity > 256 || (capacity & (capacity - 1))) corrupt();
+        n->end = rebase(n->end);
+        n->suffixLink = rebase(n->suffixLink);
+        n->children = Arena::relocate(n->children, moved, childBytes(capacity));
+        if (!n->end || (n->childCount && !n->children)) corrupt();
+        if (n != root && (n->start < 0 || *n->end < n->start || *n->end >= (int)text.size())) corrupt();
+        for (int i = 0; i < n->childCount; i++) {
+            n->children[i] = rebase(n->children[i]);
+            if (!n->children[i]) corrupt();
+            stack.push_back(n->children[i]);
+        }
+    }
+}
+
+// --- Serialization ---
+
+static const char SNAPSHOT_MAGIC[8] = {'U', 'K', 'S', 'T', 'R', 'E', 'E', '2'};
+
+template <typename T>
+static void writeValue(std::ostream &out, const T &value) {
+    out.write((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+static void readValue(std::istream &in, T &value) {
+    if (!in.read((char*)&value, sizeof(T))) {
+        throw std::runtime_error("SuffixTree::load: truncated snapshot");
+    }
+}
+
+/**
+ * save:
+ * Writes the text, the folding table, the construction state and the
+ * arena blocks as they are in memory. Pointers are written unchanged and
+ * rebased by load() exactly as clone() does, so loading costs one read per
+ * block plus one pass over the nodes, with no rebuild. The format is for
+ * the same build on the same architecture.
+ */
+void SuffixTree::save(std::ostream &out) const {
+    out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    writeValue(out, (uint64_t)text.size());
+    out.write(text.data(), text.size());
+
+    uint8_t kind = folding.isIdentity() ? 0
+                 : folding.getTable() == ByteFolding::asciiCaseFold().getTable() ? 1 : 2;
+    writeValue(out, kind);
+    out.write((const char*)folding.getTable().data(), 256);
+
+    writeValue(out, size);
+    writeValue(out, terminated);
+    writeValue(out, nodeCount);
+    writeValue(out, activeEdge);
+    writeValue(out, activeLength);
+    writeValue(out, remainder);
+    writeValue(out, phasePos);
+    writeValue(out, root);
+    writeValue(out, activeNode);
+    writeValue(out, lastNewNode);
+    writeValue(out, leafEnd);
+    for (int k = 0; k < CHILD_CLASSES; k++) writeValue(out, freeChildArrays[k]);
+
+    arena.write(out);
+}
+
+SuffixTree SuffixTree::readSnapshotHeader(std::istream &in) {
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), SNAPSHOT_MAGIC)) {
+        throw std::runtime_error("SuffixTree::load: not a suffix tree snapshot");
+    }
+    uint64_t length;
+    readValue(in, length);
+    if (length >= INT_MAX) throw std::runtime_error("SuffixTree::load: corrupt snapshot");
+    // Grown as bytes arrive, so a damaged length cannot allocate more than
+    // the stream holds
+    std::string t;
+    while (t.size() < length) {
+        size_t from = t.size();
+        t.resize(std::min<uint64_t>(length, from + (1 << 20)));
+        if (!in.read(&t[from], t.size() - from)) {
+            throw std::runtime_error("SuffixTree::load: truncated snapshot");
+        }
+    }
+
+    uint8_t kind;
+    std::array<uint8_t, 256> table;
+    readValue(in, kind);
+    readValue(in, table);
+    ByteFolding f = kind == 0 ? ByteFolding() : kind == 1 ? ByteFolding::asciiCaseFold() : ByteFolding::fromTable(table);
+
+    SuffixTree tree(std::move(t), f, false);
+    readValue(in, tree.size);
+    readValue(in, tree.terminated);
+    readValue(in, tree.nodeCount);
+    readValue(in, tree.activeEdge);
+    readValue(in, tree.activeLength);
+    readValue(in, tree.remainder);
+    readValue(in, tree.phasePos);
+    readValue(in, tree.root);
+    readValue(in, tree.activeNode);
+    readValue(in, tree.lastNewNode);
+    readValue(in, tree.leafEnd);
+    for (int k = 0; k < CHILD_CLASSES; k++) readValue(in, tree.freeChildArrays[k]);
+    return tree;
+}
+
+SuffixTree SuffixTree::load(std::istream &in) {
+    SuffixTree tree = readSnapshotHeader(in);
+    std::vector<Arena::Relocation> moved;
+    if (!Arena::read(in, tree.arena, moved)) {
+        throw std::runtime_error("SuffixTree::load: truncated snapshot");
+    }
+    tree.relocateAll(moved);
+    return tree;
+}
+
+SuffixTree SuffixTree::loadMapped(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("SuffixTree::loadMapped: cannot open " + path);
+    SuffixTree tree = readSnapshotHeader(in);
+    std::streamoff arenaStart = in.tellg();
+
+#if __has_include(<fcntl.h>)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        bool mapped = Arena::mapFile(fd, arenaStart, tree.arena);
+        ::close(fd); // Mappings outlive the descriptor
+        if (mapped) return tree;
+    }
+#endif
+    std::vector<Arena::Relocation> moved;
+    if (!Arena::read(in, tree.arena, moved)) {
+        throw std::runtime_error("SuffixTree::load: truncated snapshot");
+    }
+    tree.relocateAll(moved);
+    return tree;
+}
+
+void SuffixTree::rebuild(std::string_view newText) {
+    // Keep the text buffer's capacity: reserve() only ever grows it
+    text.reserve(newText.size() + 1);
+    text.assign(newText.data(), newText.size());
+
+    // All nodes and child arrays of the previous build die here; their
+    // memory is handed out again by the arena.
+    arena.rewind();
+    build();
+}
+
+void SuffixTree::releaseAsync() {
+    // Only ownership moves here; the blocks are freed on the reclaimer
+    // thread. Nothing is allocated: the tree is left like a moved-from one.
+    Reclaimer::instance().dispose(std::move(arena));
+    Reclaimer::instance().dispose(std::move(text));
+    // Accelerators describing the old tree go too, as after append()
+    if (leaves) Reclaimer::instance().dispose(std::move(leaves));
+    if (!positionBounds.empty()) Reclaimer::instance().dispose(std::move(positionBounds));
+    positionBounds.clear();
+    if (cache) cache->invalidate();
+    clearState();
+}
+
+void SuffixTree::build() {
+    prepare();
+
+    // Build the tree character by character
+    for (int i = 0; i < size; i++) {
+        extend(i);
+    }
+    if (filter) filter->build(text.data(), text.size());
+    if (fingerprints) {
+        fingerprints->clear();
+        fingerprints->extend(text.data(), text.size());
+    }
+    if (leaves) buildLeafIndex();
+    if (!positionBounds.empty()) buildOccurrenceBounds();
+}
+
+void SuffixTree::prepare() {
+    // Fold the owned buffer in place with the vectorized transform. The
+    // mapping is byte-for-byte, so positions still refer to the original text.
+    folding.apply(text);
 
-SuffixTree::SuffixTree(std::string t) : text(t) {
     // Append a unique terminal character usually, but here we assume 
     // the user might handle it or we process raw text. 
     // Ideally, append '$' if not present for proper suffix counting.
@@ -15,47 +405,124 @@ SuffixTree::SuffixTree(std::string t) : text(t) {
         text += "$";
     }
     size = text.length();
+    terminated = true;
+
+    resetState();
+}
+
+void SuffixTree::resetState() {
+    // Node IDs are about to be reused: counts of the old tree are stale
+    if (heat) setHeatSampling(true);
+    if (cache) cache->invalidate();
 
     // Initialize state
     nodeCount = 0;
-    leafEnd = -1;
-    rootEnd = new int(-1); // Root's end doesn't matter much, usually -1
+    leafEnd = arena.create<int>(-1);
+    for (int k = 0; k < CHILD_CLASSES; k++) freeChildArrays[k] = nullptr;
+    freeNodes = hotRegion = nullptr;
+    hotRegionBytes = 0;
     
-    // Create Root
-    root = newNode(-1, rootEnd);
+    // Create Root (its end is its own endValue, which stays -1)
+    root = newNode(-1, nullptr);
+    root->end = &root->endValue;
     root->suffixLink = root; // Root's suffix link points to itself
     
     activeNode = root;
     activeEdge = -1;
     activeLength = 0;
     remainder = 0;
-
-    // Build the tree character by character
-    for (int i = 0; i < size; i++) {
-        extend(i);
-    }
+    phasePos = -1; // The first phase adds position 0
+    lastNewNode = nullptr;
 }
 
 SuffixTree::~SuffixTree() {
-    freeSuffixTreeByPostOrder(root);
-    delete rootEnd;
+    // Nodes are trivially destructible; the arena frees its blocks.
 }
 
 Node* SuffixTree::newNode(int start, int *end) {
-    Node *node = new Node(start, end, nodeCount++);
+    Node *node;
+    if (freeNodes) {
+        void *slot = freeNodes;
+        freeNodes = *(void**)slot;
+        node = new (slot) Node(start, end, nodeCount++);
+    } else {
+        node = arena.create<Node>(start, end, nodeCount++);
+    }
     node->suffixLink = root; // Default to root
     return node;
 }
 
-void SuffixTree::freeSuffixTreeByPostOrder(Node *n) {
-    if (!n) return;
-    for (auto const& [key, child] : n->children) {
-        freeSuffixTreeByPostOrder(child);
+// --- Sorted Child Arrays ---
+
+Node* SuffixTree::findChild(Node *n, char c) const {
+    const unsigned char *keys = n->keys();
+    unsigned char key = (unsigned char)c;
+    int lo = 0, hi = n->childCount;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (keys[mid] < key) lo = mid + 1;
+        else hi = mid;
     }
-    if (n->end != &leafEnd && n->end != rootEnd) {
-        delete n->end; // Delete allocated int for internal nodes
+    return (lo < n->childCount && keys[lo] == key) ? n->children[lo] : nullptr;
+}
+
+Node** SuffixTree::takeChildArray(int capacity) {
+    int cls = __builtin_ctz(capacity);
+    if (void *array = freeChildArrays[cls]) {
+        freeChildArrays[cls] = *(void**)array;
+        return (Node**)array;
+    }
+    return (Node**)arena.allocate(capacity * (sizeof(Node*) + 1), alignof(Node*));
+}
+
+/**
+ * addChild:
+ * Inserts 'child' under key 'c', keeping keys sorted. A full array is
+ * moved to one of twice the capacity and the old one is pushed on the free
+ * list for its size class, so arrays are recycled within a build.
+ */
+void SuffixTree::addChild(Node *n, char c, Node *child) {
+    if (n->childCount == n->childCapacity) {
+        int capacity = n->childCapacity ? n->childCapacity * 2 : 2;
+        Node **grown = takeChildArray(capacity);
+
+        // Pointers then keys, as described by Node::keys()
+        unsigned char *oldKeys = n->keys();
+        for (int i = 0; i < n->childCount; i++) {
+            grown[i] = n->children[i];
+            ((unsigned char*)(grown + capacity))[i] = oldKeys[i];
+        }
+        // Arrays in the hot region are reclaimed when it is rewritten
+        if (n->children && !inHotRegion(n->children)) {
+            int oldCls = __builtin_ctz(n->childCapacity);
+            *(void**)n->children = freeChildArrays[oldCls];
+            freeChildArrays[oldCls] = n->children;
+        }
+        n->children = grown;
+        n->childCapacity = capacity;
+    }
+
+    unsigned char *keys = n->keys();
+    unsigned char key = (unsigned char)c;
+    int i = n->childCount;
+    while (i > 0 && keys[i - 1] > key) {
+        keys[i] = keys[i - 1];
+        n->children[i] = n->children[i - 1];
+        i--;
+    }
+    keys[i] = key;
+    n->children[i] = child;
+    n->childCount++;
+}
+
+void SuffixTree::replaceChild(Node *n, char c, Node *child) {
+    unsigned char *keys = n->keys();
+    for (int i = 0; i < n->childCount; i++) {
+        if (keys[i] == (unsigned char)c) {
+            n->children[i] = child;
+            return;
+        }
     }
-    delete n;
 }
 
 int SuffixTree::edgeLength(Node *n) {
@@ -84,103 +551,226 @@ bool SuffixTree::walkDown(Node *n) {
  * The heart of Ukkonen's algorithm. Adds character at text[pos] to the tree.
  */
 void SuffixTree::extend(int pos) {
+    beginPhase(pos);
+    while (step()) {}
+}
+
+void SuffixTree::beginPhase(int pos) {
     // Rule 1: Extension. We increment the global leafEnd.
-    // All leaf nodes' edges (which point to &leafEnd) automatically extend by 1.
-    leafEnd = pos;
+    // All leaf nodes' edges (which point to leafEnd) automatically extend by 1.
+    *leafEnd = pos;
+    phasePos = pos;
     
     // We have one more suffix to add (the one ending at 'pos')
     remainder++;
     
-    Node *lastNewNode = nullptr; // To handle suffix links creation
+    lastNewNode = nullptr; // To handle suffix links creation
+}
 
-    while (remainder > 0) {
-        // If activeLength is 0, look for the current character from activeNode
-        if (activeLength == 0) {
-            activeEdge = pos;
-        }
+/**
+ * step:
+ * One iteration of the phase loop: inserts (at most) one suffix or walks
+ * down one edge. Returns false once the phase is complete. Kept separate
+ * from extend() so that several trees can be advanced in lockstep; the
+ * second form takes the child prefetchChild() already looked up.
+ */
+bool SuffixTree::step() {
+    if (remainder == 0) return false;
 
-        // Identify the next node/edge we are looking at
-        char currentEdgeChar = text[activeEdge];
-        
-        // If there is no edge starting with this character from activeNode
-        if (activeNode->children.find(currentEdgeChar) == activeNode->children.end()) {
-            // Rule 2: Create a new leaf node
-            activeNode->children[currentEdgeChar] = newNode(pos, &leafEnd);
+    // If activeLength is 0, look for the current character from activeNode
+    if (activeLength == 0) {
+        activeEdge = phasePos;
+    }
+    return step(findChild(activeNode, text[activeEdge]));
+}
 
-            // If we created a new internal node in the previous step, link it here
-            if (lastNewNode != nullptr) {
+bool SuffixTree::step(Node *next) {
+    if (remainder == 0) return false;
+    int pos = phasePos;
+    if (activeLength == 0) {
+        activeEdge = pos;
+    }
+
+    // Identify the next node/edge we are looking at
+    char currentEdgeChar = text[activeEdge];
+
+    // If there is no edge starting with this character from activeNode
+    if (next == nullptr) {
+        // Rule 2: Create a new leaf node
+        addChild(activeNode, currentEdgeChar, newNode(pos, leafEnd));
+
+        // If we created a new internal node in the previous step, link it here
+        if (lastNewNode != nullptr) {
+            lastNewNode->suffixLink = activeNode;
+            lastNewNode = nullptr;
+        }
+    } 
+    else {
+        // There is an edge. Let's see if we need to walk down it.
+        if (walkDown(next)) {
+            // We walked down, start loop again from new activeNode
+            return true; 
+        }
+
+        // We are inside an edge. Check if the character matches.
+        // Edge starts at next->start. We want the character at index: start + activeLength
+        if (text[next->start + activeLength] == text[pos]) {
+            // Rule 3: Character matches. Current suffix exists implicitly.
+            // We increment activeLength and STOP processing this phase (showstopper).
+            
+            if (lastNewNode != nullptr && activeNode != root) {
                 lastNewNode->suffixLink = activeNode;
                 lastNewNode = nullptr;
             }
-        } 
-        else {
-            // There is an edge. Let's see if we need to walk down it.
-            Node *next = activeNode->children[currentEdgeChar];
             
-            if (walkDown(next)) {
-                // We walked down, start loop again from new activeNode
-                continue; 
-            }
-
-            // We are inside an edge. Check if the character matches.
-            // Edge starts at next->start. We want the character at index: start + activeLength
-            if (text[next->start + activeLength] == text[pos]) {
-                // Rule 3: Character matches. Current suffix exists implicitly.
-                // We increment activeLength and STOP processing this phase (showstopper).
-                
-                if (lastNewNode != nullptr && activeNode != root) {
-                    lastNewNode->suffixLink = activeNode;
-                    lastNewNode = nullptr;
-                }
-                
-                activeLength++;
-                break; // Stop the while loop, proceed to next character in text
-            }
+            activeLength++;
+            return false; // Stop the phase, proceed to next character in text
+        }
 
-            // Rule 2 (Split): Character mismatch. 
-            // We must split the edge and create a new internal node.
-            
-            // 1. Create the internal split node
-            // The split point is at 'next->start + activeLength - 1'
-            int *splitEnd = new int(next->start + activeLength - 1);
-            Node *split = newNode(next->start, splitEnd);
-            
-            // Replace the old full edge with the split edge in activeNode
-            activeNode->children[currentEdgeChar] = split;
+        // Rule 2 (Split): Character mismatch. 
+        // We must split the edge and create a new internal node.
+        
+        // 1. Create the internal split node
+        // The split point is at 'next->start + activeLength - 1'
+        Node *split = newNode(next->start, nullptr);
+        split->endValue = next->start + activeLength - 1;
+        split->end = &split->endValue;
+        
+        // Replace the old full edge with the split edge in activeNode
+        replaceChild(activeNode, currentEdgeChar, split);
 
-            // 2. Adjust the old node (next) to be a child of the split node
-            next->start += activeLength; // Push start forward
-            split->children[text[next->start]] = next;
+        // 2. Adjust the old node (next) to be a child of the split node
+        next->start += activeLength; // Push start forward
+        addChild(split, text[next->start], next);
 
-            // 3. Create a new leaf node for the current character being added
-            split->children[text[pos]] = newNode(pos, &leafEnd);
+        // 3. Create a new leaf node for the current character being added
+        addChild(split, text[pos], newNode(pos, leafEnd));
 
-            // 4. Maintenance of Suffix Links
-            if (lastNewNode != nullptr) {
-                lastNewNode->suffixLink = split;
-            }
-            lastNewNode = split;
+        // 4. Maintenance of Suffix Links
+        if (lastNewNode != nullptr) {
+            lastNewNode->suffixLink = split;
         }
+        lastNewNode = split;
+    }
+
+    // Decrement remainder because we successfully added a suffix
+    remainder--;
+
+    // Rule 1 & 3 logic for updating activeNode and activeLength
+    if (activeNode == root && activeLength > 0) {
+        activeLength--;
+        activeEdge = pos - remainder + 1; // Shift to next suffix start
+    } else if (activeNode != root) {
+        // Follow suffix link
+        activeNode = activeNode->suffixLink;
+    }
+    return remainder > 0;
+}
+
+/**
+ * prefetchStep / prefetchChild / prefetchEdge:
+ * Three prefetch stages for what the next step() reads. step() may leave
+ * through a suffix link, so the active node and its child array can be
+ * cold. The child reached through the active edge needs the node's keys,
+ * and that edge's text byte at activeLength needs the child's start. Each
+ * stage only reads what an earlier stage fetched, so buildInterleaved()
+ * runs them on successive lanes instead of stalling on one lane.
+ * prefetchChild() hands the child back for step(node) and returns false
+ * when no step follows.
+ */
+void SuffixTree::prefetchStep() const {
+    __builtin_prefetch(activeNode);
+    __builtin_prefetch(activeNode->children);
+}
+
+bool SuffixTree::prefetchChild(Node *&child) const {
+    // Once a phase ends the next step() starts from position phasePos + 1
+    int edge = activeLength > 0 ? activeEdge : remainder > 0 ? phasePos : phasePos + 1;
+    if (edge >= size) return false;
+    child = findChild(activeNode, text[edge]);
+    if (child) __builtin_prefetch(child);
+    return true;
+}
+
+void SuffixTree::prefetchEdge(const Node *child) const {
+    if (child && child->start + activeLength < size) {
+        __builtin_prefetch(text.data() + child->start + activeLength);
+    }
+}
+
+/**
+ * buildInterleaved:
+ * Keeps up to 'group' constructions in flight and advances them one step
+ * at a time in round-robin order. After each step it issues one prefetch
+ * stage for that lane and later stages for the two lanes before it. The
+ * dependent cache misses of one tree then overlap with the work of the
+ * others. A lane that finishes picks up the next text.
+ */
+std::vector<std::unique_ptr<SuffixTree>> SuffixTree::buildInterleaved(const std::vector<std::string_view> &texts, int group) {
+    std::vector<std::unique_ptr<SuffixTree>> trees(texts.size());
+    if (group < 1) group = 1;
 
-        // Decrement remainder because we successfully added a suffix
-        remainder--;
+    struct Lane {
+        SuffixTree *tree;
+        int pos;        // Next character to add
+        bool inPhase;   // A phase is open and needs more steps
+        Node *child;    // Child found by prefetchChild(), for step()
+        bool childKnown;
+    };
+    std::vector<Lane> lanes;
+    size_t nextText = 0;
 
-        // Rule 1 & 3 logic for updating activeNode and activeLength
-        if (activeNode == root && activeLength > 0) {
-            activeLength--;
-            activeEdge = pos - remainder + 1; // Shift to next suffix start
-        } else if (activeNode != root) {
-            // Follow suffix link
-            activeNode = activeNode->suffixLink;
+    auto startTree = [&](Lane &lane) {
+        trees[nextText].reset(new SuffixTree(std::string(texts[nextText]), ByteFolding(), false));
+        lane = {trees[nextText].get(), 0, false, nullptr, false};
+        lane.tree->prepare();
+        nextText++;
+    };
+
+    while ((int)lanes.size() < group && nextText < texts.size()) {
+        lanes.emplace_back();
+        startTree(lanes.back());
+    }
+
+    while (!lanes.empty()) {
+        for (size_t i = 0; i < lanes.size(); ) {
+            Lane &lane = lanes[i];
+            if (!lane.inPhase) {
+                if (lane.pos == lane.tree->size) {
+                    // Done: refill the lane or retire it
+                    if (nextText < texts.size()) {
+                        startTree(lane);
+                    } else {
+                        lane = lanes.back();
+                        lanes.pop_back();
+                        continue;
+                    }
+                }
+                lane.tree->beginPhase(lane.pos++);
+            }
+            lane.inPhase = lane.childKnown ? lane.tree->step(lane.child) : lane.tree->step();
+            lane.childKnown = false;
+            lane.tree->prefetchStep();
+
+            // The lanes stepped one and two turns ago have had time to
+            // bring in what their next stage reads. No lane steps between
+            // its prefetchChild() and its next step(), so the child found
+            // there is the one that step() would look up.
+            size_t previous = i ? i - 1 : lanes.size() - 1;
+            size_t older = previous ? previous - 1 : lanes.size() - 1;
+            lanes[previous].childKnown = lanes[previous].tree->prefetchChild(lanes[previous].child);
+            if (lanes[older].childKnown) lanes[older].tree->prefetchEdge(lanes[older].child);
+            i++;
         }
     }
+    return trees;
 }
 
 // --- Visualization and Search Helpers ---
 
 void SuffixTree::printTree() {
     std::cout << "\n--- Suffix Tree Structure ---\n";
-    printRecursive(root, 0);
+    if (root) printRecursive(root, 0);
     std::cout << "-----------------------------\n";
 }
 
@@ -201,33 +791,58 @@ void SuffixTree::printRecursive(Node *n, int depth) {
         std::cout << "Root (Node " << n->id << ")" << std::endl;
     }
 
-    if (n->children.empty()) {
+    if (n->isLeaf()) {
         // Leaf node info could go here
         return;
     }
 
-    // Sort keys for consistent printing (map does this automatically)
-    for (auto const& [key, child] : n->children) {
-        printRecursive(child, depth + 1);
+    // Children are kept sorted by key, so printing order is consistent
+    for (int i = 0; i < n->childCount; i++) {
+        printRecursive(n->children[i], depth + 1);
     }
 }
 
 bool SuffixTree::search(std::string pattern) {
+    if (cache) {
+        QueryCache::Result result;
+        uint64_t generation;
+        if (!cache->lookup(QueryCache::Op::Search, pattern, result, generation)) {
+            result.number = searchUncached(pattern);
+            cache->insert(QueryCache::Op::Search, pattern, result, generation);
+        }
+        return result.number != 0;
+    }
+    return searchUncached(std::move(pattern));
+}
+
+bool SuffixTree::searchUncached(std::string pattern) {
     if (pattern.empty()) return true;
-    return searchRecursive(root, pattern, 0);
+    if (!root) return false;
+    folding.apply(pattern);
+    if (filter && !filter->mayContain(pattern.data(), pattern.size())) return false;
+    if (fingerprints && pattern.size() >= FINGERPRINT_MIN_LENGTH) {
+        int depth;
+        return locateByFingerprint(pattern, depth) != nullptr;
+    }
+    std::vector<uint32_t> *visits = heat ? heatCounters() : nullptr;
+    return searchRecursive(root, pattern, 0, visits);
 }
 
-bool SuffixTree::searchRecursive(Node *n, std::string &pattern, int idx) {
+bool SuffixTree::searchRecursive(Node *n, std::string &pattern, int idx, std::vector<uint32_t> *visits) {
     // If we have matched the full pattern, return true
     if (idx >= pattern.length()) return true;
 
     // Determine which edge to take
     char charCode = pattern[idx];
-    if (n->children.find(charCode) == n->children.end()) {
+    Node *child = findChild(n, charCode);
+    if (child == nullptr) {
         return false; // No edge starts with this char
     }
+    if (visits) {
+        if ((size_t)child->id >= visits->size()) visits->resize(nodeCount, 0);
+        (*visits)[child->id]++;
+    }
 
-    Node *child = n->children[charCode];
     int edgeLen = edgeLength(child);
     
     // Match the pattern along this edge
@@ -241,7 +856,7 @@ bool SuffixTree::searchRecursive(Node *n, std::string &pattern, int idx) {
 
     // If we traversed the whole edge, recurse to next node
     if (matchLen == edgeLen) {
-        return searchRecursive(child, pattern, idx + edgeLen);
+        return searchRecursive(child, pattern, idx + edgeLen, visits);
     } 
     // If we finished the pattern inside this edge
     else if (matchLen + idx == pattern.length()) {
@@ -250,4 +865,773 @@ bool SuffixTree::searchRecursive(Node *n, std::string &pattern, int idx) {
     
     // Mismatch inside edge (pattern continues but edge doesn't match)
     return false;
-}
\ No newline at end of file
+}
+
+// --- Occurrence Queries ---
+
+const std::string& SuffixTree::foldQuery(const std::string &pattern, std::string &scratch) const {
+    if (folding.isIdentity()) return pattern;
+    scratch.resize(pattern.size());
+    folding.apply(pattern.data(), scratch.data(), pattern.size());
+    return scratch;
+}
+
+Node* SuffixTree::locate(const std::string &pattern, int &depth) {
+    Node *n = root;
+    depth = 0;
+    if (!n) return nullptr;
+    if (filter && !filter->mayContain(pattern.data(), pattern.size())) return nullptr;
+    if (fingerprints && pattern.size() >= FINGERPRINT_MIN_LENGTH) return locateByFingerprint(pattern, depth);
+    int idx = 0;
+    int m = pattern.length();
+
+    while (idx < m) {
+        Node *child = findChild(n, pattern[idx]);
+        if (child == nullptr) return nullptr;
+
+        int edgeLen = edgeLength(child);
+        for (int i = 0; i < edgeLen && idx + i < m; i++) {
+            if (text[child->start + i] != pattern[idx + i]) return nullptr;
+        }
+
+        // Either the whole edge matched or the pattern ends inside it;
+        // in both cases every leaf below 'child' is an occurrence.
+        n = child;
+        depth += edgeLen;
+        idx += edgeLen;
+    }
+    return n;
+}
+
+/**
+ * locateByFingerprint:
+ * locate() with each edge compared by fingerprint in O(1) instead of byte
+ * by byte. The label of every edge into 'child' below a node of depth d
+ * is preceded in the text by that node's path label, so the text at
+ * child->start - d spells the whole pattern if it occurs: one comparison
+ * there rules out fingerprint collisions.
+ */
+Node* SuffixTree::locateByFingerprint(const std::string &pattern, int &depth) {
+    int m = pattern.length();
+    Node *n = root;
+    depth = 0;
+    int idx = 0;
+    int occurrence = 0;
+    while (idx < m) {
+        Node *child = findChild(n, pattern[idx]);
+        if (child == nullptr) return nullptr;
+
+        int edgeLen = edgeLength(child);
+        int len = std::min(edgeLen, m - idx);
+        if (len < FINGERPRINT_MIN_EDGE) {
+            // A short edge is one cache line of text: cheaper than two
+            // fingerprint lookups
+            if (text.compare(child->start, len, pattern, idx, len) != 0) return nullptr;
+        } else if (fingerprints->substring(child->start, len) != fingerprints->hash(pattern.data() + idx, len)) {
+            return nullptr;
+        }
+
+        occurrence = child->start - idx;
+        n = child;
+        depth += edgeLen;
+        idx += edgeLen;
+    }
+    if (text.compare(occurrence, m, pattern) != 0) return nullptr;
+    return n;
+}
+
+std::vector<int> SuffixTree::findAll(const std::string &pattern) {
+    if (cache) {
+        QueryCache::Result result;
+        uint64_t generation;
+        if (!cache->lookup(QueryCache::Op::FindAll, pattern, result, generation)) {
+            result.positions = findAllUncached(pattern);
+            cache->insert(QueryCache::Op::FindAll, pattern, result, generation);
+        }
+        return std::move(result.positions);
+    }
+    return findAllUncached(pattern);
+}
+
+std::vector<int> SuffixTree::findAllUncached(const std::string &pattern) {
+    std::vector<int> positions;
+    std::string scratch;
+    int depth;
+    Node *locus = locate(foldQuery(pattern, scratch), depth);
+    if (!locus) return positions;
+
+    // Iterative DFS collecting leaves. A leaf at string depth d on an edge
+    // ending at *end represents the suffix starting at *end + 1 - d.
+    std::vector<std::pair<Node*, int>> stack;
+    stack.push_back({locus, depth});
+    while (!stack.empty()) {
+        auto [n, d] = stack.back();
+        stack.pop_back();
+        if (n->isLeaf()) {
+            positions.push_back(*(n->end) + 1 - d);
+            continue;
+        }
+        for (int i = 0; i < n->childCount; i++) {
+            stack.push_back({n->children[i], d + edgeLength(n->children[i])});
+        }
+    }
+    return positions;
+}
+
+int SuffixTree::count(const std::string &pattern) {
+    if (cache) {
+        QueryCache::Result result;
+        uint64_t generation;
+        if (!cache->lookup(QueryCache::Op::Count, pattern, result, generation)) {
+            result.number = countUncached(pattern);
+            cache->insert(QueryCache::Op::Count, pattern, result, generation);
+        }
+        return result.number;
+    }
+    return countUncached(pattern);
+}
+
+int SuffixTree::countUncached(const std::string &pattern) {
+    std::string scratch;
+    int depth;
+    Node *locus = locate(foldQuery(pattern, scratch), depth);
+    if (!locus) return 0;
+
+    int leaves = 0;
+    std::vector<Node*> stack = {locus};
+    while (!stack.empty()) {
+        Node *n = stack.back();
+        stack.pop_back();
+        if (n->isLeaf()) {
+            leaves++;
+            continue;
+        }
+        for (int i = 0; i < n->childCount; i++) {
+            stack.push_back(n->children[i]);
+        }
+    }
+    return leaves;
+}
+
+// --- Query Cache ---
+
+void SuffixTree::enableQueryCache(size_t maxBytes, int shards) {
+    cache = std::make_unique<QueryCache>(maxBytes, shards);
+}
+
+void SuffixTree::disableQueryCache() {
+    cache.reset();
+}
+
+QueryCacheStats SuffixTree::queryCacheStats() const {
+    return cache ? cache->stats() : QueryCacheStats();
+}
+
+// --- q-gram Prefilter ---
+
+void SuffixTree::enableQGramFilter(int q, int bitsPerGram) {
+    filter = std::make_unique<QGramFilter>(q, bitsPerGram);
+    filter->build(text.data(), text.size());
+}
+
+void SuffixTree::disableQGramFilter() {
+    filter.reset();
+}
+
+// Adds the q-grams that end at or after 'firstNew'
+void SuffixTree::updateFilter(int firstNew) {
+    if (!filter) return;
+    if (filter->needsRebuild()) {
+        filter->build(text.data(), text.size());
+        return;
+    }
+    int from = firstNew - filter->getQ() + 1;
+    filter->add(text.data(), from < 0 ? 0 : from, text.size());
+}
+
+std::vector<bool> SuffixTree::searchBatch(const std::vector<std::string> &patterns) {
+    std::vector<bool> found(patterns.size(), false);
+    std::vector<char> candidate(patterns.size(), 1);
+    if (filter) {
+        if (folding.isIdentity()) {
+            filter->mayContainBatch(patterns, candidate);
+        } else {
+            std::vector<std::string> folded(patterns);
+            for (auto &p : folded) folding.apply(p);
+            filter->mayContainBatch(folded, candidate);
+        }
+    }
+    for (size_t i = 0; i < patterns.size(); i++) {
+        if (candidate[i]) found[i] = search(patterns[i]);
+    }
+    return found;
+}
+
+// --- Karp-Rabin Fingerprints ---
+
+void SuffixTree::enableFingerprints() {
+    fingerprints = std::make_unique<PrefixFingerprints>();
+    fingerprints->extend(text.data(), text.size());
+}
+
+void SuffixTree::disableFingerprints() {
+    fingerprints.reset();
+}
+
+// --- Sorted Batch Search ---
+
+// A pattern being sorted: its characters, length and batch index
+struct SortKey {
+    const char *data;
+    uint32_t length;
+    int index;
+};
+
+/**
+ * radixSort:
+ * MSD radix sort of keys[lo, hi) from character 'depth' on. Keys that end
+ * at 'depth' sort first. A prefix shared by the whole range is skipped in
+ * one pass instead of one bucketing pass per character, and small ranges
+ * use insertion sort.
+ */
+static void radixSort(std::vector<SortKey> &keys, size_t lo, size_t hi, size_t depth, std::vector<SortKey> &scratch) {
+    while (hi - lo >= 32) {
+        // Skip the prefix every key in the range shares
+        const SortKey &first = keys[lo];
+        size_t common = first.length > depth ? first.length - depth : 0;
+        for (size_t i = lo + 1; i < hi && common > 0; i++) {
+            const SortKey &k = keys[i];
+            size_t limit = std::min<size_t>(common, k.length > depth ? k.length - depth : 0);
+            size_t c = 0;
+            while (c < limit && k.data[depth + c] == first.data[depth + c]) c++;
+            common = c;
+        }
+        depth += common;
+
+        // Bucket 0: key ended; bucket c + 1: next character c
+        size_t counts[258] = {0};
+        auto bucket = [depth](const SortKey &k) {
+            return depth < k.length ? (unsigned char)k.data[depth] + 1 : 0;
+        };
+        for (size_t i = lo; i < hi; i++) counts[bucket(keys[i]) + 1]++;
+        for (int b = 0; b < 257; b++) counts[b + 1] += counts[b];
+
+        scratch.resize(hi - lo);
+        size_t offsets[258];
+        std::copy(counts, counts + 258, offsets);
+        for (size_t i = lo; i < hi; i++) scratch[offsets[bucket(keys[i])]++] = keys[i];
+        std::copy(scratch.begin(), scratch.begin() + (hi - lo), keys.begin() + lo);
+
+        if (counts[1] == hi - lo) return; // Every key ended here: all equal
+        for (int b = 1; b < 257; b++) {
+            if (counts[b + 1] - counts[b] > 1) {
+                radixSort(keys, lo + counts[b], lo + counts[b + 1], depth + 1, scratch);
+            }
+        }
+        return;
+    }
+
+    for (size_t i = lo + 1; i < hi; i++) {
+        SortKey v = keys[i];
+        std::string_view key(v.data + std::min<size_t>(depth, v.length), v.length - std::min<size_t>(depth, v.length));
+        size_t j = i;
+        while (j > lo) {
+            const SortKey &prev = keys[j - 1];
+            size_t from = std::min<size_t>(depth, prev.length);
+            if (std::string_view(prev.data + from, prev.length - from) <= key) break;
+            keys[j] = prev;
+            j--;
+        }
+        keys[j] = v;
+    }
+}
+
+/**
+ * searchBatchSorted:
+ * After sorting, consecutive patterns share their longest common prefix
+ * (lcp) with the previous one. 'path' keeps the nodes the previous pattern
+ * passed with their string depths, so a pattern resumes at the deepest
+ * node within its lcp instead of the root, and descends the rest of the
+ * known-matching prefix by edge length alone (skip/count). A prefix that
+ * failed fails the whole run of patterns extending it without touching
+ * the tree.
+ */
+std::vector<bool> SuffixTree::searchBatchSorted(const std::vector<std::string> &patterns) {
+    std::vector<bool> found(patterns.size(), false);
+    if (!root) {
+        for (size_t i = 0; i < patterns.size(); i++) found[i] = patterns[i].empty();
+        return found;
+    }
+
+    std::vector<std::string> foldedCopy;
+    if (!folding.isIdentity()) {
+        foldedCopy = patterns;
+        for (auto &p : foldedCopy) folding.apply(p);
+    }
+    const std::vector<std::string> &folded = folding.isIdentity() ? patterns : foldedCopy;
+
+    std::vector<char> candidate(patterns.size(), 1);
+    if (filter) filter->mayContainBatch(folded, candidate);
+
+    std::vector<SortKey> order;
+    order.reserve(patterns.size());
+    for (size_t i = 0; i < patterns.size(); i++) {
+        if (candidate[i]) order.push_back({folded[i].data(), (uint32_t)folded[i].size(), (int)i});
+    }
+    std::vector<SortKey> scratch;
+    radixSort(order, 0, order.size(), 0, scratch);
+
+    std::vector<std::pair<Node*, size_t>> path = {{root, 0}};
+    const SortKey *previous = nullptr;
+    size_t failedAt = SIZE_MAX; // Depth whose character the previous pattern missed
+
+    for (const SortKey &key : order) {
+        const char *p = key.data;
+        size_t m = key.length;
+        size_t lcp = 0;
+        if (previous) {
+            size_t limit = std::min<size_t>(previous->length, m);
+            while (lcp < limit && previous->data[lcp] == p[lcp]) lcp++;
+        }
+        previous = &key;
+
+        if (failedAt < lcp) continue; // Extends the missing prefix: absent as well
+        failedAt = SIZE_MAX;
+        while (path.back().second > lcp) path.pop_back();
+
+        auto [n, d] = path.back();
+        bool matched = true;
+        while (d < m) {
+            Node *child = findChild(n, p[d]);
+            if (!child) {
+                matched = false;
+                failedAt = d;
+                break;
+            }
+            size_t len = edgeLength(child);
+
+            // Characters below lcp are known to match; compare the rest
+            size_t k = lcp > d ? std::min(lcp - d, len) : 1;
+            size_t stop = std::min(len, m - d);
+            for (; k < stop; k++) {
+                if (text[child->start + k] != p[d + k]) break;
+            }
+            if (k < stop) {
+                matched = false;
+                failedAt = d + k;
+                break;
+            }
+            if (d + len > m) break; // Pattern ends inside the edge
+
+            n = child;
+            d += len;
+            path.push_back({n, d});
+        }
+        found[key.index] = matched;
+    }
+    return found;
+}
+
+// --- Heat Sampling and Relayout ---
+
+/**
+ * HeatMap:
+ * One counter array per querying thread, indexed by node ID. A thread
+ * finds its own array through a thread-local cache, so counting a visit is
+ * a plain increment with no atomics and no sharing between threads. The
+ * epoch tells cached entries of an earlier map (or another tree that
+ * happened to reuse this address) apart.
+ */
+struct SuffixTree::HeatMap {
+    struct Slab {
+        std::thread::id owner;
+        std::vector<uint32_t> counts;
+    };
+
+    uint64_t epoch;
+    std::mutex mutex;   // Guards 'slabs' (taken once per thread, not per query)
+    std::vector<std::unique_ptr<Slab>> slabs;
+};
+
+static std::atomic<uint64_t> nextHeatEpoch{1};
+
+void SuffixTree::setHeatSampling(bool enabled) {
+    if (!enabled) {
+        heat.reset();
+        return;
+    }
+    heat = std::make_unique<HeatMap>();
+    heat->epoch = nextHeatEpoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<uint32_t>* SuffixTree::heatCounters() {
+    struct Cache {
+        uint64_t epoch = 0;
+        std::vector<uint32_t> *counts = nullptr;
+    };
+    static thread_local Cache cache;
+    if (cache.epoch == heat->epoch) return cache.counts;
+
+    std::lock_guard<std::mutex> lock(heat->mutex);
+    std::thread::id self = std::this_thread::get_id();
+    HeatMap::Slab *slab = nullptr;
+    for (auto &s : heat->slabs) {
+        if (s->owner == self) slab = s.get();
+    }
+    if (!slab) {
+        heat->slabs.push_back(std::make_unique<HeatMap::Slab>());
+        slab = heat->slabs.back().get();
+        slab->owner = self;
+        slab->counts.assign(nodeCount, 0);
+    }
+    cache = {heat->epoch, &slab->counts};
+    return cache.counts;
+}
+
+/**
+ * relayoutByHeat:
+ * Sums the per-thread counters, picks the hottest nodes and copies each of
+ * them, immediately followed by its child array, into one cache-line
+ * aligned region of the arena in decreasing order of heat (the root and
+ * the top levels first). A single pass over the tree then redirects child
+ * pointers and suffix links to the copies.
+ *
+ * Nothing is left behind for good. The layout is staged in a scratch
+ * buffer and written over the previous region when it fits. Nodes of
+ * that region that cooled down move out first, into slots vacated by
+ * earlier calls. Slots and child arrays the hot nodes leave go to the
+ * free lists. A region that does not fit is replaced by one at least
+ * twice as large, and the old one becomes ordinary slots.
+ */
+int SuffixTree::relayoutByHeat(int maxNodes) {
+    if (!heat || !root || maxNodes <= 0) return 0;
+
+    std::vector<uint64_t> total(nodeCount, 0);
+    for (auto &slab : heat->slabs) {
+        for (size_t id = 0; id < slab->counts.size() && id < total.size(); id++) {
+            total[id] += slab->counts[id];
+        }
+    }
+    total[root->id] = UINT64_MAX; // Every search starts here
+
+    // Map node IDs to nodes
+    std::vector<Node*> byId(nodeCount, nullptr);
+    std::vector<Node*> stack = {root};
+    while (!stack.empty()) {
+        Node *n = stack.back();
+        stack.pop_back();
+        byId[n->id] = n;
+        for (int i = 0; i < n->childCount; i++) stack.push_back(n->children[i]);
+    }
+
+    std::vector<int> hot;
+    for (int id = 0; id < nodeCount; id++) {
+        if (total[id] > 0 && byId[id]) hot.push_back(id);
+    }
+    if ((int)hot.size() > maxNodes) {
+        std::partial_sort(hot.begin(), hot.begin() + maxNodes, hot.end(),
+                          [&](int a, int b) { return total[a] > total[b]; });
+        hot.resize(maxNodes);
+    } else {
+        std::sort(hot.begin(), hot.end(), [&](int a, int b) { return total[a] > total[b]; });
+    }
+
+    // One region for all of them keeps them contiguous
+    auto childBytes = [](const Node *n) { return n->childCapacity * (sizeof(Node*) + 1); };
+    auto roundUp = [](size_t bytes) { return (bytes + alignof(Node) - 1) & ~(alignof(Node) - 1); };
+    size_t regionBytes = 0;
+    for (int id : hot) regionBytes += sizeof(Node) + roundUp(childBytes(byId[id]));
+    bool reuse = regionBytes <= hotRegionBytes;
+    if (!reuse) {
+        hotRegionBytes = std::max(regionBytes, 2 * hotRegionBytes);
+        hotRegion = (char*)arena.allocate(hotRegionBytes, 64);
+    }
+    char *region = hotRegion;
+    auto inRegion = [&](const void *p) { return reuse && inHotRegion(p); };
+
+    // Stage the copies with the addresses they will have in the region
+    std::vector<std::max_align_t> staging((regionBytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t));
+    char *staged = (char*)staging.data();
+    std::vector<Node*> moved(nodeCount, nullptr);
+    size_t offset = 0;
+    for (int id : hot) {
+        Node *old = byId[id];
+        Node *copy = new (staged + offset) Node(*old);
+        Node *placed = (Node*)(region + offset);
+        offset += sizeof(Node);
+        if (old->children) {
+            std::memcpy(staged + offset, old->children, childBytes(old));
+            copy->children = (Node**)(region + offset);
+            offset += roundUp(childBytes(old));
+            if (!inRegion(old->children)) {
+                int cls = __builtin_ctz(old->childCapacity);
+                *(void**)old->children = freeChildArrays[cls];
+                freeChildArrays[cls] = old->children;
+            }
+        }
+        // Internal nodes and the root end at their own endValue
+        if (old->end == &old->endValue) copy->end = &placed->endValue;
+        moved[id] = placed;
+    }
+
+    // Nodes of the region being overwritten that are no longer hot move
+    // out, and the IDs of everything there are kept for the redirect
+    std::vector<std::pair<const Node*, int>> regionIds;
+    if (reuse) {
+        for (int id = 0; id < nodeCount; id++) {
+            Node *old = byId[id];
+            if (!old || !inRegion(old)) continue;
+            regionIds.push_back({old, id});
+            if (moved[id]) continue;
+
+            Node *home;
+            if (freeNodes) {
+                home = (Node*)freeNodes;
+                freeNodes = *(void**)home;
+            } else {
+                home = (Node*)arena.allocate(sizeof(Node), alignof(Node));
+            }
+            new (home) Node(*old);
+            if (inRegion(old->children)) {
+                home->children = takeChildArray(old->childCapacity);
+                std::memcpy(home->children, old->children, childBytes(old));
+            }
+            if (old->end == &old->endValue) home->end = &home->endValue;
+            moved[id] = home;
+        }
+        std::sort(regionIds.begin(), regionIds.end());
+    }
+    std::memcpy(region, staged, regionBytes);
+
+    // Pointers into the region name nodes that were there before the copy
+    auto idOf = [&](const Node *n) {
+        if (!inRegion(n)) return n->id;
+        return std::lower_bound(regionIds.begin(), regionIds.end(), std::make_pair(n, 0))->second;
+    };
+    auto redirect = [&](Node *n) {
+        if (!n) return n;
+        Node *to = moved[idOf(n)];
+        return to ? to : n;
+    };
+    root = redirect(root);
+    activeNode = redirect(activeNode);
+    lastNewNode = redirect(lastNewNode);
+    stack = {root};
+    while (!stack.empty()) {
+        Node *n = stack.back();
+        stack.pop_back();
+        n->suffixLink = redirect(n->suffixLink);
+        for (int i = 0; i < n->childCount; i++) {
+            n->children[i] = redirect(n->children[i]);
+            stack.push_back(n->children[i]);
+        }
+    }
+
+    // Only now is nothing left pointing at the slots the hot nodes left
+    for (int id : hot) {
+        if (!inRegion(byId[id])) {
+            *(void**)byId[id] = freeNodes;
+            freeNodes = byId[id];
+        }
+    }
+
+    setHeatSampling(true);
+    return (int)hot.size();
+}
+
+// --- Range Queries ---
+
+struct SuffixTree::LeafIndex {
+    std::vector<int> first;     // By node ID: DFS rank of the first leaf below
+    std::vector<int> last;      // By node ID: one past the last leaf below
+    WaveletMatrix positions;    // Suffix position of each leaf, in DFS order
+};
+
+/**
+ * buildLeafIndex:
+ * Iterative DFS (deep trees would overflow the call stack) numbering the
+ * leaves in visiting order; each node records the run of ranks below it.
+ */
+void SuffixTree::buildLeafIndex() {
+    auto index = std::make_unique<LeafIndex>();
+    index->first.assign(nodeCount, 0);
+    index->last.assign(nodeCount, 0);
+    std::vector<uint32_t> order;
+    order.reserve(size);
+
+    struct Frame {
+        Node *n;
+        int depth;
+        int next;   // Next child to visit
+    };
+    std::vector<Frame> stack;
+    if (root) stack.push_back({root, 0, 0});
+    while (!stack.empty()) {
+        Frame &f = stack.back();
+        if (f.next == f.n->childCount) {
+            index->last[f.n->id] = order.size();
+            stack.pop_back();
+            continue;
+        }
+        Node *child = f.n->children[f.next++];
+        int depth = f.depth + edgeLength(child);
+        index->first[child->id] = order.size();
+        if (child->isLeaf()) {
+            order.push_back(*(child->end) + 1 - depth);
+            index->last[child->id] = order.size();
+        } else {
+            stack.push_back({child, depth, 0}); // Invalidates f
+        }
+    }
+    index->positions = WaveletMatrix(std::move(order));
+    leaves = std::move(index);
+}
+
+void SuffixTree::enableRangeQueries() {
+    buildLeafIndex();
+}
+
+void SuffixTree::disableRangeQueries() {
+    leaves.reset();
+}
+
+std::vector<int> SuffixTree::findAllInRange(const std::string &pattern, int l, int r) {
+    std::vector<int> positions;
+    int lastStart = std::min(r, size - 1) - (int)pattern.size() + 1;
+    l = std::max(l, 0);
+    if (lastStart < l) return positions;
+
+    if (!leaves) {
+        for (int p : findAll(pattern)) {
+            if (p >= l && p <= lastStart) positions.push_back(p);
+        }
+        std::sort(positions.begin(), positions.end());
+        return positions;
+    }
+
+    std::string scratch;
+    int depth;
+    Node *locus = locate(foldQuery(pattern, scratch), depth);
+    if (!locus) return positions;
+    leaves->positions.listRange(leaves->first[locus->id], leaves->last[locus->id], l, (int64_t)lastStart + 1,
+                                positions);
+    return positions;
+}
+
+int SuffixTree::countInRange(const std::string &pattern, int l, int r) {
+    int lastStart = std::min(r, size - 1) - (int)pattern.size() + 1;
+    l = std::max(l, 0);
+    if (lastStart < l) return 0;
+    if (!leaves) return findAllInRange(pattern, l, r).size();
+
+    std::string scratch;
+    int depth;
+    Node *locus = locate(foldQuery(pattern, scratch), depth);
+    if (!locus) return 0;
+    return leaves->positions.countRange(leaves->first[locus->id], leaves->last[locus->id], l,
+                                        (int64_t)lastStart + 1);
+}
+
+std::vector<int> SuffixTree::findAllSorted(const std::string &pattern, int after, int limit) {
+    std::vector<int> positions;
+    if (limit <= 0) return positions;
+
+    if (!leaves) {
+        for (int p : findAll(pattern)) {
+            if (p > after) positions.push_back(p);
+        }
+        // Only the page needs ordering
+        if ((int)positions.size() > limit) {
+            std::nth_element(positions.begin(), positions.begin() + limit, positions.end());
+            positions.resize(limit);
+        }
+        std::sort(positions.begin(), positions.end());
+        return positions;
+    }
+
+    std::string scratch;
+    int depth;
+    Node *locus = locate(foldQuery(pattern, scratch), depth);
+    if (!locus) return positions;
+    // Range successor: values above 'after' in the locus' leaf run, smallest first
+    leaves->positions.listRange(leaves->first[locus->id], leaves->last[locus->id], (int64_t)after + 1,
+                                (int64_t)size, positions, limit);
+    return positions;
+}
+
+// --- Bottom-Up Annotation ---
+
+/**
+ * planSubtrees:
+ * Expands the tree breadth-first from the root until there are 'target'
+ * internal subtrees to hand out. Suffix trees are shallow at the top and
+ * wide below, so a few levels usually suffice; degenerate (chain-like)
+ * trees stop at a bounded spine and leave the rest to one task.
+ */
+void SuffixTree::planSubtrees(std::vector<std::pair<Node*, int>> &spine,
+                              std::vector<std::pair<Node*, int>> &subtrees, int target) {
+    static constexpr size_t MAX_SPINE = 1 << 16;
+    std::deque<std::pair<Node*, int>> frontier = {{root, 0}};
+    while (!frontier.empty() && (int)frontier.size() < target && spine.size() < MAX_SPINE) {
+        auto [n, depth] = frontier.front();
+        frontier.pop_front();
+        spine.push_back({n, depth});
+        for (int i = 0; i < n->childCount; i++) {
+            Node *child = n->children[i];
+            if (!child->isLeaf()) frontier.push_back({child, depth + edgeLength(child)});
+        }
+    }
+    subtrees.assign(frontier.begin(), frontier.end());
+}
+
+void SuffixTree::runParallel(int tasks, const std::function<void(int)> &task, int threads) {
+    if (tasks <= 1 || threads <= 1) {
+        for (int i = 0; i < tasks; i++) task(i);
+        return;
+    }
+    WorkStealingPool pool(std::min(threads, tasks));
+    for (int i = 0; i < tasks; i++) pool.submit([&task, i] { task(i); });
+    pool.wait();
+}
+
+// --- Occurrence Bounds ---
+
+void SuffixTree::buildOccurrenceBounds() {
+    positionBounds = annotateBottomUp<std::pair<int, int>>(
+        [](int pos) { return std::make_pair(pos, pos); },
+        [](std::pair<int, int> &into, const std::pair<int, int> &child) {
+            into.first = std::min(into.first, child.first);
+            into.second = std::max(into.second, child.second);
+        });
+}
+
+void SuffixTree::enableOccurrenceBounds() {
+    buildOccurrenceBounds();
+}
+
+void SuffixTree::disableOccurrenceBounds() {
+    positionBounds.clear();
+    positionBounds.shrink_to_fit();
+}
+
+int SuffixTree::firstOccurrence(const std::string &pattern) {
+    if (positionBounds.empty()) {
+        std::vector<int> all = findAll(pattern);
+        return all.empty() ? -1 : *std::min_element(all.begin(), all.end());
+    }
+    std::string scratch;
+    int depth;
+    Node *locus = locate(foldQuery(pattern, scratch), depth);
+    return locus ? positionBounds[locus->id].first : -1;
+}
+
+int SuffixTree::lastOccurrence(const std::string &pattern) {
+    if (positionBounds.empty()) {
+        std::vector<int> all = findAll(pattern);
+        return all.empty() ? -1 : *std::max_element(all.begin(), all.end());
+    }
+    std::string scratch;
+    int depth;
+    Node *locus = locate(foldQuery(pattern, scratch), depth);
+    return locus ? positionBounds[locus->id].second : -1;
+}
@@ -9,9 +9,19 @@
 #define SUFFIX_TREE_H
 
 #include <string>
-#include <map>
+#include <string_view>
 #include <vector>
 #include <iostream>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <thread>
+#include "arena.h"
+#include "byte_folding.h"
+#include "query_cache.h"
+#include "qgram_filter.h"
+#include "fingerprint.h"
 
 /**
  * Node structure for the Suffix Tree.
@@ -19,21 +29,30 @@
 struct Node {
     // [start, *end] represents the substring on the edge leading to this node.
     // We use a pointer for 'end' to achieve O(1) extension for leaf nodes (Rule 1).
+    // Internal nodes point 'end' at their own 'endValue'.
     int start;
     int *end;
-
-    // Suffix Link used for fast traversal (Ukkonen's optimization)
-    Node *suffixLink;
+    int endValue;
 
     // Unique ID for visualization/debugging
     int id;
 
-    // Map of characters to child nodes (edges)
-    std::map<char, Node*> children;
+    // Suffix Link used for fast traversal (Ukkonen's optimization)
+    Node *suffixLink;
+
+    // Child edges sorted by first character. One arena block holds
+    // 'childCapacity' child pointers followed by as many key bytes.
+    Node **children;
+    uint16_t childCount;
+    uint16_t childCapacity;
 
     // Constructor
     Node(int start, int *end, int id) 
-        : start(start), end(end), suffixLink(nullptr), id(id) {}
+        : start(start), end(end), endValue(-1), id(id), suffixLink(nullptr),
+          children(nullptr), childCount(0), childCapacity(0) {}
+
+    unsigned char* keys() const { return (unsigned char*)(children + childCapacity); }
+    bool isLeaf() const { return childCount == 0; }
 };
 
 /**
@@ -43,20 +62,231 @@ class SuffixTree {
 public:
     // Constructor: Builds the tree immediately from the text
     SuffixTree(std::string text);
+
+    // Constructor: Folds the text (e.g. ByteFolding::asciiCaseFold()) while
+    // building; queries are folded the same way before matching
+    SuffixTree(std::string text, const ByteFolding &folding);
     
-    // Destructor: Cleans up memory
+    // Constructor: Empty open tree for online construction via append()
+    SuffixTree();
+    explicit SuffixTree(const ByteFolding &folding);
+
+    // Destructor: Cleans up memory. Nodes live in arena blocks, so this
+    // frees a handful of blocks rather than walking the tree.
     ~SuffixTree();
 
+    // Hands node storage and the text to the background Reclaimer and
+    // returns at once, leaving an empty tree with no root (like a
+    // moved-from one): queries find nothing and nothing is allocated until
+    // rebuild(). Range queries and occurrence bounds are dropped, as after
+    // append(). To drop a heap-allocated tree without blocking, use
+    // Reclaimer::instance().dispose(std::move(ptr)).
+    void releaseAsync();
+
+    SuffixTree(const SuffixTree&) = delete;
+    SuffixTree& operator=(const SuffixTree&) = delete;
+
+    // O(1): the arena's blocks change owner. The source is left empty and
+    // may be rebuilt, assigned to or destroyed.
+    SuffixTree(SuffixTree &&other) noexcept;
+    SuffixTree& operator=(SuffixTree &&other) noexcept;
+
+    // Deep copy: one memcpy per arena block plus a pointer-rebasing pass
+    SuffixTree clone() const;
+
+    // Binary snapshot of the built tree (same build and architecture);
+    // load() rebases pointers like clone() instead of rebuilding. Throws
+    // std::runtime_error on a malformed stream: every stored pointer must
+    // land inside the saved node storage and every node be reached once.
+    // Accelerators (cache, filters, fingerprints) are not saved.
+    void save(std::ostream &out) const;
+    static SuffixTree load(std::istream &in);
+
+    // Loads a snapshot file written by save(), mapping its node storage
+    // back at the saved addresses when they are free in this process, so
+    // pages are read on first touch and nothing is rebased. Falls back to
+    // load() otherwise. Throws like load(), or if 'path' cannot be opened.
+    // A mapped snapshot is used as is, without load()'s pointer checks:
+    // only map files this program wrote, and load() untrusted ones.
+    static SuffixTree loadMapped(const std::string &path);
+
+    // Rebuilds the tree over new text, reusing node storage, child arrays
+    // and the text buffer's capacity from previous builds. Once capacities
+    // have grown to fit, rebuilding performs no heap allocation.
+    void rebuild(std::string_view newText);
+
+    // Online construction: extends an open tree with more text. Queries are
+    // valid at any time; search() sees every substring so far, while
+    // findAll()/count() report only suffixes that already end in a leaf
+    // and are exact once finish() has appended the terminator. Throws
+    // std::length_error, leaving the tree unchanged, if the text and its
+    // terminator would no longer fit int positions.
+    void append(std::string_view chunk);
+    void finish();
+    bool isFinished() const { return terminated; }
+
+    // Builds one tree per text, advancing up to 'group' constructions
+    // round-robin on the calling thread so their cache misses overlap
+    static std::vector<std::unique_ptr<SuffixTree>> buildInterleaved(const std::vector<std::string_view> &texts, int group = 4);
+
     // Utility: Visualization (Printing the tree structure)
     void printTree();
 
     // Utility: Search if a pattern exists in the text
     bool search(std::string pattern);
+
+    // Utility: Starting positions of every occurrence of pattern (unsorted)
+    std::vector<int> findAll(const std::string &pattern);
+
+    // Utility: Number of occurrences of pattern in the text
+    int count(const std::string &pattern);
+
     int getNodeCount() const { return nodeCount; }
 
+    // Indexed (folded) text; ends with the '$' terminator once finished
+    std::string_view getText() const { return text; }
+
+    // Open trees: the last getPendingSuffixes() suffixes do not end in a
+    // leaf yet and are missing from findAll()/count()
+    int getPendingSuffixes() const { return terminated ? 0 : remainder; }
+
+    // Result cache in front of search(), count() and findAll(), bounded
+    // to 'maxBytes'. Safe for concurrent queries; append(), finish() and
+    // rebuild() invalidate it.
+    void enableQueryCache(size_t maxBytes, int shards = 16);
+    void disableQueryCache();
+    QueryCacheStats queryCacheStats() const;
+
+    // Negative-lookup prefilter: a Bloom filter over the text's q-grams
+    // (kept up to date by append()). Queries containing a q-gram absent
+    // from the text are rejected without touching the tree.
+    void enableQGramFilter(int q = 8, int bitsPerGram = 12);
+    void disableQGramFilter();
+    const QGramFilter* getQGramFilter() const { return filter.get(); }
+
+    // Karp-Rabin prefix fingerprints of the text (16 bytes per character,
+    // kept up to date by append()). Queries of at least
+    // FINGERPRINT_MIN_LENGTH characters then match each edge in O(1) and
+    // finish with one verifying comparison, so their cost follows the
+    // number of edges on the path rather than the pattern length.
+    static constexpr size_t FINGERPRINT_MIN_LENGTH = 64;
+    static constexpr int FINGERPRINT_MIN_EDGE = 64;
+    void enableFingerprints();
+    void disableFingerprints();
+
+    // search() for many patterns; the prefilter runs over the whole batch
+    // first so its memory accesses overlap
+    std::vector<bool> searchBatch(const std::vector<std::string> &patterns);
+
+    // search() for a batch of patterns sharing prefixes (URLs, paths,
+    // barcodes): the batch is radix-sorted and walked in one pass, so each
+    // distinct prefix is matched once. Results are in input order.
+    std::vector<bool> searchBatchSorted(const std::vector<std::string> &patterns);
+
+    // Position-restricted occurrences: those lying entirely inside
+    // text[l..r] (inclusive), sorted by position. enableRangeQueries()
+    // numbers the leaves in DFS order, so every node covers a contiguous
+    // run of leaves, and indexes their positions in a wavelet matrix
+    // (about 1.5 bits per leaf per bit of the text length, plus 8 bytes per
+    // node). Queries then take O(m + log n) for the count and O(log n) per
+    // reported occurrence, however many occurrences lie outside the range.
+    // rebuild() keeps the index current; append() and finish() drop it.
+    // Without it, both fall back to filtering findAll().
+    void enableRangeQueries();
+    void disableRangeQueries();
+    bool hasRangeQueries() const { return leaves != nullptr; }
+    std::vector<int> findAllInRange(const std::string &pattern, int l, int r);
+    int countInRange(const std::string &pattern, int l, int r);
+
+    // Pagination in text order: the first 'limit' occurrences starting
+    // after position 'after' (-1 for the first page), ascending. With the
+    // range index each page costs O(m + log n) plus O(log n) per result,
+    // so deep pages of common patterns cost no more than the first.
+    std::vector<int> findAllSorted(const std::string &pattern, int after, int limit);
+
+    // Leftmost / rightmost occurrence of a pattern, -1 if absent.
+    // enableOccurrenceBounds() stores the smallest and largest suffix
+    // position below every node (8 bytes per node, one iterative post-order
+    // pass), after which both answer in O(m) with no leaf enumeration.
+    // Maintained like the range index; without it they scan findAll().
+    void enableOccurrenceBounds();
+    void disableOccurrenceBounds();
+    int firstOccurrence(const std::string &pattern);
+    int lastOccurrence(const std::string &pattern);
+
+    /**
+     * @brief Bottom-up aggregation over the whole tree; returns one value
+     * per node ID (see Node::id).
+     *
+     * A leaf's value is leafValue(suffix position). An internal node's is
+     * its first child's value with each further child's folded in by
+     * combine(Aggregate &into, const Aggregate &child), in key order. Leaf
+     * counts, position bounds, document sets or left characters are all
+     * one leafValue/combine pair. Disjoint subtrees are aggregated in
+     * parallel on a work-stealing pool ('threads' <= 0: one per hardware
+     * thread) and the few nodes above them afterwards; small trees run
+     * inline. Every pass is iterative. Tasks write distinct elements, so
+     * Aggregate must not be bool. Must not run concurrently with
+     * append(), finish() or rebuild().
+     */
+    static constexpr int PARALLEL_ANNOTATE_MIN_NODES = 1 << 16;
+    template <typename Aggregate, typename LeafValue, typename Combine>
+    std::vector<Aggregate> annotateBottomUp(LeafValue leafValue, Combine combine, int threads = 0);
+
+    // Heat sampling: while enabled, search() counts visits per node in
+    // per-thread counters. relayoutByHeat() then copies the 'maxNodes'
+    // most visited nodes and their child arrays into one contiguous,
+    // cache-line aligned region and resets the counters. It returns the
+    // number of nodes moved and must not run concurrently with queries.
+    // Repeated calls reuse the region and the slots the nodes left, so
+    // memory stays bounded however often it runs.
+    void setHeatSampling(bool enabled);
+    bool isHeatSampling() const { return heat != nullptr; }
+    int relayoutByHeat(int maxNodes = 4096);
+
 private:
     std::string text;
     Node *root;
+    ByteFolding folding; // Index-time byte mapping, identity by default
+
+    // Owns every node and child array; rewound (not freed) by rebuild()
+    Arena arena;
+
+    // q-gram prefilter, null when disabled
+    std::unique_ptr<QGramFilter> filter;
+
+    // Prefix fingerprints of the text, null when disabled
+    std::unique_ptr<PrefixFingerprints> fingerprints;
+
+    // Cached query results, null when disabled
+    std::unique_ptr<QueryCache> cache;
+
+    // Visit counters of heat sampling, null when disabled
+    struct HeatMap;
+    std::unique_ptr<HeatMap> heat;
+
+    // DFS leaf order for range queries, null when disabled
+    struct LeafIndex;
+    std::unique_ptr<LeafIndex> leaves;
+
+    // Smallest and largest suffix position below each node, by node ID;
+    // empty when disabled
+    std::vector<std::pair<int, int>> positionBounds;
+
+    // Recycled child arrays, one intrusive free list per capacity 2^k
+    static constexpr int CHILD_CLASSES = 9; // Capacities 1 .. 256
+    void *freeChildArrays[CHILD_CLASSES];
+
+    // Node slots vacated by relayoutByHeat(), reused by newNode() and the
+    // next relayout, and the hot region it rebuilds in place when the new
+    // layout fits. Not part of snapshots: clones and loaded trees start
+    // without them.
+    void *freeNodes = nullptr;
+    char *hotRegion = nullptr;
+    size_t hotRegionBytes = 0;
+    bool inHotRegion(const void *p) const {
+        return (uintptr_t)p - (uintptr_t)hotRegion < hotRegionBytes;
+    }
     
     // -- Ukkonen's Algorithm State Variables --
     
@@ -64,17 +294,44 @@ private:
     int activeEdge;      // The index of the character in 'text' indicating the edge we are on
     int activeLength;    // How far down the activeEdge we are
     int remainder;       // How many suffixes remain to be inserted
+    int phasePos;        // Position of the character the current phase adds
+    Node *lastNewNode;   // Internal node awaiting its suffix link
     
-    int leafEnd;         // Global end index for leaf nodes (updates every phase)
-    int *rootEnd;        // Special end pointer for the root
-    int *splitEnd;       // Helper pointer for internal split nodes
+    int *leafEnd;        // Global end index for leaf nodes (updates every phase);
+                         // lives in the arena so moves need no fix-up
     int size;            // Length of input text
+    bool terminated;     // '$' has been appended (no more appends)
     int nodeCount;       // Counter to assign IDs to nodes
 
     // -- Internal Helper Functions --
     
+    // Constructs without building when buildNow is false (see buildInterleaved)
+    SuffixTree(std::string text, const ByteFolding &folding, bool buildNow);
+
+    void build();
+    void prepare();      // Folds and terminates the text, then resets state
+    void resetState();   // Fresh root and active point
+    void takeFrom(SuffixTree &other);
+    void clearState();   // No root, no text: the moved-from state
+    void relocateAll(const std::vector<Arena::Relocation> &moved);
+    static SuffixTree readSnapshotHeader(std::istream &in); // Everything before the arena
+    void updateFilter(int firstNew);
+    void buildLeafIndex();
+    void buildOccurrenceBounds();
+
+    // Splits the tree for annotateBottomUp(): 'subtrees' are disjoint
+    // internal nodes covering the tree below 'spine', which lists the
+    // nodes above them parents first. Each entry carries its string depth.
+    void planSubtrees(std::vector<std::pair<Node*, int>> &spine, std::vector<std::pair<Node*, int>> &subtrees,
+                      int target);
+    static void runParallel(int tasks, const std::function<void(int)> &task, int threads);
     Node* newNode(int start, int *end);
-    void freeSuffixTreeByPostOrder(Node *n);
+    Node** takeChildArray(int capacity); // From the free list of its class, else the arena
+
+    // Sorted child array maintenance
+    Node* findChild(Node *n, char c) const;
+    void addChild(Node *n, char c, Node *child);
+    void replaceChild(Node *n, char c, Node *child);
     
     // Calculates the length of the edge leading to node n
     int edgeLength(Node *n);
@@ -84,12 +341,86 @@ private:
     
     // The core extension function called for every character
     void extend(int pos);
+
+    // extend() split into resumable steps for interleaved construction
+    void beginPhase(int pos);
+    bool step();
+    bool step(Node *next);
+    void prefetchStep() const;
+    bool prefetchChild(Node *&child) const;
+    void prefetchEdge(const Node *child) const;
     
     // Helper for printing
     void printRecursive(Node *n, int depth);
     
+    // Query implementations behind the cache
+    bool searchUncached(std::string pattern);
+    std::vector<int> findAllUncached(const std::string &pattern);
+    int countUncached(const std::string &pattern);
+
     // Helper for searching
-    bool searchRecursive(Node *n, std::string &pattern, int idx);
+    bool searchRecursive(Node *n, std::string &pattern, int idx, std::vector<uint32_t> *visits);
+
+    // This thread's visit counters (heat sampling must be enabled)
+    std::vector<uint32_t>* heatCounters();
+
+    // Applies the index-time folding to a query (returns pattern itself
+    // when no folding is configured)
+    const std::string& foldQuery(const std::string &pattern, std::string &scratch) const;
+
+    // Helper for occurrence queries: returns the node at or below the end of
+    // the pattern's path (nullptr if absent) and its string depth.
+    Node* locate(const std::string &pattern, int &depth);
+    Node* locateByFingerprint(const std::string &pattern, int &depth);
 };
 
+template <typename Aggregate, typename LeafValue, typename Combine>
+std::vector<Aggregate> SuffixTree::annotateBottomUp(LeafValue leafValue, Combine combine, int threads) {
+    std::vector<Aggregate> values(nodeCount);
+    if (!root) return values;
+
+    // All children of n are done (leaves get their value here)
+    auto fold = [&](Node *n, int depth) {
+        Aggregate &into = values[n->id];
+        for (int i = 0; i < n->childCount; i++) {
+            Node *child = n->children[i];
+            if (child->isLeaf()) values[child->id] = leafValue(*(child->end) + 1 - depth - edgeLength(child));
+            if (i == 0) into = values[child->id];
+            else combine(into, values[child->id]);
+        }
+    };
+
+    // Iterative post-order over the internal nodes below 'top'
+    auto aggregate = [&](Node *top, int topDepth) {
+        struct Frame {
+            Node *n;
+            int depth;
+            int next;   // Next child to visit
+        };
+        std::vector<Frame> stack = {{top, topDepth, 0}};
+        while (!stack.empty()) {
+            Frame &f = stack.back();
+            if (f.next < f.n->childCount) {
+                Node *child = f.n->children[f.next++];
+                if (!child->isLeaf()) stack.push_back({child, f.depth + edgeLength(child), 0}); // Invalidates f
+                continue;
+            }
+            fold(f.n, f.depth);
+            stack.pop_back();
+        }
+    };
+
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads == 1 || nodeCount < PARALLEL_ANNOTATE_MIN_NODES) {
+        aggregate(root, 0);
+        return values;
+    }
+
+    std::vector<std::pair<Node*, int>> spine, subtrees;
+    planSubtrees(spine, subtrees, threads * 8);
+    runParallel((int)subtrees.size(), [&](int i) { aggregate(subtrees[i].first, subtrees[i].second); }, threads);
+    for (auto it = spine.rbegin(); it != spine.rend(); ++it) fold(it->first, it->second);
+    return values;
+}
+
 #endif // SUFFIX_TREE_H
\ No newline at end of file
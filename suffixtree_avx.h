@@ -61,7 +61,7 @@ private:
     int nodeCount;
 
     Node* newNode(int start, int *end);
-    void freeSuffixTreeByPostOrder(Node *n);
+    void freeSubtree(Node *n);
     int edgeLength(Node *n);
     bool walkDown(Node *n);
     void extend(int pos);
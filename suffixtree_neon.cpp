@@ -30,7 +30,7 @@ SuffixTreeNeon::SuffixTreeNeon(std::string t) : text(t) {
 }
 
 SuffixTreeNeon::~SuffixTreeNeon() {
-    freeSuffixTreeByPostOrder(root);
+    freeSubtree(root);
     delete rootEnd;
 }
 
@@ -40,15 +40,22 @@ Node* SuffixTreeNeon::newNode(int start, int *end) {
     return node;
 }
 
-void SuffixTreeNeon::freeSuffixTreeByPostOrder(Node *n) {
-    if (!n) return;
-    for (Node* child : n->children) {
-        freeSuffixTreeByPostOrder(child);
-    }
-    if (n->end != &leafEnd && n->end != rootEnd) {
-        delete n->end; 
+void SuffixTreeNeon::freeSubtree(Node *n) {
+    // Explicit stack: the tree height reaches the text length on repetitive
+    // input, which would overflow the call stack if this recursed
+    std::vector<Node*> stack;
+    if (n) stack.push_back(n);
+    while (!stack.empty()) {
+        Node *cur = stack.back();
+        stack.pop_back();
+        for (Node* child : cur->children) {
+            stack.push_back(child);
+        }
+        if (cur->end != &leafEnd && cur->end != rootEnd) {
+            delete cur->end;
+        }
+        delete cur;
     }
-    delete n;
 }
 
 int SuffixTreeNeon::edgeLength(Node *n) {
@@ -0,0 +1,51 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "suffixtree_pool.h"
+#include <vector>
+
+namespace {
+
+// Idle trees of the current thread. Reserved up front so that returning a
+// tree never reallocates.
+std::vector<std::unique_ptr<SuffixTree>>& idleTrees() {
+    thread_local std::vector<std::unique_ptr<SuffixTree>> idle = [] {
+        std::vector<std::unique_ptr<SuffixTree>> v;
+        v.reserve(SuffixTreePool::MAX_IDLE);
+        return v;
+    }();
+    return idle;
+}
+
+} // namespace
+
+SuffixTreePool::Lease SuffixTreePool::acquire(std::string_view text) {
+    auto &idle = idleTrees();
+    if (idle.empty()) {
+        return Lease(std::make_unique<SuffixTree>(std::string(text)));
+    }
+    std::unique_ptr<SuffixTree> tree = std::move(idle.back());
+    idle.pop_back();
+    tree->rebuild(text);
+    return Lease(std::move(tree));
+}
+
+SuffixTreePool::Lease::~Lease() {
+    if (!tree) return; // Moved-from
+    auto &idle = idleTrees();
+    if (idle.size() < MAX_IDLE) {
+        idle.push_back(std::move(tree));
+    }
+}
+
+size_t SuffixTreePool::idleCount() {
+    return idleTrees().size();
+}
+
+void SuffixTreePool::trim() {
+    idleTrees().clear();
+}
@@ -0,0 +1,53 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef SUFFIX_TREE_POOL_H
+#define SUFFIX_TREE_POOL_H
+
+#include <memory>
+#include <string_view>
+#include "suffixtree.h"
+
+/**
+ * SuffixTreePool: per-thread cache of SuffixTree objects for request
+ * handlers that build a short-lived tree per request.
+ *
+ * acquire() pops an idle tree of the calling thread (or creates one) and
+ * rebuilds it over the new text; the returned Lease hands it back when it
+ * goes out of scope. Once the pooled trees' storage has grown to the
+ * working-set size, a request performs no heap allocation.
+ */
+class SuffixTreePool {
+public:
+    class Lease {
+    public:
+        explicit Lease(std::unique_ptr<SuffixTree> tree) : tree(std::move(tree)) {}
+        Lease(Lease &&other) = default;
+        Lease& operator=(Lease &&other) = delete;
+        ~Lease();
+
+        SuffixTree& operator*() const { return *tree; }
+        SuffixTree* operator->() const { return tree.get(); }
+
+    private:
+        std::unique_ptr<SuffixTree> tree;
+    };
+
+    // Idle trees kept per thread; extra trees are destroyed on release
+    static constexpr size_t MAX_IDLE = 8;
+
+    // Returns a tree built over 'text', reusing an idle tree if possible
+    static Lease acquire(std::string_view text);
+
+    // Number of idle trees held by the calling thread
+    static size_t idleCount();
+
+    // Destroys the calling thread's idle trees (and their storage)
+    static void trim();
+};
+
+#endif // SUFFIX_TREE_POOL_H
@@ -0,0 +1,319 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Header-only variant of the suffix tree over an arbitrary integral symbol
+ * type (token IDs, code points, ...) instead of bytes.
+ */
+
+#ifndef SUFFIX_TREE_SYMBOL_H
+#define SUFFIX_TREE_SYMBOL_H
+
+#include <vector>
+#include <map>
+#include <functional>
+#include <iostream>
+
+template <typename Symbol>
+class SymbolSuffixTree {
+public:
+    struct Node {
+        int start;
+        int *end;
+        Node *suffixLink;
+        int id;
+        std::map<Symbol, Node*> children;
+
+        Node(int start, int *end, int id)
+            : start(start), end(end), suffixLink(nullptr), id(id) {}
+    };
+
+    /**
+     * @brief Build the tree over 'text'.
+     * @param terminator A symbol that does not occur in the text. It is
+     * appended unless the text already ends with it (the '$' convention).
+     */
+    SymbolSuffixTree(std::vector<Symbol> text, Symbol terminator);
+    ~SymbolSuffixTree();
+
+    SymbolSuffixTree(const SymbolSuffixTree&) = delete;
+    SymbolSuffixTree& operator=(const SymbolSuffixTree&) = delete;
+
+    // Search if the symbol sequence occurs in the text
+    bool search(const std::vector<Symbol> &pattern);
+
+    // Starting positions (in symbols) of every occurrence (unsorted)
+    std::vector<int> findAll(const std::vector<Symbol> &pattern);
+
+    // Number of occurrences
+    int count(const std::vector<Symbol> &pattern);
+
+    // Print the tree, rendering each symbol with 'emit'
+    void printTree(const std::function<void(std::ostream&, Symbol)> &emit);
+
+    int getNodeCount() const { return nodeCount; }
+    const std::vector<Symbol>& getText() const { return text; }
+
+private:
+    std::vector<Symbol> text;
+    int size;
+
+    Node *root;
+    Node *activeNode;
+
+    int leafEnd;
+    int *rootEnd;
+
+    int activeEdge;
+    int activeLength;
+    int remainder;
+    int nodeCount;
+
+    Node* newNode(int start, int *end);
+    int edgeLength(Node *n);
+    bool walkDown(Node *n);
+    void extend(int pos);
+    Node* locate(const std::vector<Symbol> &pattern, int &depth);
+    void printRecursive(Node *n, int depth, const std::function<void(std::ostream&, Symbol)> &emit);
+};
+
+// =========================================================
+// Implementation Details
+// =========================================================
+
+template <typename Symbol>
+SymbolSuffixTree<Symbol>::SymbolSuffixTree(std::vector<Symbol> t, Symbol terminator) : text(std::move(t)) {
+    if (text.empty() || text.back() != terminator) {
+        text.push_back(terminator);
+    }
+    size = text.size();
+
+    nodeCount = 0;
+    leafEnd = -1;
+    rootEnd = new int(-1);
+
+    root = newNode(-1, rootEnd);
+    root->suffixLink = root;
+
+    activeNode = root;
+    activeEdge = -1;
+    activeLength = 0;
+    remainder = 0;
+
+    for (int i = 0; i < size; i++) {
+        extend(i);
+    }
+}
+
+template <typename Symbol>
+SymbolSuffixTree<Symbol>::~SymbolSuffixTree() {
+    // Iterative post-order free (token and code point trees can be deep)
+    std::vector<Node*> stack = {root};
+    while (!stack.empty()) {
+        Node *n = stack.back();
+        stack.pop_back();
+        for (auto const& [key, child] : n->children) {
+            stack.push_back(child);
+        }
+        if (n->end != &leafEnd && n->end != rootEnd) {
+            delete n->end;
+        }
+        delete n;
+    }
+    delete rootEnd;
+}
+
+template <typename Symbol>
+typename SymbolSuffixTree<Symbol>::Node* SymbolSuffixTree<Symbol>::newNode(int start, int *end) {
+    Node *node = new Node(start, end, nodeCount++);
+    node->suffixLink = root;
+    return node;
+}
+
+template <typename Symbol>
+int SymbolSuffixTree<Symbol>::edgeLength(Node *n) {
+    if (n == root) return 0;
+    return *(n->end) - (n->start) + 1;
+}
+
+template <typename Symbol>
+bool SymbolSuffixTree<Symbol>::walkDown(Node *n) {
+    int len = edgeLength(n);
+    if (activeLength >= len) {
+        activeEdge += len;
+        activeLength -= len;
+        activeNode = n;
+        return true;
+    }
+    return false;
+}
+
+template <typename Symbol>
+void SymbolSuffixTree<Symbol>::extend(int pos) {
+    leafEnd = pos;
+    remainder++;
+    Node *lastNewNode = nullptr;
+
+    while (remainder > 0) {
+        if (activeLength == 0) {
+            activeEdge = pos;
+        }
+
+        Symbol currentEdgeSymbol = text[activeEdge];
+        auto it = activeNode->children.find(currentEdgeSymbol);
+
+        if (it == activeNode->children.end()) {
+            // Rule 2: New leaf
+            activeNode->children[currentEdgeSymbol] = newNode(pos, &leafEnd);
+            if (lastNewNode != nullptr) {
+                lastNewNode->suffixLink = activeNode;
+                lastNewNode = nullptr;
+            }
+        }
+        else {
+            Node *next = it->second;
+            if (walkDown(next)) {
+                continue;
+            }
+
+            if (text[next->start + activeLength] == text[pos]) {
+                // Rule 3: Showstopper
+                if (lastNewNode != nullptr && activeNode != root) {
+                    lastNewNode->suffixLink = activeNode;
+                    lastNewNode = nullptr;
+                }
+                activeLength++;
+                break;
+            }
+
+            // Rule 2 (Split)
+            int *splitEnd = new int(next->start + activeLength - 1);
+            Node *split = newNode(next->start, splitEnd);
+            it->second = split;
+
+            next->start += activeLength;
+            split->children[text[next->start]] = next;
+            split->children[text[pos]] = newNode(pos, &leafEnd);
+
+            if (lastNewNode != nullptr) {
+                lastNewNode->suffixLink = split;
+            }
+            lastNewNode = split;
+        }
+
+        remainder--;
+        if (activeNode == root && activeLength > 0) {
+            activeLength--;
+            activeEdge = pos - remainder + 1;
+        } else if (activeNode != root) {
+            activeNode = activeNode->suffixLink;
+        }
+    }
+}
+
+template <typename Symbol>
+typename SymbolSuffixTree<Symbol>::Node* SymbolSuffixTree<Symbol>::locate(const std::vector<Symbol> &pattern, int &depth) {
+    Node *n = root;
+    depth = 0;
+    int idx = 0;
+    int m = pattern.size();
+
+    while (idx < m) {
+        auto it = n->children.find(pattern[idx]);
+        if (it == n->children.end()) return nullptr;
+
+        Node *child = it->second;
+        int edgeLen = edgeLength(child);
+        for (int i = 0; i < edgeLen && idx + i < m; i++) {
+            if (text[child->start + i] != pattern[idx + i]) return nullptr;
+        }
+        n = child;
+        depth += edgeLen;
+        idx += edgeLen;
+    }
+    return n;
+}
+
+template <typename Symbol>
+bool SymbolSuffixTree<Symbol>::search(const std::vector<Symbol> &pattern) {
+    int depth;
+    return locate(pattern, depth) != nullptr;
+}
+
+template <typename Symbol>
+std::vector<int> SymbolSuffixTree<Symbol>::findAll(const std::vector<Symbol> &pattern) {
+    std::vector<int> positions;
+    int depth;
+    Node *locus = locate(pattern, depth);
+    if (!locus) return positions;
+
+    std::vector<std::pair<Node*, int>> stack;
+    stack.push_back({locus, depth});
+    while (!stack.empty()) {
+        auto [n, d] = stack.back();
+        stack.pop_back();
+        if (n->children.empty()) {
+            positions.push_back(*(n->end) + 1 - d);
+            continue;
+        }
+        for (auto const& [key, child] : n->children) {
+            stack.push_back({child, d + edgeLength(child)});
+        }
+    }
+    return positions;
+}
+
+template <typename Symbol>
+int SymbolSuffixTree<Symbol>::count(const std::vector<Symbol> &pattern) {
+    int depth;
+    Node *locus = locate(pattern, depth);
+    if (!locus) return 0;
+
+    int leaves = 0;
+    std::vector<Node*> stack = {locus};
+    while (!stack.empty()) {
+        Node *n = stack.back();
+        stack.pop_back();
+        if (n->children.empty()) {
+            leaves++;
+            continue;
+        }
+        for (auto const& [key, child] : n->children) {
+            stack.push_back(child);
+        }
+    }
+    return leaves;
+}
+
+template <typename Symbol>
+void SymbolSuffixTree<Symbol>::printTree(const std::function<void(std::ostream&, Symbol)> &emit) {
+    std::cout << "\n--- Suffix Tree Structure ---\n";
+    printRecursive(root, 0, emit);
+    std::cout << "-----------------------------\n";
+}
+
+template <typename Symbol>
+void SymbolSuffixTree<Symbol>::printRecursive(Node *n, int depth, const std::function<void(std::ostream&, Symbol)> &emit) {
+    if (!n) return;
+
+    if (n->start != -1) {
+        for (int i = 0; i < depth; i++) std::cout << "  ";
+
+        int currentEnd = *(n->end);
+        std::cout << "Edge [" << n->start << "," << currentEnd << "]: ";
+        for (int i = n->start; i <= currentEnd; i++) {
+            emit(std::cout, text[i]);
+        }
+        std::cout << " (Node " << n->id << ")" << std::endl;
+    } else {
+        std::cout << "Root (Node " << n->id << ")" << std::endl;
+    }
+
+    for (auto const& [key, child] : n->children) {
+        printRecursive(child, depth + 1, emit);
+    }
+}
+
+#endif // SUFFIX_TREE_SYMBOL_H
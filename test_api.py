@@ -22,3 +22,7 @@ tree.print_tree()
 
 # 4. Get the original text
 print(f"\n原始文本: {tree.get_text()}")
+
+# 5. Case-insensitive index (ASCII case is folded at index time and in queries)
+ci_tree = pyukkonen.SuffixTree("Banana Rama", case_insensitive=True)
+print(f"\nsearch 'BANANA rama': {ci_tree.search('BANANA rama')}")
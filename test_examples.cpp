@@ -8,7 +8,51 @@
 #include <iostream>
 #include <vector>
 #include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <sys/un.h>
 #include "suffixtree.h"
+#include "sparse_suffixtree.h"
+#include "token_suffixtree.h"
+#include "utf8_suffixtree.h"
+#include "suffix_forest.h"
+#include "suffixtree_pool.h"
+#include "batch_builder.h"
+#include "streaming_builder.h"
+#include "spsc_ring.h"
+#include "reclaimer.h"
+#include "sharded_index.h"
+#include "sequence_index.h"
+#include "lsm_index.h"
+#include "index_server.h"
+#include "index_client.h"
+
+// Counts heap allocations so tests can check allocation-free paths. The
+// aligned forms are counted too: arena blocks come from them. Atomic, as
+// worker threads allocate while tests run.
+static std::atomic<size_t> heapAllocations{0};
+void* operator new(size_t n) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t n, std::align_val_t align) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    size_t a = (size_t)align;
+    if (void *p = std::aligned_alloc(a, (n + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { std::free(p); }
 
 void runTest(std::string inputName, std::string text, const std::vector<std::string>& patterns, const std::vector<bool>& expectedResults) {
     std::cout << "Running Test: " << inputName << " (Text: \"" << text << "\")" << std::endl;
@@ -37,6 +81,17 @@ void runTest(std::string inputName, std::string text, const std::vector<std::str
     else std::cout << ">> " << inputName << " FAILED.\n" << std::endl;
 }
 
+void checkPositions(std::string name, std::vector<int> got, std::vector<int> expected) {
+    std::sort(got.begin(), got.end());
+    std::sort(expected.begin(), expected.end());
+    if (got == expected) {
+        std::cout << "  [PASS] " << name << std::endl;
+    } else {
+        std::cout << "  [FAIL] " << name << ". Expected " << expected.size()
+                  << " positions, Got " << got.size() << std::endl;
+    }
+}
+
 int main() {
     std::cout << "============================================" << std::endl;
     std::cout << "    Ukkonen's Suffix Tree Implementation    " << std::endl;
@@ -66,7 +121,936 @@ int main() {
     if(emptyTree.search("$")) std::cout << ">> Empty String Test Passed.\n" << std::endl;
     else std::cout << ">> Empty String Test Failed.\n" << std::endl;
 
-    // TEST CASE 5: Visual Verification
+    // TEST CASE 5: Occurrence Queries
+    std::cout << "Running Test: Occurrences (Text: \"mississippi\")" << std::endl;
+    SuffixTree occTree("mississippi");
+    checkPositions("findAll 'issi'", occTree.findAll("issi"), {1, 4});
+    checkPositions("findAll 's'", occTree.findAll("s"), {2, 3, 5, 6});
+    checkPositions("findAll 'xyz'", occTree.findAll("xyz"), {});
+    checkPositions("count 'i'", {occTree.count("i")}, {4});
+    std::cout << std::endl;
+
+    // TEST CASE 6: Sparse Suffix Tree (word boundaries)
+    std::string words = "the cat sat on the mat with the hat";
+    std::cout << "Running Test: Sparse Words (Text: \"" << words << "\")" << std::endl;
+    SparseSuffixTree sparse(words, SparseSuffixTree::wordBoundaries(words));
+    checkPositions("indexed suffixes", {sparse.getIndexedCount()}, {9});
+    checkPositions("findAll 'the'", sparse.findAll("the"), {0, 15, 28});
+    checkPositions("findAll 'at' (mid-word)", sparse.findAll("at"), {});
+    checkPositions("findAll 'mat with'", sparse.findAll("mat with"), {19});
+    checkPositions("search 'cat sat'", {sparse.search("cat sat")}, {1});
+
+    SparseSuffixTree everyThird("abcabcabc", [](const std::string &, int i) { return i % 3 == 0; });
+    checkPositions("predicate findAll 'abc'", everyThird.findAll("abc"), {0, 3, 6});
+    checkPositions("predicate findAll 'bca'", everyThird.findAll("bca"), {});
+    // The predicate sees the text without the terminator
+    SparseSuffixTree lastOnly("abcab", [](const std::string &t, int i) { return i + 1 == (int)t.size(); });
+    checkPositions("predicate sees caller's text", lastOnly.findAll("b"), {4});
+    // Repetitive text, a '$' inside the text, duplicate and out-of-range
+    // positions, all against a scan of the selected positions
+    std::string repeated(3000, 'a');
+    SparseSuffixTree everySecond(repeated, SparseSuffixTree::everyKth(repeated, 2));
+    checkPositions("repetitive text indexed", {everySecond.getIndexedCount(), (int)everySecond.findAll("aaaa").size()},
+                   {1500, 1499});
+    SparseSuffixTree dollars("a$a$b", std::vector<int>{0, 2, 2, -1, 4, 9});
+    checkPositions("suffix that prefixes another", dollars.findAll("a$"), {0, 2});
+    checkPositions("duplicate positions counted once", {dollars.getIndexedCount()}, {3});
+    std::srand(76);
+    bool sparseAgrees = true;
+    for (int round = 0; round < 50 && sparseAgrees; round++) {
+        std::string t;
+        for (int i = 0; i < 200; i++) t += "ab"[std::rand() % 2];
+        std::vector<int> picked;
+        for (int i = 0; i < 200; i++) {
+            if (std::rand() % 3 == 0) picked.push_back(i);
+        }
+        SparseSuffixTree randomSparse(t, picked);
+        for (int len = 1; len <= 6 && sparseAgrees; len++) {
+            std::string p = t.substr(std::rand() % (200 - len), len);
+            std::vector<int> expected, got = randomSparse.findAll(p);
+            for (int i : picked) {
+                if (t.compare(i, len, p) == 0) expected.push_back(i);
+            }
+            std::sort(got.begin(), got.end());
+            sparseAgrees = got == expected && randomSparse.search(p) == !expected.empty();
+        }
+    }
+    checkPositions("random selections match a scan", {sparseAgrees}, {1});
+
+    std::vector<SparseSuffixTree> sparseTrees;
+    for (int k = 1; k <= 4; k++) sparseTrees.emplace_back("abcabcabc", SparseSuffixTree::everyKth("abcabcabc", k));
+    SparseSuffixTree movedSparse = std::move(sparseTrees[2]);
+    checkPositions("moved sparse tree", movedSparse.findAll("abc"), {0, 3, 6});
+    checkPositions("moved-from sparse tree", {(int)sparseTrees[2].findAll("abc").size(), sparseTrees[2].search("a")},
+                   {0, 0});
+    std::cout << std::endl;
+
+    // TEST CASE 7: Token-level Suffix Tree
+    std::string log = "GET /index 200\nGET /login 302\nPOST /login 200\nGET /index 200\n";
+    std::cout << "Running Test: Token Tree (Text: access log)" << std::endl;
+    TokenSuffixTree tokens(log);
+    checkPositions("vocabulary size", {tokens.getVocabularySize()}, {6});
+    checkPositions("searchPhrase 'GET /index 200'", {tokens.searchPhrase("GET /index 200")}, {1});
+    checkPositions("searchPhrase tokens", {tokens.searchPhrase(std::vector<std::string>{"/login", "200"})}, {1});
+    checkPositions("searchPhrase unknown token", {tokens.searchPhrase("GET /admin")}, {0});
+    checkPositions("searchPhrase partial token", {tokens.searchPhrase("GE")}, {0});
+    checkPositions("findAll 'GET /index'", tokens.findAll("GET /index"), {0, 9});
+    checkPositions("findAllOffsets '200 GET'", tokens.findAllOffsets("200 GET"), {11, 42});
+    checkPositions("count '200'", {tokens.count("200")}, {3});
+
+    // The parallel tokenizer must assign the same IDs as a sequential pass
+    std::string corpus;
+    for (int i = 0; i < 60000; i++) corpus += "w" + std::to_string(i * 7919 % 1000) + (i % 13 ? " " : "\n");
+    TokenDictionary seqDict, parDict;
+    TokenStream seq = Tokenizer::tokenize(corpus, seqDict, 1);
+    TokenStream par = Tokenizer::tokenize(corpus, parDict, 4);
+    checkPositions("parallel tokenizer ids", {par.ids == seq.ids}, {1});
+    checkPositions("parallel tokenizer offsets", {par.offsets == seq.offsets}, {1});
+    std::cout << std::endl;
+
+    // TEST CASE 8: UTF-8 Code Point Tree
+    std::string cjk = "北京大学在北京, naïve café";
+    std::cout << "Running Test: UTF-8 (Text: \"" << cjk << "\")" << std::endl;
+    Utf8SuffixTree utf8(cjk);
+    checkPositions("code point count", {utf8.getCodePointCount()}, {19});
+    checkPositions("search '大学'", {utf8.search("大学")}, {1});
+    checkPositions("search 'café'", {utf8.search("café")}, {1});
+    checkPositions("search partial character", {utf8.search("\xE5\x8C")}, {0});
+    checkPositions("findAll '北京' (code points)", utf8.findAll("北京"), {0, 5});
+    checkPositions("findAll '北京' (bytes)", utf8.findAll("北京", Utf8SuffixTree::Unit::Bytes), {0, 15});
+    checkPositions("findAll 'ï' (bytes)", utf8.findAll("ï", Utf8SuffixTree::Unit::Bytes), {25});
+    checkPositions("count 'e'", {utf8.count("e")}, {1});
+    checkPositions("fewer nodes than byte tree", {utf8.getNodeCount() < SuffixTree(cjk).getNodeCount()}, {1});
+
+    // Long ASCII runs take the 16-byte SIMD path
+    Utf8SuffixTree mixed(std::string(40, 'a') + "é" + std::string(20, 'b'));
+    checkPositions("SIMD path findAll 'aéb'", mixed.findAll("aéb"), {39});
+    checkPositions("SIMD path findAll 'éb' (bytes)", mixed.findAll("éb", Utf8SuffixTree::Unit::Bytes), {40});
+    checkPositions("SIMD path count 'b'", {mixed.count("b")}, {20});
+
+    bool rejected = false;
+    try { Utf8SuffixTree bad("ok\xC0\xAF"); } catch (const std::invalid_argument &) { rejected = true; }
+    checkPositions("overlong sequence rejected", {rejected}, {1});
+
+    // Random mixes of 1-4 byte characters round-trip with their offsets,
+    // however ASCII runs and multi-byte runs fall across 16-byte blocks
+    std::srand(8);
+    int roundTrips = 0;
+    for (int trial = 0; trial < 50; trial++) {
+        std::vector<uint32_t> points;
+        std::vector<int> starts;
+        std::string bytes;
+        int run = std::rand() % 40;
+        for (int k = 0; k < 300; k++) {
+            static const uint32_t samples[] = {'x', 0xE9, 0x4EAC, 0x1F600};
+            uint32_t cp = run-- > 0 ? 'a' + std::rand() % 26 : samples[std::rand() % 4];
+            if (run < -3) run = std::rand() % 40;
+            points.push_back(cp);
+            starts.push_back(bytes.size());
+            Utf8Decoder::encode(cp, bytes);
+        }
+        starts.push_back(bytes.size());
+        std::vector<uint32_t> decoded;
+        std::vector<int> offsets;
+        roundTrips += Utf8Decoder::decode(bytes.data(), bytes.size(), decoded, &offsets) && decoded == points &&
+                      offsets == starts;
+    }
+    std::vector<uint32_t> decodedPrefix;
+    size_t errorAt = 0;
+    bool badDecoded = Utf8Decoder::decode((std::string(20, 'a') + "\xC0\xAF").c_str(), 22, decodedPrefix, nullptr, &errorAt);
+    checkPositions("decoder round trips", {roundTrips, badDecoded, (int)errorAt, (int)decodedPrefix.size()},
+                   {50, 0, 20, 20});
+
+    // Long runs of 2- and 3-byte characters are widened a block at a
+    // time; errors inside them are still found at the right offset
+    std::string cjkRun, cyrillicRun;
+    for (int k = 0; k < 40; k++) {
+        Utf8Decoder::encode(0x4E00 + k * 97, cjkRun);
+        Utf8Decoder::encode(0x430 + k % 32, cyrillicRun);
+    }
+    std::vector<uint32_t> runPoints;
+    std::vector<int> runOffsets;
+    Utf8Decoder::decode(cjkRun.data(), cjkRun.size(), runPoints, &runOffsets);
+    checkPositions("CJK run decoded", {(int)runPoints.size(), (int)runPoints[39], runOffsets[39], runOffsets[40]},
+                   {40, 0x4E00 + 39 * 97, 117, 120});
+    Utf8Decoder::decode(cyrillicRun.data(), cyrillicRun.size(), runPoints, &runOffsets);
+    checkPositions("Cyrillic run decoded", {(int)runPoints.size(), (int)runPoints[39], runOffsets[39]},
+                   {40, 0x430 + 7, 78});
+    int misplaced = 0;
+    for (std::string bad : {"\xED\xA0\x80", "\xF4\x90\x80\x80", "\xE0\x80\x80", "\xC1\xBF", "\xF8\x88\x80\x80",
+                            "\x80", "\xE4\xB8"}) {
+        std::string text = cjkRun.substr(0, 30) + bad + (bad == "\xE4\xB8" ? "" : cjkRun.substr(30));
+        size_t badAt = 0;
+        if (Utf8Decoder::decode(text.data(), text.size(), runPoints, nullptr, &badAt) || badAt != 30 ||
+            runPoints.size() != 10) {
+            misplaced++;
+        }
+    }
+    checkPositions("errors inside multi-byte runs", {misplaced}, {0});
+    std::cout << std::endl;
+
+    // TEST CASE 9: Case Folding at Index Time
+    std::string mixedCase = "The Quick Brown Fox jumps over THE LAZY DOG near the Fox den";
+    std::cout << "Running Test: Case Folding (Text: \"" << mixedCase << "\")" << std::endl;
+    SuffixTree folded(mixedCase, ByteFolding::asciiCaseFold());
+    checkPositions("search 'QUICK brown'", {folded.search("QUICK brown")}, {1});
+    checkPositions("findAll 'the'", folded.findAll("the"), {0, 31, 49});
+    checkPositions("findAll 'FOX'", folded.findAll("FOX"), {16, 53});
+    checkPositions("count 'Lazy Dog'", {folded.count("Lazy Dog")}, {1});
+
+    // Custom table: treat '-' and '_' as spaces
+    std::array<uint8_t, 256> table = ByteFolding::asciiCaseFold().getTable();
+    table['-'] = ' ';
+    table['_'] = ' ';
+    SuffixTree custom("snake_case and tribe-Case", ByteFolding::fromTable(table));
+    checkPositions("custom table findAll 'E CASE'", custom.findAll("E CASE"), {4, 19});
+    std::cout << std::endl;
+
+    // TEST CASE 10: Suffix Forest (many tiny trees, shared storage)
+    std::cout << "Running Test: Suffix Forest" << std::endl;
+    std::vector<std::string> records = {"banana", "mississippi", "abracadabra", "", "xabxa"};
+    SuffixForest forest(records);
+    checkPositions("forest size", {forest.size()}, {5});
+    checkPositions("search tree 0 'nan'", {forest.search(0, "nan")}, {1});
+    checkPositions("search tree 0 'nab'", {forest.search(0, "nab")}, {0});
+    checkPositions("findAll tree 1 'ssi'", forest.findAll(1, "ssi"), {2, 5});
+    checkPositions("findAll tree 2 'abra'", forest.findAll(2, "abra"), {0, 7});
+    checkPositions("count tree 2 'a'", {forest.count(2, "a")}, {5});
+    checkPositions("searchAll 'a'", forest.searchAll("a"), {0, 2, 4});
+    checkPositions("empty record", {forest.search(3, "$")}, {1});
+
+    // Same answers and node counts as standalone trees
+    bool agree = true;
+    for (int t = 0; t < forest.size(); t++) {
+        SuffixTree single(records[t]);
+        agree = agree && forest.getNodeCount(t) == single.getNodeCount();
+        for (std::string p : {"a", "ab", "ssi", "issi", "x", "bra", "q"}) {
+            std::vector<int> a = forest.findAll(t, p), b = single.findAll(p);
+            std::sort(a.begin(), a.end());
+            std::sort(b.begin(), b.end());
+            agree = agree && a == b;
+        }
+    }
+    checkPositions("matches standalone SuffixTree", {agree}, {1});
+
+    forest.clear();
+    forest.add("reused");
+    checkPositions("clear and reuse", {forest.size(), forest.search(0, "use")}, {1, 1});
+    std::cout << std::endl;
+
+    // TEST CASE 11: Reusable Trees
+    std::cout << "Running Test: Rebuild and Pool" << std::endl;
+    SuffixTree reused("mississippi");
+    reused.rebuild("banana");
+    checkPositions("rebuild findAll 'ana'", reused.findAll("ana"), {1, 3});
+    checkPositions("rebuild drops old text", {reused.search("ssi")}, {0});
+    checkPositions("rebuild node count", {reused.getNodeCount()}, {SuffixTree("banana").getNodeCount()});
+
+    std::vector<std::string> requests = {"GATTACA", "the quick brown fox", "abracadabra", "GATTACAGATTACA"};
+    for (int warmup = 0; warmup < 2; warmup++) {
+        for (auto const& r : requests) SuffixTreePool::acquire(r)->search("A");
+    }
+    size_t before = heapAllocations;
+    bool found = true;
+    for (int round = 0; round < 100; round++) {
+        for (auto const& r : requests) {
+            SuffixTreePool::Lease tree = SuffixTreePool::acquire(r);
+            found = found && tree->search(r.substr(2, 3));
+        }
+    }
+    int steadyAllocations = (int)(heapAllocations - before);
+    checkPositions("pooled queries correct", {found}, {1});
+    checkPositions("steady-state heap allocations", {steadyAllocations}, {0});
+    size_t beforeAligned = heapAllocations;
+    void *volatile aligned = ::operator new(1000, std::align_val_t(4096)); // volatile: not elided
+    ::operator delete(aligned, std::align_val_t(4096));
+    checkPositions("aligned allocations counted", {heapAllocations - beforeAligned >= 1}, {1});
+    checkPositions("idle trees returned", {(int)SuffixTreePool::idleCount()}, {1});
+    std::cout << std::endl;
+
+    // TEST CASE 12: Interleaved Construction
+    std::cout << "Running Test: Interleaved Build" << std::endl;
+    std::vector<std::string> docs = {"banana", "mississippi", "", "abracadabra", "GATTACAGATTACA",
+                                     "aaaaaaaaaa", "the quick brown fox", "xabxa", "abcabxabcd"};
+    std::vector<std::string_view> views(docs.begin(), docs.end());
+    auto interleaved = SuffixTree::buildInterleaved(views, 4);
+    bool same = interleaved.size() == docs.size();
+    for (size_t i = 0; same && i < docs.size(); i++) {
+        SuffixTree single(docs[i]);
+        same = interleaved[i]->getNodeCount() == single.getNodeCount();
+        for (std::string p : {"a", "ab", "ssi", "ana", "TTA", "aaa", "o", "q"}) {
+            std::vector<int> a = interleaved[i]->findAll(p), b = single.findAll(p);
+            std::sort(a.begin(), a.end());
+            std::sort(b.begin(), b.end());
+            same = same && a == b;
+        }
+    }
+    checkPositions("matches sequential builds", {same}, {1});
+    // One and two lanes run several prefetch stages on the same tree
+    int narrowNodes = 0;
+    for (int group : {1, 2}) {
+        for (auto &tree : SuffixTree::buildInterleaved(views, group)) narrowNodes += tree->getNodeCount();
+    }
+    int expectedNodes = 0;
+    for (auto &tree : interleaved) expectedNodes += 2 * tree->getNodeCount();
+    checkPositions("narrow groups match", {narrowNodes}, {expectedNodes});
+    std::cout << std::endl;
+
+    // TEST CASE 13: Parallel Batch Builder
+    std::cout << "Running Test: Parallel Batch Build" << std::endl;
+    BuildReport report;
+    auto parallel = buildMany(views, 3, &report);
+    bool parallelSame = parallel.size() == docs.size();
+    for (size_t i = 0; parallelSame && i < docs.size(); i++) {
+        SuffixTree single(docs[i]);
+        parallelSame = parallel[i]->getNodeCount() == single.getNodeCount() &&
+                       parallel[i]->count("a") == single.count("a");
+    }
+    checkPositions("matches sequential builds", {parallelSame}, {1});
+    checkPositions("per-document latencies", {(int)report.latencyMs.size()}, {(int)docs.size()});
+    std::cout << std::endl;
+
+    // TEST CASE 14: Streaming Construction
+    std::cout << "Running Test: Streaming Construction" << std::endl;
+    std::string streamText = "mississippi banana mississippi";
+    size_t readPos = 0;
+    StreamingOptions tiny;
+    tiny.chunkSize = 4; // Many chunks, so phases straddle chunk boundaries
+    tiny.chunks = 2;
+    PlainDecoder plain;
+    auto streamed = buildStreaming([&](char *buffer, size_t capacity) {
+        size_t n = std::min(capacity, streamText.size() - readPos);
+        std::copy(streamText.begin() + readPos, streamText.begin() + readPos + n, buffer);
+        readPos += n;
+        return n;
+    }, plain, tiny);
+    SuffixTree direct(streamText);
+    checkPositions("findAll 'ssi' (streamed)", streamed->findAll("ssi"), direct.findAll("ssi"));
+    checkPositions("node count (streamed)", {streamed->getNodeCount()}, {direct.getNodeCount()});
+
+    std::string fasta = ">seq1 first\nACGT\nAC\n>seq2\r\nGTAC\n";
+    readPos = 0;
+    FastaDecoder fastaDecoder('|');
+    auto fastaTree = buildStreaming([&](char *buffer, size_t capacity) {
+        size_t n = std::min(capacity, fasta.size() - readPos);
+        std::copy(fasta.begin() + readPos, fasta.begin() + readPos + n, buffer);
+        readPos += n;
+        return n;
+    }, fastaDecoder, tiny);
+    // Decoded text: "ACGTAC|GTAC"
+    checkPositions("FASTA findAll 'GTAC'", fastaTree->findAll("GTAC"), {2, 7});
+    checkPositions("FASTA header skipped", {fastaTree->search("seq")}, {0});
+
+    // A 2-slot ring forces both sides to sleep and wake over and over
+    SpscRing<int> handoff(2);
+    std::thread producer([&] {
+        for (int i = 1; i <= 100000; i++) handoff.push(i);
+    });
+    long long received = 0;
+    int inOrder = 1;
+    for (int i = 1; i <= 100000; i++) {
+        int value;
+        handoff.pop(value);
+        inOrder &= value == i;
+        received += value;
+    }
+    producer.join();
+    checkPositions("blocking ring hands over in order", {inOrder, received == 5000050000LL}, {1, 1});
+    std::cout << std::endl;
+
+    // TEST CASE 15: Background Release
+    std::cout << "Running Test: Background Release" << std::endl;
+    SuffixTree dropped("mississippi");
+    dropped.enableRangeQueries();
+    dropped.releaseAsync();
+    checkPositions("empty after releaseAsync", {dropped.count("ssi"), dropped.search("m")}, {0, 0});
+    std::vector<bool> droppedBatch = dropped.searchBatchSorted({"ss", "m"});
+    checkPositions("released tree has no nodes",
+                   {dropped.getNodeCount(), (int)dropped.getText().size(), dropped.hasRangeQueries(),
+                    (int)dropped.findAll("i").size(), (int)dropped.findAllSorted("i", -1, 5).size(),
+                    dropped.countInRange("i", 0, 10), dropped.firstOccurrence("i"), droppedBatch[0] || droppedBatch[1]},
+                   {0, 0, 0, 0, 0, 0, -1, 0});
+    dropped.rebuild("banana");
+    checkPositions("reusable after releaseAsync", dropped.findAll("ana"), {1, 3});
+
+    // Deep tree: "aaa...a" has a path as long as the text
+    auto deep = std::make_unique<SuffixTree>(std::string(200000, 'a'));
+    Reclaimer::instance().dispose(std::move(deep));
+    Reclaimer::instance().drain();
+    checkPositions("reclaimer drained", {(int)Reclaimer::instance().pending(), deep == nullptr}, {0, 1});
+    std::cout << std::endl;
+
+    // TEST CASE 16: Move and Clone
+    std::cout << "Running Test: Move and Clone" << std::endl;
+    std::vector<SuffixTree> held;
+    held.push_back(SuffixTree("mississippi"));
+    held.push_back(SuffixTree("banana"));
+    held.push_back(SuffixTree("abracadabra")); // Reallocates: earlier trees move
+    checkPositions("moved trees answer", held[0].findAll("ssi"), {2, 5});
+
+    SuffixTree snapshot = held[1].clone();
+    held[1].rebuild("xyz");
+    checkPositions("clone survives source rebuild", snapshot.findAll("ana"), {1, 3});
+    checkPositions("clone node count", {snapshot.getNodeCount()}, {SuffixTree("banana").getNodeCount()});
+
+    SuffixTree moved = std::move(held[2]);
+    checkPositions("moved-from is empty", {held[2].search("abra"), held[2].count("a")}, {0, 0});
+    held[2] = std::move(moved);
+    checkPositions("move assignment", held[2].findAll("abra"), {0, 7});
+
+    // An open tree keeps growing independently after cloning
+    SuffixTree growing;
+    growing.append("abcab");
+    SuffixTree fork = growing.clone();
+    growing.append("x");
+    fork.append("cab");
+    growing.finish();
+    fork.finish();
+    checkPositions("clone of open tree", fork.findAll("cab"), {2, 5});
+    checkPositions("original unaffected", growing.findAll("cab"), {2});
+    std::cout << std::endl;
+
+    // TEST CASE 17: Heat-Guided Relayout
+    std::cout << "Running Test: Heat-Guided Relayout" << std::endl;
+    SuffixTree hotTree("mississippi river banana bandana");
+    hotTree.setHeatSampling(true);
+    for (int i = 0; i < 100; i++) hotTree.search("issi");
+    hotTree.search("banana");
+    int movedNodes = hotTree.relayoutByHeat(4);
+    checkPositions("nodes moved", {movedNodes}, {4});
+    checkPositions("findAll 'issi' after relayout", hotTree.findAll("issi"), {1, 4});
+    checkPositions("findAll 'an' after relayout", hotTree.findAll("an"), {19, 21, 26, 29});
+    checkPositions("count 's' after relayout", {hotTree.count("s"), hotTree.search("bandana"), hotTree.search("bandanas")}, {4, 1, 0});
+    SuffixTree hotClone = hotTree.clone();
+    checkPositions("clone after relayout", hotClone.findAll("ssi"), {2, 5});
+
+    // Relayout of an open tree, then keep appending
+    SuffixTree hotOpen;
+    hotOpen.setHeatSampling(true);
+    hotOpen.append("abcabxabcd");
+    for (std::string p : {"abc", "abx", "bc", "c"}) hotOpen.search(p);
+    hotOpen.relayoutByHeat();
+    hotOpen.append("abcabx");
+    hotOpen.finish();
+    checkPositions("append after relayout", hotOpen.findAll("abcab"), {0, 10});
+
+    // Repeated relayouts with a shifting hot set reuse the region and the
+    // vacated slots: the arena (measured by the snapshot) stops growing
+    std::string dna;
+    std::srand(87);
+    for (int i = 0; i < 5000; i++) dna += "acgt"[std::rand() % 4];
+    SuffixTree shifting(dna);
+    shifting.setHeatSampling(true);
+    std::vector<size_t> snapshotSizes;
+    for (int round = 0; round < 12; round++) {
+        for (int q = 0; q < 100; q++) shifting.search(dna.substr((round * 401 + q * 37) % 4990, 6));
+        shifting.relayoutByHeat(100 + 50 * (round % 3));
+        std::ostringstream snapshot;
+        shifting.save(snapshot);
+        snapshotSizes.push_back(snapshot.str().size());
+    }
+    checkPositions("relayout memory bounded", {snapshotSizes[11] == snapshotSizes[3]}, {1});
+    checkPositions("findAll after relayouts", shifting.findAll("acgta"), SuffixTree(dna).findAll("acgta"));
+    std::cout << std::endl;
+
+    // TEST CASE 18: Query Cache
+    std::cout << "Running Test: Query Cache" << std::endl;
+    SuffixTree cachedTree;
+    cachedTree.enableQueryCache(1 << 20);
+    cachedTree.append("abcab");
+    checkPositions("cached findAll (miss)", cachedTree.findAll("abc"), {0});
+    checkPositions("cached findAll (hit)", cachedTree.findAll("abc"), {0});
+    cachedTree.search("ca");
+    cachedTree.search("ca");
+    QueryCacheStats cacheStats = cachedTree.queryCacheStats();
+    checkPositions("hits / misses", {(int)cacheStats.hits, (int)cacheStats.misses}, {2, 2});
+    int openCount = cachedTree.count("ab"); // Open tree: only suffixes in leaves
+
+    // Appending must not serve results of the shorter text
+    cachedTree.append("xab");
+    cachedTree.finish();
+    checkPositions("invalidated by append", cachedTree.findAll("ab"), {0, 3, 6});
+    checkPositions("count after append", {openCount, cachedTree.count("ab"), cachedTree.search("bx")}, {1, 3, 1});
+
+    // A tiny budget keeps evicting
+    SuffixTree smallCache("mississippi");
+    smallCache.enableQueryCache(1024, 1);
+    for (std::string p : {"m", "i", "s", "p", "ss", "si", "ip", "is", "ppi", "ssi"}) smallCache.findAll(p);
+    cacheStats = smallCache.queryCacheStats();
+    checkPositions("bounded in bytes", {cacheStats.bytes <= 1024, cacheStats.evictions > 0}, {1, 1});
+    checkPositions("correct under eviction", smallCache.findAll("ssi"), {2, 5});
+
+    // A result computed before an invalidate() is not stored as current
+    QueryCache raw(1 << 16);
+    QueryCache::Result rawResult;
+    uint64_t seenGeneration;
+    bool rawHit = raw.lookup(QueryCache::Op::Count, "ab", rawResult, seenGeneration);
+    raw.invalidate(); // The index changes while the miss is being computed
+    rawResult.number = 1;
+    raw.insert(QueryCache::Op::Count, "ab", rawResult, seenGeneration);
+    bool staleServed = raw.lookup(QueryCache::Op::Count, "ab", rawResult, seenGeneration);
+    rawResult.number = 3;
+    raw.insert(QueryCache::Op::Count, "ab", rawResult, seenGeneration);
+    QueryCache::Result fresh;
+    bool freshHit = raw.lookup(QueryCache::Op::Count, "ab", fresh, seenGeneration);
+    checkPositions("insert after invalidate dropped", {rawHit, staleServed, freshHit, fresh.number}, {0, 0, 1, 3});
+    std::cout << std::endl;
+
+    // TEST CASE 19: q-gram Prefilter
+    std::cout << "Running Test: q-gram Prefilter" << std::endl;
+    SuffixTree filtered("the quick brown fox jumps over the lazy dog");
+    filtered.enableQGramFilter(3);
+    checkPositions("present patterns pass", {filtered.search("quick"), filtered.count("the"), filtered.search("he")}, {1, 2, 1});
+    checkPositions("absent patterns rejected", {filtered.search("quack"), filtered.count("lazy cat")}, {0, 0});
+    std::vector<bool> batch = filtered.searchBatch({"fox", "wolf", "over the", "ov", "dogs"});
+    checkPositions("searchBatch", {batch[0], batch[1], batch[2], batch[3], batch[4]}, {1, 0, 1, 1, 0});
+
+    // The filter follows online appends, including q-grams across chunks
+    SuffixTree filteredOpen;
+    filteredOpen.enableQGramFilter(4);
+    filteredOpen.append("abcd");
+    filteredOpen.append("efgh");
+    checkPositions("q-gram across append", {filteredOpen.search("cdef"), filteredOpen.search("cdeg")}, {1, 0});
+    std::cout << std::endl;
+
+    // TEST CASE 20: Sorted Batch Search
+    std::cout << "Running Test: Sorted Batch Search" << std::endl;
+    SuffixTree paths("/usr/lib/x86/libc.so /usr/local/bin/tool /usr/lib/x86/libm.so");
+    std::vector<std::string> queries = {"/usr/lib/x86/libm", "/usr/lib/x86/libz", "/usr/local", "",
+                                        "/usr/lib/x86/libc.so /usr", "/usr/lib/", "/usr/libx", "/opt",
+                                        "/usr/lib/x86/libc", "/usr/lib/x86/libm.so$", "/usr/lib/x86/libm.sox"};
+    std::vector<bool> sortedBatch = paths.searchBatchSorted(queries);
+    int sortedAgree = 0;
+    for (size_t i = 0; i < queries.size(); i++) sortedAgree += sortedBatch[i] == paths.search(queries[i]);
+    checkPositions("matches search()", {sortedAgree}, {(int)queries.size()});
+    checkPositions("input order kept", {sortedBatch[0], sortedBatch[1], sortedBatch[7], sortedBatch[8]}, {1, 0, 0, 1});
+
+    // Large enough batch for the radix passes
+    std::vector<std::string> manyQueries;
+    for (int i = 0; i < 200; i++) {
+        manyQueries.push_back("/usr/" + std::string(i % 3 ? "loc" : "lib") + "/x86/lib" + std::string(1, 'a' + i % 26) + (i % 2 ? ".so" : ""));
+    }
+    std::vector<bool> manySorted = paths.searchBatchSorted(manyQueries);
+    sortedAgree = 0;
+    int sortedHits = 0;
+    for (size_t i = 0; i < manyQueries.size(); i++) {
+        sortedAgree += manySorted[i] == paths.search(manyQueries[i]);
+        sortedHits += manySorted[i];
+    }
+    checkPositions("large batch matches search()", {sortedAgree, sortedHits > 0}, {(int)manyQueries.size(), 1});
+    std::cout << std::endl;
+
+    // TEST CASE 21: Fingerprint Search
+    std::cout << "Running Test: Fingerprint Search" << std::endl;
+    std::string longText;
+    for (int i = 0; i < 400; i++) longText += "block" + std::to_string(i % 37) + (i % 5 ? "-" : "+");
+    SuffixTree plainLong(longText);
+    SuffixTree printed(longText);
+    printed.enableFingerprints();
+    std::string longHit = longText.substr(500, 300);
+    std::string longMiss = longHit;
+    longMiss[150] = '#';
+    checkPositions("long pattern present", {printed.search(longHit), printed.count(longHit)},
+                   {plainLong.search(longHit), plainLong.count(longHit)});
+    checkPositions("long pattern findAll", printed.findAll(longHit), plainLong.findAll(longHit));
+    checkPositions("long pattern absent", {printed.search(longMiss), printed.count(longMiss)}, {0, 0});
+
+    // Fingerprints follow appends
+    SuffixTree printedOpen;
+    printedOpen.enableFingerprints();
+    printedOpen.append(longText.substr(0, 700));
+    printedOpen.append(longText.substr(700));
+    printedOpen.finish();
+    checkPositions("fingerprints after append", printedOpen.findAll(longHit), plainLong.findAll(longHit));
+    std::cout << std::endl;
+
+    // TEST CASE 22: Snapshots and Sharded Index
+    std::cout << "Running Test: Snapshots and Sharded Index" << std::endl;
+    std::stringstream snapshotBytes;
+    SuffixTree("mississippi").save(snapshotBytes);
+    SuffixTree reloaded = SuffixTree::load(snapshotBytes);
+    checkPositions("snapshot round trip", reloaded.findAll("ssi"), {2, 5});
+    checkPositions("snapshot node count", {reloaded.getNodeCount()}, {SuffixTree("mississippi").getNodeCount()});
+    std::stringstream garbage("not a tree");
+    bool badSnapshot = false;
+    try { SuffixTree::load(garbage); } catch (const std::runtime_error&) { badSnapshot = true; }
+    checkPositions("bad snapshot rejected", {badSnapshot}, {1});
+
+    // Damage each word of a snapshot in turn, both with a wild value and by
+    // shifting it one node: load() must either succeed or throw, never
+    // follow a pointer out of the arena
+    std::stringstream pristineBytes;
+    SuffixTree("abracadabra").save(pristineBytes);
+    const std::string pristine = pristineBytes.str();
+    int damagedRejected = 0, damagedOther = 0;
+    for (size_t at = 0; at + 8 <= pristine.size(); at += 8) {
+        for (int mutation = 0; mutation < 2; mutation++) {
+            std::string damaged = pristine;
+            uint64_t word;
+            std::memcpy(&word, &damaged[at], 8);
+            word = mutation == 0 ? 0x4141414141414141ULL : word + sizeof(Node);
+            std::memcpy(&damaged[at], &word, 8);
+            std::stringstream in(damaged);
+            try {
+                SuffixTree::load(in).count("a");
+            } catch (const std::runtime_error&) {
+                damagedRejected++;
+            } catch (...) {
+                damagedOther++;
+            }
+        }
+    }
+    checkPositions("damaged snapshots rejected or loaded", {damagedRejected > 0, damagedOther}, {1, 0});
+
+    std::vector<std::string> shardDocs = {"banana bread", "bandana", "cabana", "anagram", "nan", "an ant", "banal"};
+    std::string joined;
+    for (auto &d : shardDocs) joined += d + "\x1f";
+    SuffixTree whole(joined);
+    ShardedSuffixIndex sharded(shardDocs, 3, 2);
+    auto global = [](std::vector<int64_t> v) { return std::vector<int>(v.begin(), v.end()); };
+    checkPositions("shards built", {sharded.shardCount()}, {3});
+    checkPositions("sharded findAll 'an'", global(sharded.findAll("an")), whole.findAll("an"));
+    checkPositions("sharded count 'ana'", {(int)sharded.count("ana")}, {whole.count("ana")});
+    checkPositions("sharded search", {sharded.search("gram"), sharded.search("bread b")}, {1, 0});
+    checkPositions("sharded documents 'ban'", sharded.documents("ban"), {0, 1, 2, 6});
+    checkPositions("sharded rejects '$' patterns", {(int)sharded.count("$"), (int)sharded.findAll("a$").size()}, {0, 0});
+    bool dollarRejected = false;
+    try { ShardedSuffixIndex({"ab", "c$d"}, 1, 1); } catch (const std::invalid_argument&) { dollarRejected = true; }
+    checkPositions("sharded rejects '$' documents", {dollarRejected}, {1});
+
+    std::string indexDir = (std::filesystem::temp_directory_path() / "ukkonen_sharded_test").string();
+    sharded.save(indexDir);
+    auto lazy = ShardedSuffixIndex::load(indexDir, 2);
+    checkPositions("shards not loaded yet", {lazy->isLoaded(0), lazy->isLoaded(2)}, {0, 0});
+    checkPositions("loaded findAll 'an'", global(lazy->findAll("an")), whole.findAll("an"));
+    checkPositions("loaded documents 'nan'", lazy->documents("nan"), {0, 4});
+    checkPositions("shards loaded on use", {lazy->isLoaded(0), lazy->isLoaded(2)}, {1, 1});
+    std::vector<int> loadedLengths, builtLengths;
+    for (int d = 0; d < sharded.getDocuments().size(); d++) {
+        loadedLengths.push_back(lazy->getDocuments().length(d));
+        builtLengths.push_back(sharded.getDocuments().length(d));
+    }
+    checkPositions("document starts mapped back", loadedLengths, builtLengths);
+    std::ifstream manifestFile(std::filesystem::path(indexDir) / "manifest.txt");
+    int manifestLines = 0;
+    for (std::string line; std::getline(manifestFile, line);) manifestLines++;
+    checkPositions("manifest has no per-document lines", {manifestLines}, {2 + sharded.shardCount()});
+    // Manifests whose shards do not cover the documents exactly, or with
+    // bad counts or separator, are refused before any start is read
+    std::string manifestText;
+    {
+        std::ifstream in(std::filesystem::path(indexDir) / "manifest.txt");
+        manifestText.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::vector<std::string> manifestLinesRead;
+    for (std::istringstream in(manifestText); std::getline(in, manifestLinesRead.emplace_back());) {}
+    manifestLinesRead.pop_back();
+    int badManifests = 0;
+    auto tryManifest = [&](int line, const std::string &replacement) {
+        std::vector<std::string> edited = manifestLinesRead;
+        edited[line] = replacement;
+        {
+            std::ofstream out(std::filesystem::path(indexDir) / "manifest.txt");
+            for (auto &l : edited) out << l << "\n";
+        }
+        try { ShardedSuffixIndex::load(indexDir); } catch (const std::runtime_error&) { badManifests++; }
+    };
+    int savedDocuments = sharded.getDocuments().size();
+    std::string countsTail = " " + std::to_string(savedDocuments) + " " + std::to_string(sharded.shardCount());
+    tryManifest(1, "300" + countsTail);                                     // Separator
+    tryManifest(1, "10 -1 " + std::to_string(sharded.shardCount()));        // Document count
+    tryManifest(1, "10 " + std::to_string(savedDocuments) + " -3");         // Shard count
+    tryManifest(2, "-1 " + manifestLinesRead[2].substr(manifestLinesRead[2].find(' ') + 1)); // First document
+    tryManifest(2, "1 " + manifestLinesRead[2].substr(manifestLinesRead[2].find(' ') + 1));  // Gap
+    tryManifest(2, "0 -2");                                                 // Negative shard
+    tryManifest(2, "0 1000");                                               // Past the last document
+    std::istringstream lastShard(manifestLinesRead.back());
+    int lastFirst, lastCount;
+    lastShard >> lastFirst >> lastCount;
+    tryManifest(manifestLinesRead.size() - 1, std::to_string(lastFirst) + " " + std::to_string(lastCount - 1)); // Short
+    checkPositions("inconsistent manifests rejected", {badManifests}, {8});
+    {
+        std::ofstream out(std::filesystem::path(indexDir) / "manifest.txt");
+        out << manifestText;
+    }
+    checkPositions("restored manifest loads", {ShardedSuffixIndex::load(indexDir)->shardCount()}, {sharded.shardCount()});
+    std::filesystem::resize_file(std::filesystem::path(indexDir) / "documents.bin", 8);
+    bool shortStartsRejected = false;
+    try { ShardedSuffixIndex::load(indexDir); } catch (const std::runtime_error&) { shortStartsRejected = true; }
+    checkPositions("truncated document starts rejected", {shortStartsRejected}, {1});
+    std::filesystem::remove_all(indexDir);
+
+    auto fromText = ShardedSuffixIndex::fromText(joined + "nana", '\x1f', 2, 2);
+    checkPositions("fromText records", {fromText->getDocuments().size()}, {8});
+    auto batchHits = fromText->findAll(std::vector<std::string>{"an", "nana", "zz"});
+    SuffixTree wholeWithTail(joined + "nana");
+    checkPositions("batch findAll 'an'", global(batchHits[0]), wholeWithTail.findAll("an"));
+    checkPositions("batch findAll unterminated tail", global(batchHits[1]), {2, (int)joined.size()});
+    checkPositions("batch findAll no match", global(batchHits[2]), {});
+    bool dollarTextRejected = false;
+    try {
+        ShardedSuffixIndex::fromText("price $5\nok\n", '\n');
+    } catch (const std::invalid_argument&) {
+        dollarTextRejected = true;
+    }
+    checkPositions("fromText rejects '$' archives", {dollarTextRejected}, {1});
+    checkPositions("batch '$' pattern matches nothing",
+                   {(int)fromText->findAll(std::vector<std::string>{"$", "a$"})[0].size()}, {0});
+    checkPositions("batch documents 'nan'", fromText->documents(std::vector<std::string>{"ban", "nan"})[1], {0, 4, 7});
+
+    std::string snapshotPath = (std::filesystem::temp_directory_path() / "ukkonen_mapped_test.ukst").string();
+    {
+        std::ofstream out(snapshotPath, std::ios::binary);
+        SuffixTree("mississippi").save(out);
+    }
+    checkPositions("loadMapped round trip", SuffixTree::loadMapped(snapshotPath).findAll("issi"), {1, 4});
+    std::filesystem::remove(snapshotPath);
+    std::cout << std::endl;
+
+    // TEST CASE 23: LSM Index (live tree + frozen segments)
+    std::cout << "Running Test: LSM Index" << std::endl;
+    std::string stream;
+    for (int i = 0; i < 60; i++) stream += (i % 7 == 3) ? "abba" : (i % 3 ? "ab" : "ba");
+    LsmOptions lsmOptions;
+    lsmOptions.liveLimit = 7;   // Many segments shorter than some patterns
+    lsmOptions.mergeFactor = 2;
+    lsmOptions.background = false;
+    LsmSuffixIndex lsm(lsmOptions);
+    for (size_t i = 0; i < stream.size(); i += 5) lsm.append(stream.substr(i, 5));
+    SuffixTree lsmReference(stream);
+    auto lsmPositions = [&](const std::string &p) {
+        std::vector<int64_t> v = lsm.findAll(p);
+        return std::vector<int>(v.begin(), v.end());
+    };
+    for (std::string p : {"ab", "bab", "abba", "aabbaa", "babaabab", "abababababab"}) {
+        checkPositions("lsm findAll '" + p + "'", lsmPositions(p), lsmReference.findAll(p));
+        checkPositions("lsm count '" + p + "'", {(int)lsm.count(p), lsm.search(p)},
+                       {lsmReference.count(p), lsmReference.search(p)});
+    }
+    LsmStats lsmStats = lsm.stats();
+    checkPositions("lsm compacted", {lsmStats.merges > 0, lsmStats.frozenSegments < lsmStats.freezes}, {1, 1});
+    checkPositions("lsm absent", {lsm.search("aaa"), (int)lsm.count("ab$")}, {0, 0});
+
+    // Background compaction gives the same answers
+    lsmOptions.background = true;
+    LsmSuffixIndex lsmAsync(lsmOptions);
+    lsmAsync.append(stream);
+    lsmAsync.flush();
+    lsmAsync.compact();
+    std::vector<int64_t> asyncHits = lsmAsync.findAll("bab");
+    checkPositions("lsm background", std::vector<int>(asyncHits.begin(), asyncHits.end()), lsmReference.findAll("bab"));
+
+    // However far the compactor lags, no level holds more than maxPerLevel
+    // segments: append() merges a full level itself
+    lsmOptions.maxPerLevel = 2;
+    LsmSuffixIndex lsmCapped(lsmOptions);
+    for (size_t i = 0; i < stream.size(); i += 5) lsmCapped.append(stream.substr(i, 5));
+    LsmStats cappedStats = lsmCapped.stats();
+    int lsmLevels = 0;
+    for (int64_t size = lsmOptions.liveLimit; size < (int64_t)stream.size(); size *= lsmOptions.mergeFactor) lsmLevels++;
+    checkPositions("lsm level cap", {cappedStats.frozenSegments <= lsmOptions.maxPerLevel * lsmLevels}, {1});
+    std::vector<int64_t> cappedHits = lsmCapped.findAll("abba");
+    checkPositions("lsm capped findAll", std::vector<int>(cappedHits.begin(), cappedHits.end()), lsmReference.findAll("abba"));
+    bool lsmRejected = false;
+    lsmOptions.maxPerLevel = 1;
+    try { LsmSuffixIndex bad(lsmOptions); } catch (const std::invalid_argument &) { lsmRejected = true; }
+    checkPositions("lsm maxPerLevel < mergeFactor rejected", {lsmRejected}, {1});
+    std::cout << std::endl;
+
+    // TEST CASE 24: Index Server over a UNIX Socket
+    std::cout << "Running Test: Index Server" << std::endl;
+    SuffixTree served("mississippi");
+    IndexServerOptions serverOptions;
+    serverOptions.socketPath = (std::filesystem::temp_directory_path() / "ukkonen_test.sock").string();
+    serverOptions.dispatchers = 2;
+    IndexServer server(served, serverOptions);
+    server.start();
+    {
+        IndexClient client(serverOptions.socketPath);
+        auto served64 = client.findAll("ssi");
+        checkPositions("served findAll", std::vector<int>(served64.begin(), served64.end()), {2, 5});
+        checkPositions("served search/count", {client.search("sip"), client.search("spi"), (int)client.count("i")},
+                       {1, 0, 4});
+        std::vector<bool> many = client.searchMany({"miss", "xyz", "ppi", "issip", "ississippi$x"});
+        checkPositions("served pipelined batch", std::vector<int>(many.begin(), many.end()), {1, 0, 1, 1, 0});
+
+        // Concurrent clients are coalesced into shared batches
+        std::vector<std::thread> clientThreads;
+        std::atomic<int> wrong{0};
+        for (int t = 0; t < 4; t++) {
+            clientThreads.emplace_back([&] {
+                IndexClient c(serverOptions.socketPath);
+                for (int i = 0; i < 200; i++) {
+                    if (c.count("ss") != 2 || !c.search("ippi")) wrong++;
+                }
+            });
+        }
+        for (auto &t : clientThreads) t.join();
+        checkPositions("concurrent clients", {wrong.load()}, {0});
+    }
+    server.stop();
+    checkPositions("server totals", {(int)server.stats().requests}, {4 + 5 + 4 * 400});
+
+    // A client that pipelines without reading its answers must not stall
+    // the others, and findAll answers above the cap are refused
+    IndexServerOptions guardedOptions = serverOptions;
+    guardedOptions.socketPath = (std::filesystem::temp_directory_path() / "ukkonen_guarded.sock").string();
+    guardedOptions.dispatchers = 1;
+    guardedOptions.maxPendingPerConnection = 16;
+    guardedOptions.maxFindAll = 3;
+    IndexServer guarded(served, guardedOptions);
+    guarded.start();
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, guardedOptions.socketPath.c_str());
+        int flooder = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        ::connect(flooder, (sockaddr*)&address, sizeof(address));
+        std::string flood;
+        for (uint32_t i = 0; i < 200000; i++) IndexProtocol::putRequest(flood, i, IndexProtocol::Op::Count, "i");
+        std::thread floodThread([&] { // Blocks once the server stops reading it
+            IndexProtocol::writeFully(flooder, flood.data(), flood.size());
+        });
+
+        IndexClient polite(guardedOptions.socketPath);
+        int politeRight = 0;
+        for (int i = 0; i < 100; i++) politeRight += polite.count("ss") == 2;
+        bool capped = false;
+        try { polite.findAll("i"); } catch (const std::runtime_error&) { capped = true; }
+        auto underCap = polite.findAll("ss");
+        checkPositions("flooding client does not stall others", {politeRight, capped, (int)underCap.size()}, {100, 1, 2});
+
+        guarded.stop(); // Unblocks the flooder
+        floodThread.join();
+        ::close(flooder);
+    }
+    std::cout << std::endl;
+
+    // TEST CASE 25: FASTA/FASTQ Ingestion
+    std::cout << "Running Test: FASTA/FASTQ Ingestion" << std::endl;
+    std::string fastaPath = (std::filesystem::temp_directory_path() / "ukkonen_test.fa").string();
+    std::string fastqPath = (std::filesystem::temp_directory_path() / "ukkonen_test.fq").string();
+    {
+        std::ofstream fa(fastaPath, std::ios::binary);
+        fa << ">chr1 first\nACGTAC\nGTTT\n\n>chr2\r\nTTTACG\r\nTACGTA\r\n>empty\n>chr3\nGTAC";
+        std::ofstream fq(fastqPath, std::ios::binary);
+        fq << "@read1\nACGTTT\n+\n@IIIII\n@read2\nTTTACG\n+read2\nIIIIII\n";
+    }
+    auto offsets = [](const std::vector<RecordPosition> &hits) {
+        std::vector<int> out;
+        for (auto &h : hits) out.push_back(h.record * 100 + h.offset);
+        return out;
+    };
+    SequenceIndex fastaIndex(fastaPath);
+    checkPositions("fasta records",
+                   {fastaIndex.recordCount(), (int)fastaIndex.recordLength(0), (int)fastaIndex.recordLength(2)},
+                   {4, 10, 0});
+    checkPositions("fasta names", {fastaIndex.recordName(0) == "chr1 first", fastaIndex.recordName(1) == "chr2"}, {1, 1});
+    checkPositions("fasta match across line break", offsets(fastaIndex.findAll("ACGT")), {0, 4, 103, 107});
+    checkPositions("fasta no cross-record match", {fastaIndex.count("TTTTTT"), fastaIndex.count("TAGTAC")}, {0, 0});
+    checkPositions("fasta records containing 'GTAC'", fastaIndex.records("GTAC"), {0, 1, 3});
+
+    SequenceIndex fastqIndex(fastqPath);
+    checkPositions("fastq skips qualities", {fastqIndex.recordCount(), fastqIndex.search("II"), fastqIndex.search("@")},
+                   {2, 0, 0});
+    checkPositions("fastq findAll 'TTTACG'", offsets(fastqIndex.findAll("TTTACG")), {100});
+    checkPositions("fastq findAll 'TT'", offsets(fastqIndex.findAll("TT")), {3, 4, 100, 101});
+    std::filesystem::remove(fastaPath);
+    std::filesystem::remove(fastqPath);
+    std::cout << std::endl;
+
+    // TEST CASE 26: Position-Range Queries and Pagination
+    std::cout << "Running Test: Position-Range Queries and Pagination" << std::endl;
+    SuffixTree ranged("abracadabra abracadabra");
+    checkPositions("range fallback", ranged.findAllInRange("abra", 5, 18), {7, 12});
+    ranged.enableRangeQueries();
+    checkPositions("findAllInRange 'abra' [5..18]", ranged.findAllInRange("abra", 5, 18), {7, 12});
+    checkPositions("findAllInRange must fit in range", ranged.findAllInRange("abra", 0, 9), {0});
+    checkPositions("countInRange 'a' [3..10]", {ranged.countInRange("a", 3, 10)}, {4});
+    checkPositions("range absent pattern", {ranged.countInRange("cab", 0, 100)}, {0});
+    checkPositions("range too narrow", ranged.findAllInRange("abra", 12, 14), {});
+
+    std::srand(97);
+    std::string rangeText;
+    for (int i = 0; i < 3000; i++) rangeText += "ab"[std::rand() % 2];
+    ranged.rebuild(rangeText);
+    int rangeMismatches = 0;
+    for (int q = 0; q < 200; q++) {
+        std::string p = rangeText.substr(std::rand() % 2990, 1 + std::rand() % 6);
+        int l = std::rand() % 3000, r = l + (int)(std::rand() % 800);
+        std::vector<int> expected;
+        for (size_t k = rangeText.find(p); k != std::string::npos; k = rangeText.find(p, k + 1)) {
+            if ((int)k >= l && (int)(k + p.size()) - 1 <= r) expected.push_back(k);
+        }
+        if (ranged.findAllInRange(p, l, r) != expected || ranged.countInRange(p, l, r) != (int)expected.size()) {
+            rangeMismatches++;
+        }
+    }
+    checkPositions("range queries after rebuild match brute force", {rangeMismatches}, {0});
+
+    std::vector<int> allAb = ranged.findAll("ab");
+    std::sort(allAb.begin(), allAb.end());
+    std::vector<int> paged;
+    for (int after = -1;;) {
+        std::vector<int> page = ranged.findAllSorted("ab", after, 100);
+        if (page.empty()) break;
+        paged.insert(paged.end(), page.begin(), page.end());
+        after = page.back();
+    }
+    checkPositions("paginated findAllSorted covers findAll", paged, allAb);
+    std::vector<int> deepPage(allAb.begin() + 501, allAb.begin() + 511);
+    checkPositions("findAllSorted deep page", ranged.findAllSorted("ab", allAb[500], 10), deepPage);
+    ranged.disableRangeQueries();
+    checkPositions("findAllSorted fallback", ranged.findAllSorted("ab", allAb[500], 10), deepPage);
+    std::cout << std::endl;
+
+    // TEST CASE 27: First/Last Occurrence
+    std::cout << "Running Test: First/Last Occurrence" << std::endl;
+    SuffixTree bounded("abracadabra abracadabra");
+    checkPositions("first/last fallback", {bounded.firstOccurrence("bra"), bounded.lastOccurrence("bra")}, {1, 20});
+    bounded.enableOccurrenceBounds();
+    checkPositions("firstOccurrence", {bounded.firstOccurrence("bra"), bounded.firstOccurrence("cad")}, {1, 4});
+    checkPositions("lastOccurrence", {bounded.lastOccurrence("bra"), bounded.lastOccurrence("a")}, {20, 22});
+    checkPositions("absent pattern", {bounded.firstOccurrence("xyz"), bounded.lastOccurrence("xyz")}, {-1, -1});
+    bounded.rebuild(rangeText);
+    int boundMismatches = 0;
+    for (int q = 0; q < 200; q++) {
+        std::string p = rangeText.substr(std::rand() % 2990, 1 + std::rand() % 8);
+        if (bounded.firstOccurrence(p) != (int)rangeText.find(p) ||
+            bounded.lastOccurrence(p) != (int)rangeText.rfind(p)) {
+            boundMismatches++;
+        }
+    }
+    checkPositions("bounds after rebuild match find/rfind", {boundMismatches}, {0});
+    std::cout << std::endl;
+
+    // TEST CASE 28: Bottom-Up Annotation
+    std::cout << "Running Test: Bottom-Up Annotation" << std::endl;
+    std::string annotatedText;
+    for (int i = 0; i < 60000; i++) annotatedText += "acgt"[std::rand() % 4];
+    SuffixTree annotated(annotatedText);
+    auto leafCount = [](int) { return 1; };
+    auto sum = [](int &into, const int &child) { into += child; };
+    std::vector<int> inlineCounts = annotated.annotateBottomUp<int>(leafCount, sum, 1);
+    std::vector<int> parallelCounts = annotated.annotateBottomUp<int>(leafCount, sum, 4);
+    checkPositions("annotation covers every node", {(int)parallelCounts.size()}, {annotated.getNodeCount()});
+    checkPositions("parallel matches inline", {parallelCounts == inlineCounts}, {1});
+    checkPositions("root counts every suffix", {*std::max_element(parallelCounts.begin(), parallelCounts.end())},
+                   {(int)annotatedText.size() + 1});
+
+    // Left-diversity: the character before each suffix, or '*' once two differ
+    std::vector<char> left = annotated.annotateBottomUp<char>(
+        [&](int pos) { return pos == 0 ? '*' : annotatedText[pos - 1]; },
+        [](char &into, const char &child) { if (into != child) into = '*'; }, 4);
+    checkPositions("left-diverse nodes exist", {(int)std::count(left.begin(), left.end(), '*') > 0}, {1});
+
+    annotated.enableOccurrenceBounds();
+    std::string probe = annotatedText.substr(31337, 7);
+    checkPositions("parallel bounds", {annotated.firstOccurrence(probe), annotated.lastOccurrence(probe)},
+                   {(int)annotatedText.find(probe), (int)annotatedText.rfind(probe)});
+    std::cout << std::endl;
+
+    // TEST CASE 29: Visual Verification
     std::cout << ">> Visual Verification for 'xabxa':" << std::endl;
     SuffixTree visTree("xabxa");
     visTree.printTree();
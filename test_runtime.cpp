@@ -12,6 +12,20 @@
 #include <chrono>  
 #include <random>   
 #include "suffixtree.h" 
+#include "suffix_forest.h"
+#include "suffixtree_pool.h"
+#include "batch_builder.h"
+#include "streaming_builder.h"
+#include "reclaimer.h"
+#include "sharded_index.h"
+#include "lsm_index.h"
+#include "sequence_index.h"
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
 
 void runCorrectnessTest() {
     std::cout << "\n--- Correctness Tests ---" << std::endl;
@@ -113,6 +127,650 @@ void simd_comparison() {
     
 }
 
+// Many short records: one SuffixTree each vs one shared SuffixForest
+void runForestBenchmark(int records) {
+    std::cout << "\n--- Forest Test (" << records << " records of 50-500 chars) ---" << std::endl;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> len(50, 500);
+    std::vector<std::string> batch(records);
+    for (auto &r : batch) r = generateRandomText(len(gen));
+
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        std::vector<SuffixTree*> trees;
+        trees.reserve(records);
+        for (auto const& r : batch) trees.push_back(new SuffixTree(r));
+        for (SuffixTree *t : trees) delete t;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> separate = end - start;
+
+    start = std::chrono::high_resolution_clock::now();
+    {
+        SuffixForest forest(batch);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> shared = end - start;
+
+    std::cout << "Separate trees (build + destroy): " << separate.count() << " ms" << std::endl;
+    std::cout << "Suffix forest  (build + destroy): " << shared.count() << " ms" << std::endl;
+}
+
+// Per-request trees: fresh construction vs rebuilding a pooled tree
+void runRebuildBenchmark(int requests, int length) {
+    std::cout << "\n--- Rebuild Test (" << requests << " requests of " << length << " chars) ---" << std::endl;
+    std::vector<std::string> inputs(16);
+    for (auto &in : inputs) in = generateRandomDNA(length);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < requests; i++) {
+        SuffixTree tree(inputs[i % inputs.size()]);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> fresh = end - start;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < requests; i++) {
+        SuffixTreePool::Lease tree = SuffixTreePool::acquire(inputs[i % inputs.size()]);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> pooled = end - start;
+
+    std::cout << "Fresh construction: " << fresh.count() << " ms" << std::endl;
+    std::cout << "Pooled rebuild:     " << pooled.count() << " ms" << std::endl;
+}
+
+// Batch of medium documents: sequential builds vs interleaved builds
+void runInterleavedBenchmark(int documents, int length) {
+    std::cout << "\n--- Interleaved Build Test (" << documents << " documents of " << length << " chars) ---" << std::endl;
+    std::vector<std::string> inputs(documents);
+    for (auto &in : inputs) in = generateRandomDNA(length);
+    std::vector<std::string_view> views(inputs.begin(), inputs.end());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        std::vector<std::unique_ptr<SuffixTree>> trees;
+        for (auto const& in : inputs) trees.emplace_back(new SuffixTree(in));
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> sequential = end - start;
+    std::cout << "Sequential:       " << sequential.count() << " ms" << std::endl;
+
+    for (int group : {2, 4, 8, 16}) {
+        start = std::chrono::high_resolution_clock::now();
+        {
+            auto trees = SuffixTree::buildInterleaved(views, group);
+        }
+        end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = end - start;
+        std::cout << "Interleaved (G=" << group << "): " << elapsed.count() << " ms" << std::endl;
+    }
+}
+
+// Many independent documents of mixed sizes on a work-stealing pool
+void runBatchBuildBenchmark(int documents) {
+    std::cout << "\n--- Batch Build Test (" << documents << " documents of 1k-200k chars) ---" << std::endl;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<> len(1000, 200000);
+    std::vector<std::string> inputs(documents);
+    for (auto &in : inputs) in = generateRandomDNA(len(gen));
+    std::vector<std::string_view> views(inputs.begin(), inputs.end());
+
+    int hw = std::max(1u, std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= hw; threads *= 2) {
+        BuildReport report;
+        auto trees = buildMany(views, threads, &report);
+        std::vector<double> latency = report.latencyMs;
+        std::sort(latency.begin(), latency.end());
+        std::cout << "Threads: " << threads
+                  << " | " << report.charsPerSecond / 1e6 << " M chars/s"
+                  << " | p50 " << latency[latency.size() / 2] << " ms"
+                  << " | max " << latency.back() << " ms" << std::endl;
+    }
+}
+
+// FASTA file on disk: streamed build vs. read everything, then build
+void runStreamingBenchmark(int length) {
+    std::cout << "\n--- Streaming Build Test (FASTA, " << length << " bases) ---" << std::endl;
+    std::string path = (std::filesystem::temp_directory_path() / "ukkonen_stream_bench.fa").string();
+    {
+        std::string dna = generateRandomDNA(length);
+        std::ofstream out(path, std::ios::binary);
+        out << ">chr1 synthetic\n";
+        for (int i = 0; i < length; i += 60) out << dna.substr(i, 60) << '\n';
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string whole;
+    {
+        std::ifstream in(path, std::ios::binary);
+        whole.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        FastaDecoder decoder;
+        whole.resize(decoder.decode(whole.data(), whole.size()));
+    }
+    SuffixTree loaded(std::move(whole));
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    std::cout << "Read, then build: " << elapsed.count() << " ms" << std::endl;
+
+    FastaDecoder decoder;
+    StreamingReport report;
+    auto streamed = buildFromFile(path, decoder, StreamingOptions(), &report);
+    std::cout << "Streamed:         " << report.seconds * 1000 << " ms"
+              << " (read+decode " << report.readSeconds * 1000 << " ms"
+              << ", build " << report.buildSeconds * 1000 << " ms"
+              << ", build waited " << report.waitSeconds * 1000 << " ms)" << std::endl;
+    std::cout << "Same tree: " << (streamed->getNodeCount() == loaded.getNodeCount() ? "yes" : "NO") << std::endl;
+    std::filesystem::remove(path);
+}
+
+// Time the calling thread spends dropping a large tree
+void runReleaseBenchmark(int length) {
+    std::cout << "\n--- Release Test (" << length << " chars) ---" << std::endl;
+    std::string dna = generateRandomDNA(length);
+
+    auto tree = std::make_unique<SuffixTree>(dna);
+    auto start = std::chrono::high_resolution_clock::now();
+    tree.reset();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    std::cout << "Destructor:   " << elapsed.count() << " ms" << std::endl;
+
+    tree = std::make_unique<SuffixTree>(dna);
+    start = std::chrono::high_resolution_clock::now();
+    tree->releaseAsync();
+    end = std::chrono::high_resolution_clock::now();
+    elapsed = end - start;
+    std::cout << "releaseAsync: " << elapsed.count() << " ms (caller)" << std::endl;
+    Reclaimer::instance().drain();
+}
+
+// Snapshotting an index: clone() vs. building it again
+void runCloneBenchmark(int length) {
+    std::cout << "\n--- Clone Test (" << length << " chars) ---" << std::endl;
+    std::string dna = generateRandomDNA(length);
+    SuffixTree tree(dna);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    SuffixTree rebuilt(dna);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    std::cout << "Rebuild: " << elapsed.count() << " ms" << std::endl;
+
+    start = std::chrono::high_resolution_clock::now();
+    SuffixTree copy = tree.clone();
+    end = std::chrono::high_resolution_clock::now();
+    elapsed = end - start;
+    std::cout << "Clone:   " << elapsed.count() << " ms" << std::endl;
+
+    start = std::chrono::high_resolution_clock::now();
+    SuffixTree moved = std::move(copy);
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::micro> micros = end - start;
+    std::cout << "Move:    " << micros.count() << " us" << std::endl;
+}
+
+// Indices 0..n-1 drawn with probability proportional to 1 / (i + 1)^s
+std::vector<int> generateZipfian(int n, double s, int draws, unsigned seed) {
+    std::vector<double> weights(n);
+    for (int i = 0; i < n; i++) weights[i] = 1.0 / std::pow(i + 1, s);
+    std::discrete_distribution<int> dist(weights.begin(), weights.end());
+    std::mt19937 gen(seed);
+    std::vector<int> out(draws);
+    for (int &x : out) x = dist(gen);
+    return out;
+}
+
+// Skewed query mix: search() before and after relayoutByHeat()
+void runRelayoutBenchmark(int length, int queries) {
+    std::cout << "\n--- Heat Relayout Test (" << length << " chars, " << queries << " Zipfian queries) ---" << std::endl;
+    std::string dna = generateRandomDNA(length);
+    SuffixTree tree(dna);
+
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<> where(0, length - 32);
+    std::vector<std::string> patterns(5000);
+    for (auto &p : patterns) p = dna.substr(where(gen), 24);
+    std::vector<int> mix = generateZipfian(patterns.size(), 1.1, queries, 5);
+
+    auto timeQueries = [&]() {
+        int hits = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int q : mix) hits += tree.search(patterns[q]);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = end - start;
+        return std::make_pair(elapsed.count(), hits);
+    };
+
+    timeQueries(); // Warm-up
+    auto [before, hitsBefore] = timeQueries();
+    tree.setHeatSampling(true);
+    auto [sampled, hitsSampled] = timeQueries();
+    int moved = tree.relayoutByHeat(64 * 1024);
+    tree.setHeatSampling(false);
+    auto [after, hitsAfter] = timeQueries();
+
+    std::cout << "Baseline:        " << before << " ms" << std::endl;
+    std::cout << "With sampling:   " << sampled << " ms" << std::endl;
+    std::cout << "After relayout:  " << after << " ms (" << moved << " nodes moved)" << std::endl;
+    std::cout << "Same results: " << (hitsBefore == hitsAfter && hitsSampled == hitsAfter ? "yes" : "NO") << std::endl;
+}
+
+// Repeated queries: findAll() with and without the result cache
+void runQueryCacheBenchmark(int length, int queries) {
+    std::cout << "\n--- Query Cache Test (" << length << " chars, " << queries << " Zipfian findAll) ---" << std::endl;
+    std::string dna = generateRandomDNA(length);
+    SuffixTree tree(dna);
+
+    std::mt19937 gen(13);
+    std::uniform_int_distribution<> where(0, length - 16);
+    std::uniform_int_distribution<> len(6, 10);
+    std::vector<std::string> patterns(20000);
+    for (auto &p : patterns) p = dna.substr(where(gen), len(gen));
+    std::vector<int> mix = generateZipfian(patterns.size(), 1.0, queries, 17);
+
+    auto timeQueries = [&]() {
+        size_t found = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int q : mix) found += tree.findAll(patterns[q]).size();
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = end - start;
+        return std::make_pair(elapsed.count(), found);
+    };
+
+    auto [uncached, foundUncached] = timeQueries();
+    std::cout << "No cache:     " << uncached << " ms" << std::endl;
+
+    for (size_t budget : {256u << 10, 4u << 20}) {
+        tree.enableQueryCache(budget);
+        auto [cached, foundCached] = timeQueries();
+        QueryCacheStats stats = tree.queryCacheStats();
+        std::cout << "Cache " << (budget >> 10) << " KB: " << cached << " ms"
+                  << " | hit rate " << 100.0 * stats.hits / (stats.hits + stats.misses) << "%"
+                  << " | " << stats.entries << " entries, " << stats.evictions << " evictions"
+                  << (foundCached == foundUncached ? "" : " | MISMATCH") << std::endl;
+    }
+    tree.disableQueryCache();
+}
+
+// Mostly-absent patterns: search() with and without the q-gram prefilter
+void runPrefilterBenchmark(int length, int queries, int q) {
+    std::cout << "\n--- q-gram Prefilter Test (" << length << " chars, " << queries << " queries, 90% absent, q=" << q << ") ---" << std::endl;
+    std::string text = generateRandomText(length);
+    SuffixTree tree(text);
+
+    std::mt19937 gen(19);
+    std::uniform_int_distribution<> where(0, length - 32);
+    std::uniform_int_distribution<> ch(33, 126);
+    std::vector<std::string> patterns(queries);
+    for (int i = 0; i < queries; i++) {
+        if (i % 10 == 0) {
+            patterns[i] = text.substr(where(gen), 16);
+        } else {
+            // A present prefix followed by random characters: misses late
+            patterns[i] = text.substr(where(gen), 6);
+            for (int k = 0; k < 10; k++) patterns[i] += (char)ch(gen);
+        }
+    }
+
+    auto timeQueries = [&](bool batch) {
+        int hits = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        if (batch) {
+            for (bool f : tree.searchBatch(patterns)) hits += f;
+        } else {
+            for (auto &p : patterns) hits += tree.search(p);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = end - start;
+        return std::make_pair(elapsed.count(), hits);
+    };
+
+    auto [plain, hitsPlain] = timeQueries(false);
+    tree.enableQGramFilter(q);
+    auto [filtered, hitsFiltered] = timeQueries(false);
+    auto [batched, hitsBatched] = timeQueries(true);
+
+    // False positives: absent patterns the filter let through
+    int absent = 0, passed = 0;
+    for (auto &p : patterns) {
+        if (tree.search(p)) continue;
+        absent++;
+        passed += tree.getQGramFilter()->mayContain(p.data(), p.size());
+    }
+
+    std::cout << "No filter:        " << plain << " ms" << std::endl;
+    std::cout << "Filter:           " << filtered << " ms" << std::endl;
+    std::cout << "Filter (batch):   " << batched << " ms" << std::endl;
+    std::cout << "False positives:  " << 100.0 * passed / absent << "% of absent patterns"
+              << " | filter " << tree.getQGramFilter()->memoryBytes() / 1024 << " KB"
+              << (hitsPlain == hitsFiltered && hitsPlain == hitsBatched ? "" : " | MISMATCH") << std::endl;
+}
+
+// Batch of URL-like patterns with long shared prefixes
+void runSortedBatchBenchmark(int urls, int queries) {
+    std::cout << "\n--- Sorted Batch Search Test (" << urls << " URLs, " << queries << " queries) ---" << std::endl;
+    std::mt19937 gen(23);
+    std::uniform_int_distribution<> pick(0, 63);
+    auto makeUrl = [&]() {
+        std::string url = "https://example.com/api/v2/";
+        for (int level = 0; level < 4; level++) url += "section" + std::to_string(pick(gen) % 8) + "/";
+        return url + "item" + std::to_string(pick(gen));
+    };
+
+    std::string text;
+    for (int i = 0; i < urls; i++) text += makeUrl() + " ";
+    SuffixTree tree(text);
+
+    std::vector<std::string> batch(queries);
+    for (auto &q : batch) q = makeUrl();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    int hits = 0;
+    for (auto &q : batch) hits += tree.search(q);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    std::cout << "search() each:      " << elapsed.count() << " ms (" << hits << " hits)" << std::endl;
+
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<bool> found = tree.searchBatchSorted(batch);
+    end = std::chrono::high_resolution_clock::now();
+    elapsed = end - start;
+    int sortedHits = std::count(found.begin(), found.end(), true);
+    std::cout << "searchBatchSorted:  " << elapsed.count() << " ms (" << sortedHits << " hits)" << std::endl;
+}
+
+// Very long patterns over repetitive text: byte-wise vs. fingerprint edges
+void runFingerprintBenchmark(int length, int patternLength, int queries) {
+    std::cout << "\n--- Fingerprint Search Test (" << length << " chars, " << queries
+              << " patterns of " << patternLength << ") ---" << std::endl;
+    // Mutated copies of one block: long shared substrings, deep paths
+    std::string block = generateRandomDNA(20000);
+    std::mt19937 gen(29);
+    std::uniform_int_distribution<> where(0, 19999);
+    std::uniform_int_distribution<> base(0, 3);
+    std::string text;
+    while ((int)text.size() < length) {
+        std::string copy = block;
+        for (int k = 0; k < 20; k++) copy[where(gen)] = "ACGT"[base(gen)];
+        text += copy;
+    }
+    SuffixTree tree(text);
+
+    std::uniform_int_distribution<> start(0, (int)text.size() - patternLength - 1);
+    std::vector<std::string> patterns(queries);
+    for (int i = 0; i < queries; i++) {
+        patterns[i] = text.substr(start(gen), patternLength);
+        if (i % 2) patterns[i][patternLength - 10] = 'N'; // Half miss near the end
+    }
+
+    auto timeQueries = [&]() {
+        int hits = 0;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (auto &p : patterns) hits += tree.count(p) > 0;
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = t1 - t0;
+        return std::make_pair(elapsed.count(), hits);
+    };
+
+    auto [bytewise, hitsBytewise] = timeQueries();
+    tree.enableFingerprints();
+    auto [printed, hitsPrinted] = timeQueries();
+    std::cout << "Byte-wise edges:   " << bytewise << " ms" << std::endl;
+    std::cout << "Fingerprint edges: " << printed << " ms"
+              << (hitsBytewise == hitsPrinted ? "" : " | MISMATCH") << std::endl;
+}
+
+void runShardedBenchmark(int documents, int length, int queries) {
+    std::cout << "\n--- Sharded Index Test (" << documents << " documents of " << length << " chars) ---" << std::endl;
+    std::vector<std::string> docs(documents);
+    std::string joined;
+    for (auto &d : docs) {
+        d = generateRandomText(length);
+        joined += d + '\x1f';
+    }
+    std::mt19937 gen(31);
+    std::uniform_int_distribution<> pick(0, (int)joined.size() - 9);
+    std::vector<std::string> patterns;
+    while ((int)patterns.size() < queries) {
+        std::string p = joined.substr(pick(gen), 8);
+        if (p.find('\x1f') == std::string::npos) patterns.push_back(p);
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    SuffixTree single(joined);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    ShardedSuffixIndex sharded(docs);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    long singleHits = 0, shardedHits = 0;
+    for (auto &p : patterns) singleHits += single.count(p);
+    auto t3 = std::chrono::high_resolution_clock::now();
+    for (auto &p : patterns) shardedHits += sharded.count(p);
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::milli> singleBuild = t1 - t0, shardedBuild = t2 - t1;
+    std::chrono::duration<double, std::milli> singleQuery = t3 - t2, shardedQuery = t4 - t3;
+    std::cout << "Single tree:    build " << singleBuild.count() << " ms | " << queries
+              << " counts " << singleQuery.count() << " ms" << std::endl;
+    std::cout << sharded.shardCount() << " shards:       build " << shardedBuild.count() << " ms | " << queries
+              << " counts " << shardedQuery.count() << " ms"
+              << (singleHits == shardedHits ? "" : " | MISMATCH") << std::endl;
+}
+
+void runLsmBenchmark(int length, int chunk) {
+    std::cout << "\n--- LSM Index Test (" << length << " chars in chunks of " << chunk
+              << ", queries running concurrently) ---" << std::endl;
+    std::string text = generateRandomDNA(length);
+    LsmOptions options;
+    options.liveLimit = 256 * 1024;
+    LsmSuffixIndex index(options);
+
+    std::atomic<bool> done{false};
+    std::vector<double> latencyUs;
+    std::thread reader([&] {
+        std::mt19937 gen(37);
+        std::uniform_int_distribution<> pick(0, length / 4);
+        while (!done.load()) {
+            std::string p = text.substr(pick(gen), 12);
+            auto t0 = std::chrono::high_resolution_clock::now();
+            index.count(p);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            latencyUs.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+        }
+    });
+
+    // Ingest rate per tenth of the input, while merges run at low priority
+    std::vector<double> rates;
+    int slice = length / 10;
+    for (int s = 0; s < 10; s++) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int i = s * slice; i < (s + 1) * slice; i += chunk) {
+            index.append(std::string_view(text).substr(i, std::min(chunk, (s + 1) * slice - i)));
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        rates.push_back(slice / std::chrono::duration<double>(t1 - t0).count() / 1e6);
+    }
+    done = true;
+    reader.join();
+    LsmStats during = index.stats();
+
+    // Merges deferred by the deprioritized compactor finish here
+    auto c0 = std::chrono::high_resolution_clock::now();
+    index.compact();
+    auto c1 = std::chrono::high_resolution_clock::now();
+
+    std::sort(latencyUs.begin(), latencyUs.end());
+    auto pct = [&](double q) { return latencyUs.empty() ? 0.0 : latencyUs[(size_t)(q * (latencyUs.size() - 1))]; };
+    std::cout << "Ingest MB/s per tenth:";
+    for (double r : rates) std::cout << " " << std::round(r * 10) / 10;
+    LsmStats stats = index.stats();
+    std::cout << "\nQueries: " << latencyUs.size() << " | p50 " << pct(0.5) << " us | p99 " << pct(0.99)
+              << " us | max " << pct(1.0) << " us" << std::endl;
+    std::cout << "During ingest: segments " << during.frozenSegments << " | freezes " << during.freezes
+              << " | merges " << during.merges << " | inline merges " << during.inlineMerges << std::endl;
+    std::cout << "After compact(): segments " << stats.frozenSegments << " | merges " << stats.merges << " in "
+              << std::chrono::duration<double, std::milli>(c1 - c0).count() << " ms" << std::endl;
+}
+
+void runSequenceBenchmark(int records, int length) {
+    std::cout << "\n--- FASTA Ingestion Test (" << records << " records of " << length << " bases) ---" << std::endl;
+    std::string path = (std::filesystem::temp_directory_path() / "ukkonen_bench.fa").string();
+    {
+        std::ofstream out(path, std::ios::binary);
+        for (int r = 0; r < records; r++) {
+            std::string seq = generateRandomDNA(length);
+            out << ">record" << r << "\n";
+            for (int i = 0; i < length; i += 60) out << seq.substr(i, 60) << "\n";
+        }
+    }
+
+    // What the Python callers did: read the file, join the sequence lines
+    auto t0 = std::chrono::high_resolution_clock::now();
+    std::string joined;
+    {
+        std::ifstream in(path);
+        for (std::string line; std::getline(in, line);) {
+            if (line.empty()) continue;
+            if (line[0] == '>') {
+                if (!joined.empty()) joined += '\x1f';
+            } else {
+                joined += line;
+            }
+        }
+    }
+    SuffixTree concatenated(joined);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    SequenceIndex index(path);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    SequenceReader reader(path);
+    SequenceReader::Record record;
+    long lines = 0;
+    while (reader.next(record)) lines += record.lines.size();
+    auto t3 = std::chrono::high_resolution_clock::now();
+    std::filesystem::remove(path);
+
+    std::chrono::duration<double, std::milli> joinBuild = t1 - t0, indexBuild = t2 - t1, parse = t3 - t2;
+    std::cout << "Read + join + build:  " << joinBuild.count() << " ms" << std::endl;
+    std::cout << "SequenceIndex:        " << indexBuild.count() << " ms (parse alone " << parse.count() << " ms, "
+              << lines << " lines)" << std::endl;
+}
+
+void runRangeQueryBenchmark(int length, int queries) {
+    std::cout << "\n--- Position-Range Query Test (" << length << " chars, " << queries
+              << " queries on 1% windows) ---" << std::endl;
+    std::string text = generateRandomDNA(length);
+    SuffixTree tree(text);
+    auto t0 = std::chrono::high_resolution_clock::now();
+    tree.enableRangeQueries();
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    std::mt19937 gen(41);
+    std::uniform_int_distribution<> pick(0, length - length / 100 - 1);
+    std::vector<std::pair<std::string, int>> work;
+    for (int q = 0; q < queries; q++) work.push_back({text.substr(pick(gen), 4), pick(gen)});
+
+    long filtered = 0, ranged = 0, occurrences = 0;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    for (auto &[p, l] : work) {
+        for (int pos : tree.findAll(p)) filtered += pos >= l && pos + 3 <= l + length / 100;
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+    for (auto &[p, l] : work) ranged += tree.findAllInRange(p, l, l + length / 100).size();
+    auto t4 = std::chrono::high_resolution_clock::now();
+    for (auto &[p, l] : work) occurrences += tree.count(p);
+
+    std::chrono::duration<double, std::milli> build = t1 - t0, filter = t3 - t2, range = t4 - t3;
+    std::cout << "Leaf index build: " << build.count() << " ms | " << occurrences / queries
+              << " occurrences per pattern, " << ranged / queries << " in range" << std::endl;
+    std::cout << "findAll + filter: " << filter.count() << " ms" << std::endl;
+    std::cout << "findAllInRange:   " << range.count() << " ms"
+              << (filtered == ranged ? "" : " | MISMATCH") << std::endl;
+}
+
+void runPaginationBenchmark(int length, int pages) {
+    std::cout << "\n--- Paginated Output Test (" << length << " chars, " << pages
+              << " pages of 100 at random depths) ---" << std::endl;
+    std::string text = generateRandomDNA(length);
+    SuffixTree tree(text);
+    tree.enableRangeQueries();
+    std::mt19937 gen(43);
+    std::uniform_int_distribution<> pick(0, length - 1);
+    std::vector<std::pair<std::string, int>> work;
+    for (int q = 0; q < pages; q++) work.push_back({text.substr(pick(gen) % (length - 2), 2), pick(gen)});
+
+    long sortedSum = 0, pagedSum = 0;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (auto &[p, after] : work) {
+        std::vector<int> all = tree.findAll(p);
+        std::sort(all.begin(), all.end());
+        auto from = std::upper_bound(all.begin(), all.end(), after);
+        for (int k = 0; k < 100 && from + k < all.end(); k++) sortedSum += from[k];
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (auto &[p, after] : work) {
+        for (int pos : tree.findAllSorted(p, after, 100)) pagedSum += pos;
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::milli> sorted = t1 - t0, paged = t2 - t1;
+    std::cout << "findAll + sort: " << sorted.count() << " ms" << std::endl;
+    std::cout << "findAllSorted:  " << paged.count() << " ms"
+              << (sortedSum == pagedSum ? "" : " | MISMATCH") << std::endl;
+}
+
+void runOccurrenceBoundsBenchmark(int length, int queries) {
+    std::cout << "\n--- First Occurrence Test (" << length << " chars, " << queries << " 3-mer queries) ---"
+              << std::endl;
+    std::string text = generateRandomDNA(length);
+    SuffixTree tree(text);
+    auto t0 = std::chrono::high_resolution_clock::now();
+    tree.enableOccurrenceBounds();
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    std::mt19937 gen(47);
+    std::uniform_int_distribution<> pick(0, length - 4);
+    std::vector<std::string> patterns;
+    for (int q = 0; q < queries; q++) patterns.push_back(text.substr(pick(gen), 3));
+
+    long scanned = 0, annotated = 0;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    for (auto &p : patterns) {
+        std::vector<int> all = tree.findAll(p);
+        scanned += *std::min_element(all.begin(), all.end());
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+    for (auto &p : patterns) annotated += tree.firstOccurrence(p);
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::milli> build = t1 - t0, scan = t3 - t2, lookup = t4 - t3;
+    std::cout << "Bounds pass:     " << build.count() << " ms" << std::endl;
+    std::cout << "findAll + min:   " << scan.count() << " ms" << std::endl;
+    std::cout << "firstOccurrence: " << lookup.count() << " ms"
+              << (scanned == annotated ? "" : " | MISMATCH") << std::endl;
+}
+
+void runAnnotationBenchmark(int length) {
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "\n--- Bottom-Up Annotation Test (" << length << " chars, leaf counts, 1 vs " << threads
+              << " threads) ---" << std::endl;
+    SuffixTree tree(generateRandomDNA(length));
+    auto leafCount = [](int) { return 1; };
+    auto sum = [](int &into, const int &child) { into += child; };
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    std::vector<int> serial = tree.annotateBottomUp<int>(leafCount, sum, 1);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::vector<int> parallel = tree.annotateBottomUp<int>(leafCount, sum, threads);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::milli> one = t1 - t0, many = t2 - t1;
+    std::cout << tree.getNodeCount() << " nodes" << std::endl;
+    std::cout << "1 thread:   " << one.count() << " ms" << std::endl;
+    std::cout << threads << " threads:  " << many.count() << " ms" << (serial == parallel ? "" : " | MISMATCH")
+              << std::endl;
+}
+
 int main() {
 
     runCorrectnessTest(); // 1. Basic Correctness Test
@@ -129,5 +787,43 @@ int main() {
 
 
     simd_comparison();
+
+    runForestBenchmark(20000);
+
+    runRebuildBenchmark(20000, 1000);
+
+    runInterleavedBenchmark(32, 200000);
+
+    runBatchBuildBenchmark(64);
+
+    runStreamingBenchmark(2000000);
+
+    runReleaseBenchmark(2000000);
+
+    runCloneBenchmark(2000000);
+
+    runRelayoutBenchmark(2000000, 1000000);
+
+    runQueryCacheBenchmark(1000000, 200000);
+
+    runPrefilterBenchmark(2000000, 1000000, 4);
+
+    runSortedBatchBenchmark(50000, 500000);
+
+    runFingerprintBenchmark(2000000, 4096, 20000);
+
+    runShardedBenchmark(200, 10000, 20000);
+
+    runLsmBenchmark(8000000, 4096);
+
+    runSequenceBenchmark(2000, 1000);
+
+    runRangeQueryBenchmark(2000000, 2000);
+
+    runPaginationBenchmark(2000000, 500);
+
+    runOccurrenceBoundsBenchmark(2000000, 2000);
+
+    runAnnotationBenchmark(4000000);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace {
+thread_local int workerIndex = -1;
+}
+
+WorkStealingPool::WorkStealingPool(int threads) : queued(0), pending(0), nextQueue(0), stopping(false) {
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &w : workers) w.join();
+}
+
+int WorkStealingPool::currentWorker() {
+    return workerIndex;
+}
+
+void WorkStealingPool::submit(std::function<void()> task, int hint) {
+    int target = hint >= 0 ? hint % size() : (int)(nextQueue++ % size());
+    pending++;
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    finished.wait(lock, [this] { return pending.load() == 0; });
+}
+
+bool WorkStealingPool::takeTask(int self, std::function<void()> &task) {
+    // 1. Own deque, oldest first
+    {
+        Queue &own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    // 2. Steal from the back of the other deques
+    for (int k = 1; k < size(); k++) {
+        Queue &victim = *queues[(self + k) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(int self) {
+    workerIndex = self;
+    std::function<void()> task;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || queued > 0; });
+            if (queued == 0) return; // Stopping and nothing left to run
+            queued--;                // Claim one queued task
+        }
+
+        // A claim guarantees some deque holds a task for us
+        while (!takeTask(self, task)) std::this_thread::yield();
+        task();
+        task = nullptr;
+
+        if (--pending == 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            finished.notify_all();
+        }
+    }
+}
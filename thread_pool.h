@@ -0,0 +1,68 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * WorkStealingPool: fixed set of worker threads, one task deque each.
+ * A worker takes tasks from the front of its own deque and, when that is
+ * empty, steals from the back of another worker's deque, so tasks queued
+ * in a deliberate order (e.g. largest first) are started in that order
+ * while idle workers still pick up the leftovers.
+ */
+class WorkStealingPool {
+public:
+    // threads <= 0 uses std::thread::hardware_concurrency()
+    explicit WorkStealingPool(int threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Queues a task on worker 'hint' (round-robin if negative)
+    void submit(std::function<void()> task, int hint = -1);
+
+    // Blocks until every submitted task has finished
+    void wait();
+
+    int size() const { return (int)workers.size(); }
+
+    // Index of the calling thread within its pool, -1 outside any pool
+    static int currentWorker();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;      // Signalled when tasks are queued
+    std::condition_variable finished;  // Signalled when 'pending' drops to 0
+    int queued;                        // Tasks sitting in deques (sleepMutex)
+    std::atomic<int> pending;          // Tasks submitted and not yet finished
+    std::atomic<unsigned> nextQueue;
+    bool stopping;
+
+    bool takeTask(int self, std::function<void()> &task);
+    void workerLoop(int self);
+};
+
+#endif // THREAD_POOL_H
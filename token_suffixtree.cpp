@@ -0,0 +1,223 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "token_suffixtree.h"
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include <thread>
+
+// --- TokenDictionary ---
+
+TokenDictionary::TokenDictionary() : slots(1024, -1), mask(1023) {}
+
+uint64_t TokenDictionary::hash(std::string_view s) {
+    // Word-at-a-time multiplicative hash; tokens are short so this is
+    // usually one or two rounds.
+    const uint64_t k = 0x9E3779B97F4A7C15ULL;
+    uint64_t h = s.size() * k;
+    size_t i = 0;
+    for (; i + 8 <= s.size(); i += 8) {
+        uint64_t w;
+        std::memcpy(&w, s.data() + i, 8);
+        h = (h ^ w) * k;
+        h ^= h >> 29;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, s.data() + i, s.size() - i);
+    h = (h ^ tail) * k;
+    return h ^ (h >> 32);
+}
+
+int TokenDictionary::find(std::string_view token) const {
+    uint64_t h = hash(token);
+    for (uint64_t i = h & mask;; i = (i + 1) & mask) {
+        int id = slots[i];
+        if (id < 0) return -1;
+        if (hashes[id] == h && tokens[id] == token) return id;
+    }
+}
+
+int TokenDictionary::intern(std::string_view token) {
+    uint64_t h = hash(token);
+    uint64_t i = h & mask;
+    for (;; i = (i + 1) & mask) {
+        int id = slots[i];
+        if (id < 0) break;
+        if (hashes[id] == h && tokens[id] == token) return id;
+    }
+
+    int id = tokens.size();
+    tokens.emplace_back(token);
+    hashes.push_back(h);
+    slots[i] = id;
+
+    // Keep the load factor below 1/2
+    if (tokens.size() * 2 > slots.size()) grow();
+    return id;
+}
+
+void TokenDictionary::grow() {
+    slots.assign(slots.size() * 2, -1);
+    mask = slots.size() - 1;
+    for (int id = 0; id < (int)tokens.size(); id++) {
+        uint64_t i = hashes[id] & mask;
+        while (slots[i] >= 0) i = (i + 1) & mask;
+        slots[i] = id;
+    }
+}
+
+// --- Tokenizer ---
+
+std::vector<std::string_view> Tokenizer::split(std::string_view phrase) {
+    std::vector<std::string_view> tokens;
+    size_t i = 0, n = phrase.size();
+    while (i < n) {
+        while (i < n && isDelimiter(phrase[i])) i++;
+        size_t begin = i;
+        while (i < n && !isDelimiter(phrase[i])) i++;
+        if (i > begin) tokens.push_back(phrase.substr(begin, i - begin));
+    }
+    return tokens;
+}
+
+TokenStream Tokenizer::tokenize(const std::string &text, TokenDictionary &dict, int threads) {
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t n = text.size();
+
+    // Not worth spawning threads for small inputs
+    const size_t minBytesPerThread = 1 << 16;
+    threads = (int)std::min<size_t>(threads, std::max<size_t>(1, n / minBytesPerThread));
+
+    // Cut the text at delimiters so that no token spans two ranges
+    std::vector<size_t> cuts = {0};
+    for (int t = 1; t < threads; t++) {
+        size_t p = std::max(n * t / threads, cuts.back());
+        while (p < n && !isDelimiter(text[p])) p++;
+        cuts.push_back(p);
+    }
+    cuts.push_back(n);
+
+    struct Local {
+        TokenDictionary dict;
+        std::vector<int> ids;
+        std::vector<int> offsets;
+    };
+    std::vector<Local> locals(threads);
+
+    auto scan = [&](int t) {
+        Local &local = locals[t];
+        size_t i = cuts[t], end = cuts[t + 1];
+        while (i < end) {
+            while (i < end && isDelimiter(text[i])) i++;
+            size_t begin = i;
+            while (i < end && !isDelimiter(text[i])) i++;
+            if (i > begin) {
+                local.ids.push_back(local.dict.intern(std::string_view(text).substr(begin, i - begin)));
+                local.offsets.push_back((int)begin);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) workers.emplace_back(scan, t);
+    scan(0);
+    for (auto &w : workers) w.join();
+
+    // Merge local dictionaries in range order so IDs follow first occurrence
+    std::vector<std::vector<int>> remap(threads);
+    std::vector<size_t> base(threads + 1, 0);
+    for (int t = 0; t < threads; t++) {
+        Local &local = locals[t];
+        remap[t].resize(local.dict.size());
+        for (int id = 0; id < local.dict.size(); id++) {
+            remap[t][id] = dict.intern(local.dict.token(id));
+        }
+        base[t + 1] = base[t] + local.ids.size();
+    }
+
+    TokenStream stream;
+    stream.ids.resize(base[threads]);
+    stream.offsets.resize(base[threads]);
+
+    auto rewrite = [&](int t) {
+        Local &local = locals[t];
+        for (size_t k = 0; k < local.ids.size(); k++) {
+            stream.ids[base[t] + k] = remap[t][local.ids[k]];
+        }
+        std::memcpy(stream.offsets.data() + base[t], local.offsets.data(), local.offsets.size() * sizeof(int));
+    };
+
+    workers.clear();
+    for (int t = 1; t < threads; t++) workers.emplace_back(rewrite, t);
+    rewrite(0);
+    for (auto &w : workers) w.join();
+
+    return stream;
+}
+
+// --- TokenSuffixTree ---
+
+TokenSuffixTree::TokenSuffixTree(const std::string &text, int threads) {
+    TokenStream stream = Tokenizer::tokenize(text, dict, threads);
+    offsets = std::move(stream.offsets);
+    tree = std::make_unique<SymbolSuffixTree<int>>(std::move(stream.ids), TERMINATOR);
+}
+
+bool TokenSuffixTree::encode(const std::vector<std::string_view> &tokens, std::vector<int> &ids) const {
+    ids.clear();
+    ids.reserve(tokens.size());
+    for (auto token : tokens) {
+        int id = dict.find(token);
+        if (id < 0) return false; // Unknown token: the phrase cannot occur
+        ids.push_back(id);
+    }
+    return true;
+}
+
+bool TokenSuffixTree::searchPhrase(const std::string &phrase) {
+    std::vector<int> ids;
+    return encode(Tokenizer::split(phrase), ids) && tree->search(ids);
+}
+
+bool TokenSuffixTree::searchPhrase(const std::vector<std::string> &tokens) {
+    std::vector<std::string_view> views(tokens.begin(), tokens.end());
+    std::vector<int> ids;
+    return encode(views, ids) && tree->search(ids);
+}
+
+std::vector<int> TokenSuffixTree::findAll(const std::string &phrase) {
+    std::vector<int> ids;
+    if (!encode(Tokenizer::split(phrase), ids)) return {};
+    if (ids.empty()) {
+        // Every token position, without the terminator suffix
+        std::vector<int> positions(getTokenCount());
+        std::iota(positions.begin(), positions.end(), 0);
+        return positions;
+    }
+    return tree->findAll(ids);
+}
+
+std::vector<int> TokenSuffixTree::findAllOffsets(const std::string &phrase) {
+    std::vector<int> positions = findAll(phrase);
+    for (int &p : positions) p = offsets[p];
+    return positions;
+}
+
+int TokenSuffixTree::count(const std::string &phrase) {
+    std::vector<int> ids;
+    if (!encode(Tokenizer::split(phrase), ids)) return 0;
+    if (ids.empty()) return getTokenCount();
+    return tree->count(ids);
+}
+
+void TokenSuffixTree::printTree() {
+    tree->printTree([this](std::ostream &out, int id) {
+        if (id == TERMINATOR) out << "$";
+        else out << dict.token(id) << ' ';
+    });
+}
@@ -0,0 +1,113 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef TOKEN_SUFFIX_TREE_H
+#define TOKEN_SUFFIX_TREE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include "suffixtree_symbol.h"
+
+/**
+ * TokenDictionary: maps token strings to dense integer IDs (0, 1, 2, ...)
+ * in order of first insertion. Open addressing with linear probing over a
+ * power-of-two table of IDs; the strings themselves live in 'tokens'.
+ */
+class TokenDictionary {
+public:
+    TokenDictionary();
+
+    // Returns the ID of 'token', inserting it if it is new
+    int intern(std::string_view token);
+
+    // Returns the ID of 'token', or -1 if it was never interned
+    int find(std::string_view token) const;
+
+    const std::string& token(int id) const { return tokens[id]; }
+    int size() const { return (int)tokens.size(); }
+
+private:
+    std::vector<std::string> tokens;
+    std::vector<uint64_t> hashes; // Cached hash per ID (used when growing)
+    std::vector<int> slots;       // -1 = empty, otherwise token ID
+    uint64_t mask;
+
+    static uint64_t hash(std::string_view s);
+    void grow();
+};
+
+/**
+ * Result of tokenizing a text: one ID per token plus the byte offset at
+ * which each token starts in the original text.
+ */
+struct TokenStream {
+    std::vector<int> ids;
+    std::vector<int> offsets;
+};
+
+/**
+ * Tokenizer: splits on ASCII whitespace. The text is cut into 'threads'
+ * ranges at whitespace boundaries; each range is tokenized into a local
+ * dictionary in parallel, the local dictionaries are merged in range order
+ * and the ID sequences remapped in parallel. IDs therefore follow first
+ * occurrence in the whole text, exactly as a sequential pass would assign.
+ */
+class Tokenizer {
+public:
+    // threads <= 0 uses std::thread::hardware_concurrency()
+    static TokenStream tokenize(const std::string &text, TokenDictionary &dict, int threads = 0);
+
+    // Splits a phrase into its token strings (single-threaded)
+    static std::vector<std::string_view> split(std::string_view phrase);
+
+    static bool isDelimiter(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+    }
+};
+
+/**
+ * TokenSuffixTree: suffix tree over token IDs rather than bytes.
+ * Edges and nodes scale with the number of tokens, so node count drops
+ * roughly by the average token length compared to the byte-level tree.
+ */
+class TokenSuffixTree {
+public:
+    TokenSuffixTree(const std::string &text, int threads = 0);
+
+    // Phrase queries: the phrase is tokenized with the same tokenizer
+    bool searchPhrase(const std::string &phrase);
+    bool searchPhrase(const std::vector<std::string> &tokens);
+
+    // Token indices at which the phrase starts (unsorted)
+    std::vector<int> findAll(const std::string &phrase);
+
+    // Byte offsets in the original text at which the phrase starts (unsorted)
+    std::vector<int> findAllOffsets(const std::string &phrase);
+
+    int count(const std::string &phrase);
+
+    int getNodeCount() const { return tree->getNodeCount(); }
+    int getTokenCount() const { return (int)offsets.size(); }
+    int getVocabularySize() const { return dict.size(); }
+
+    void printTree();
+
+private:
+    static constexpr int TERMINATOR = -1;
+
+    TokenDictionary dict;
+    std::vector<int> offsets;
+    std::unique_ptr<SymbolSuffixTree<int>> tree;
+
+    // Maps phrase tokens to IDs; false if any token is not in the text
+    bool encode(const std::vector<std::string_view> &tokens, std::vector<int> &ids) const;
+};
+
+#endif // TOKEN_SUFFIX_TREE_H
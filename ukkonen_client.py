@@ -0,0 +1,64 @@
+"""
+Ukkonen's algorithm
+
+Thin client for ukkonen-server (see index_protocol.h for the wire format).
+Lets many Python processes share one index instead of each building its own
+pyukkonen.SuffixTree.
+
+    client = UkkonenClient("/tmp/ukkonen.sock")
+    client.search("nana"); client.count("a"); client.find_all("ana")
+"""
+
+import socket
+import struct
+
+SEARCH, COUNT, FIND_ALL = 1, 2, 3
+
+
+class UkkonenClient:
+    def __init__(self, socket_path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(socket_path)
+        self.next_id = 0
+
+    def close(self):
+        self.sock.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def _read(self, n):
+        data = bytearray()
+        while len(data) < n:
+            chunk = self.sock.recv(n - len(data))
+            if not chunk:
+                raise ConnectionError("ukkonen-server closed the connection")
+            data += chunk
+        return bytes(data)
+
+    def _call(self, op, pattern):
+        body = pattern.encode() if isinstance(pattern, str) else bytes(pattern)
+        request_id = self.next_id
+        self.next_id = (self.next_id + 1) & 0xFFFFFFFF
+        self.sock.sendall(struct.pack("<IIB", 5 + len(body), request_id, op) + body)
+
+        (length,) = struct.unpack("<I", self._read(4))
+        payload = self._read(length)
+        answered, status = struct.unpack_from("<IB", payload)
+        if answered != request_id or status != 0:
+            raise RuntimeError("ukkonen-server rejected the request")
+        return payload[5:]
+
+    def search(self, pattern):
+        return self._call(SEARCH, pattern)[0] != 0
+
+    def count(self, pattern):
+        return struct.unpack("<q", self._call(COUNT, pattern))[0]
+
+    def find_all(self, pattern):
+        body = self._call(FIND_ALL, pattern)
+        (n,) = struct.unpack_from("<I", body)
+        return list(struct.unpack_from("<%dq" % n, body, 4))
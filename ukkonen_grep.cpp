@@ -0,0 +1,153 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * ukkonen-grep: fixed-string grep over a prebuilt index, so repeated scans
+ * of the same archive cost time proportional to the matches, not to the
+ * archive size.
+ *
+ *   ukkonen-grep build ARCHIVE INDEX_DIR [--shards N] [--threads N]
+ *   ukkonen-grep query INDEX_DIR [PATTERN_FILE | -] [-n] [--positions] [--count] [--threads N]
+ *
+ * Every line of the archive is one document of a ShardedSuffixIndex with
+ * '\n' as the separator, so matches never span lines. query prints each
+ * line matching any pattern once, in archive order (like grep -F -f);
+ * -n prefixes line numbers, --positions prints "offset<TAB>pattern" per
+ * occurrence and --count prints "count<TAB>pattern" per pattern. As with
+ * grep, the exit status is 1 when nothing matched and 2 on errors.
+ * Archives containing '$' (the trees' terminator) are refused by build;
+ * patterns containing it therefore never match.
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "sharded_index.h"
+
+static const char *SOURCE_NAME = "source.txt";
+
+static int usage() {
+    std::cerr << "usage: ukkonen-grep build ARCHIVE INDEX_DIR [--shards N] [--threads N]\n"
+              << "       ukkonen-grep query INDEX_DIR [PATTERN_FILE | -] [-n] [--positions] [--count] [--threads N]\n";
+    return 2;
+}
+
+static int build(const std::string &archive, const std::string &directory, int shards, int threads) {
+    MappedFile input(archive);
+    input.advise(MADV_SEQUENTIAL);
+
+    // '$' terminates the shard trees: lines holding it would lose matches
+    std::string_view text = input.view();
+    if (size_t dollar = text.find('$'); dollar != std::string_view::npos) {
+        long line = std::count(text.begin(), text.begin() + dollar, '\n') + 1;
+        std::cerr << "ukkonen-grep: " << archive << ":" << line << " contains '$', which the index cannot hold;"
+                  << " use grep -F for this archive" << std::endl;
+        return 2;
+    }
+    auto index = ShardedSuffixIndex::fromText(input.view(), '\n', shards, threads);
+    index->save(directory);
+
+    // Remember the archive so query can print lines straight from it
+    std::ofstream source(std::filesystem::path(directory) / SOURCE_NAME);
+    source << std::filesystem::absolute(archive).string() << "\n" << input.size() << "\n";
+    std::cerr << "ukkonen-grep: indexed " << index->getDocuments().size() << " lines in " << index->shardCount()
+              << " shards" << std::endl;
+    return 0;
+}
+
+static int query(const std::string &directory, const std::string &patternFile, bool lineNumbers, bool positions,
+                 bool counts, int threads) {
+    std::vector<std::string> patterns;
+    std::ifstream file;
+    if (patternFile != "-") {
+        file.open(patternFile);
+        if (!file) throw std::runtime_error("cannot open " + patternFile);
+    }
+    std::istream &in = patternFile == "-" ? std::cin : file;
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) patterns.push_back(line);
+    }
+
+    auto index = ShardedSuffixIndex::load(directory, threads);
+    std::ostream &out = std::cout;
+
+    if (positions || counts) {
+        std::vector<std::vector<int64_t>> hits = index->findAll(patterns);
+        if (counts) {
+            bool any = false;
+            for (size_t k = 0; k < patterns.size(); k++) {
+                out << hits[k].size() << "\t" << patterns[k] << "\n";
+                any |= !hits[k].empty();
+            }
+            return any ? 0 : 1;
+        }
+        std::vector<std::pair<int64_t, int>> all;
+        for (size_t k = 0; k < patterns.size(); k++) {
+            for (int64_t p : hits[k]) all.push_back({p, (int)k});
+        }
+        std::sort(all.begin(), all.end());
+        for (auto &[p, k] : all) out << p << "\t" << patterns[k] << "\n";
+        return all.empty() ? 1 : 0;
+    }
+
+    // Matching lines: union over patterns, printed from the archive
+    std::vector<int> lines;
+    for (auto &ids : index->documents(patterns)) lines.insert(lines.end(), ids.begin(), ids.end());
+    std::sort(lines.begin(), lines.end());
+    lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+
+    std::ifstream sourceFile(std::filesystem::path(directory) / SOURCE_NAME);
+    std::string archive;
+    size_t archiveSize = 0;
+    std::getline(sourceFile, archive);
+    sourceFile >> archiveSize;
+    const DocumentMap &docs = index->getDocuments();
+    std::unique_ptr<MappedFile> text;
+    try {
+        text = std::make_unique<MappedFile>(archive);
+        if (text->size() != archiveSize) text.reset();
+    } catch (const std::runtime_error&) {}
+    if (!text) std::cerr << "ukkonen-grep: archive " << archive << " missing or changed, printing line numbers\n";
+
+    for (int line : lines) {
+        if (lineNumbers || !text) out << line + 1 << (text ? ":" : "\n");
+        if (text) out << text->view().substr(docs.start(line), docs.length(line)) << "\n";
+    }
+    return lines.empty() ? 1 : 0; // Like grep: 1 when nothing matched
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) return usage();
+    std::string command = argv[1];
+    std::vector<std::string> args;
+    int shards = 0, threads = 0;
+    bool lineNumbers = false, positions = false, counts = false;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--shards" && i + 1 < argc) shards = std::stoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = std::stoi(argv[++i]);
+        else if (arg == "-n") lineNumbers = true;
+        else if (arg == "--positions") positions = true;
+        else if (arg == "--count") counts = true;
+        else args.push_back(arg);
+    }
+
+    std::ios::sync_with_stdio(false);
+    try {
+        if (command == "build" && args.size() == 2) return build(args[0], args[1], shards, threads);
+        if (command == "query" && (args.size() == 1 || args.size() == 2)) {
+            return query(args[0], args.size() == 2 ? args[1] : "-", lineNumbers, positions, counts, threads);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "ukkonen-grep: " << e.what() << std::endl;
+        return 2; // Like grep: 1 only means "no match"
+    }
+    return usage();
+}
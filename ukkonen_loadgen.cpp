@@ -0,0 +1,105 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Load generator for ukkonen-server: closed-loop clients, one connection
+ * each, sending patterns from a file (one per line) round-robin. Reports
+ * throughput and latency percentiles.
+ *
+ *   ukkonen-loadgen --socket /tmp/ukkonen.sock --patterns queries.txt
+ *                   [--clients 16] [--requests 100000] [--op search|count|findall]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "index_client.h"
+
+int main(int argc, char **argv) {
+    std::string socketPath, patternFile, op = "search";
+    int clients = 16;
+    long requests = 100000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        if (arg == "--socket") socketPath = value;
+        else if (arg == "--patterns") patternFile = value;
+        else if (arg == "--clients") clients = std::stoi(value);
+        else if (arg == "--requests") requests = std::stol(value);
+        else if (arg == "--op") op = value;
+    }
+    if (socketPath.empty() || patternFile.empty() || clients < 1 || requests < 0 ||
+        (op != "search" && op != "count" && op != "findall")) {
+        std::cerr << "usage: ukkonen-loadgen --socket PATH --patterns FILE [--clients N] [--requests N]"
+                  << " [--op search|count|findall]\n";
+        return 2;
+    }
+
+    std::vector<std::string> patterns;
+    std::ifstream in(patternFile);
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty()) patterns.push_back(line);
+    }
+    if (patterns.empty()) {
+        std::cerr << "ukkonen-loadgen: no patterns in " << patternFile << "\n";
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<double>> latency(clients);
+    std::vector<std::string> failures(clients); // Empty unless that client threw
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (int c = 0; c < clients; c++) {
+        threads.emplace_back([&, c] {
+            // An exception escaping a thread would call std::terminate
+            try {
+                IndexClient client(socketPath);
+                long mine = requests / clients + (c < requests % clients);
+                latency[c].reserve(mine);
+                for (long i = 0; i < mine; i++) {
+                    const std::string &p = patterns[(c + i * clients) % patterns.size()];
+                    auto t0 = Clock::now();
+                    if (op == "search") client.search(p);
+                    else if (op == "count") client.count(p);
+                    else client.findAll(p);
+                    latency[c].push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+                }
+            } catch (const std::exception &e) {
+                failures[c] = e.what();
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    int failed = 0;
+    for (int c = 0; c < clients; c++) {
+        if (failures[c].empty()) continue;
+        if (failed++ == 0) std::cerr << "ukkonen-loadgen: client " << c << " failed: " << failures[c] << "\n";
+    }
+    if (failed) {
+        std::cerr << "ukkonen-loadgen: " << failed << " of " << clients << " clients failed\n";
+        return 1;
+    }
+
+    std::vector<double> all;
+    for (auto &l : latency) all.insert(all.end(), l.begin(), l.end());
+    if (all.empty()) {
+        std::cout << "0 " << op << " requests sent\n";
+        return 0;
+    }
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double q) { return all[(size_t)(q * (all.size() - 1))]; };
+    std::cout << all.size() << " " << op << " requests from " << clients << " clients in " << seconds << " s\n";
+    std::cout << "QPS: " << (long)(all.size() / seconds) << "\n";
+    std::cout << "Latency us: p50 " << pct(0.5) << " | p90 " << pct(0.9) << " | p99 " << pct(0.99)
+              << " | p99.9 " << pct(0.999) << " | max " << pct(1.0) << "\n";
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * ukkonen-server: loads one index and serves it over a UNIX socket.
+ *
+ *   ukkonen-server --socket /tmp/ukkonen.sock --text corpus.txt
+ *   ukkonen-server --socket /tmp/ukkonen.sock --snapshot corpus.ukst
+ *
+ * Options: --max-batch N, --batch-window-us N, --dispatchers N,
+ *          --save-snapshot FILE (write the loaded index, then serve).
+ * Stops cleanly on SIGINT / SIGTERM.
+ */
+
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "index_server.h"
+
+static void usage() {
+    std::cerr << "usage: ukkonen-server --socket PATH (--text FILE | --snapshot FILE)\n"
+              << "                      [--max-batch N] [--batch-window-us N] [--dispatchers N]\n"
+              << "                      [--save-snapshot FILE]\n";
+}
+
+int main(int argc, char **argv) {
+    IndexServerOptions options;
+    std::string textFile, snapshotFile, saveFile;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--socket") options.socketPath = value;
+        else if (arg == "--text") textFile = value;
+        else if (arg == "--snapshot") snapshotFile = value;
+        else if (arg == "--save-snapshot") saveFile = value;
+        else if (arg == "--max-batch") options.maxBatch = std::stoi(value);
+        else if (arg == "--batch-window-us") options.batchWindowMicros = std::stoi(value);
+        else if (arg == "--dispatchers") options.dispatchers = std::stoi(value);
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (options.socketPath.empty() || textFile.empty() == snapshotFile.empty()) {
+        usage();
+        return 2;
+    }
+
+    // Block the stop signals before any thread starts; main waits for them
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    try {
+        std::unique_ptr<SuffixTree> tree;
+        if (!snapshotFile.empty()) {
+            tree = std::make_unique<SuffixTree>(SuffixTree::loadMapped(snapshotFile));
+        } else {
+            std::ifstream in(textFile, std::ios::binary);
+            if (!in) throw std::runtime_error("cannot open " + textFile);
+            std::stringstream text;
+            text << in.rdbuf();
+            tree = std::make_unique<SuffixTree>(text.str());
+        }
+        if (!saveFile.empty()) {
+            std::ofstream out(saveFile, std::ios::binary);
+            tree->save(out);
+            if (!out) throw std::runtime_error("cannot write " + saveFile);
+        }
+
+        IndexServer server(*tree, options);
+        server.start();
+        std::cerr << "ukkonen-server: " << tree->getText().size() - 1 << " bytes indexed, listening on "
+                  << options.socketPath << std::endl;
+
+        int signal;
+        sigwait(&stopSignals, &signal);
+        server.stop();
+        IndexServerStats stats = server.stats();
+        std::cerr << "ukkonen-server: " << stats.requests << " requests in " << stats.batches << " batches over "
+                  << stats.connections << " connections" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "ukkonen-server: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,520 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#include "utf8_suffixtree.h"
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#include <tmmintrin.h>
+// pshufb is SSSE3: the multi-byte paths are compiled for it and chosen at
+// run time, so a baseline SSE2 build still uses them where available
+#define UTF8_SIMD_MULTIBYTE 1
+#define UTF8_SIMD_TARGET __attribute__((target("ssse3")))
+static bool hasMultiByteSimd() {
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define UTF8_SIMD_MULTIBYTE 1
+#define UTF8_SIMD_TARGET
+static bool hasMultiByteSimd() { return true; }
+#endif
+
+// --- SIMD ASCII fast path ---
+
+/**
+ * widenAscii:
+ * Widens the 16 bytes at 'p' into code points at 'dst' and returns how
+ * many of them, from the start, are ASCII. Only those 'dst' slots are
+ * meaningful; all 16 may be written, so 'dst' needs room for 16.
+ */
+static inline int widenAscii(const uint8_t *p, uint32_t *dst) {
+#if defined(__SSE2__)
+    __m128i bytes = _mm_loadu_si128((const __m128i*)p);
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo16 = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi16 = _mm_unpackhi_epi8(bytes, zero);
+    _mm_storeu_si128((__m128i*)(dst + 0), _mm_unpacklo_epi16(lo16, zero));
+    _mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi16(lo16, zero));
+    _mm_storeu_si128((__m128i*)(dst + 8), _mm_unpacklo_epi16(hi16, zero));
+    _mm_storeu_si128((__m128i*)(dst + 12), _mm_unpackhi_epi16(hi16, zero));
+    // MoveMask collects the high bit of every byte: the lowest set bit is
+    // the first non-ASCII byte
+    int mask = _mm_movemask_epi8(bytes);
+    return mask ? __builtin_ctz(mask) : 16;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    uint8x16_t bytes = vld1q_u8(p);
+    uint16x8_t lo16 = vmovl_u8(vget_low_u8(bytes));
+    uint16x8_t hi16 = vmovl_u8(vget_high_u8(bytes));
+    vst1q_u32(dst + 0, vmovl_u16(vget_low_u16(lo16)));
+    vst1q_u32(dst + 4, vmovl_u16(vget_high_u16(lo16)));
+    vst1q_u32(dst + 8, vmovl_u16(vget_low_u16(hi16)));
+    vst1q_u32(dst + 12, vmovl_u16(vget_high_u16(hi16)));
+    if (vmaxvq_u8(bytes) < 0x80) return 16;
+    int ascii = 0;
+    while (p[ascii] < 0x80) ascii++;
+    return ascii;
+#else
+    int ascii = 0;
+    while (ascii < 16 && p[ascii] < 0x80) {
+        dst[ascii] = p[ascii];
+        ascii++;
+    }
+    return ascii;
+#endif
+}
+
+// --- SIMD multi-byte validation and decoding ---
+
+#if defined(UTF8_SIMD_MULTIBYTE)
+
+/*
+ * Keiser & Lemire, "Validating UTF-8 in less than one instruction per
+ * byte" (2021). Every byte is classified with three 16-entry tables, on
+ * the high and low nibble of the previous byte and the high nibble of
+ * this one; each table sets the error bits its nibble allows, so a bit
+ * survives the AND only for an invalid pair. Third and fourth bytes of
+ * 3- and 4-byte sequences are checked separately from prev2 / prev3.
+ */
+enum : uint8_t {
+    TOO_SHORT = 1 << 0,      // Lead not followed by a continuation
+    TOO_LONG = 1 << 1,       // Continuation after ASCII
+    OVERLONG_3 = 1 << 2,     // E0 followed by 80..9F
+    TOO_LARGE = 1 << 3,      // F4 followed by 90..BF, or lead F5..FF
+    SURROGATE = 1 << 4,      // ED followed by A0..BF
+    OVERLONG_2 = 1 << 5,     // C0, C1
+    TOO_LARGE_1000 = 1 << 6, // Lead F5..FF followed by 80..8F
+    OVERLONG_4 = 1 << 6,     // F0 followed by 80..8F
+    TWO_CONTS = 1 << 7,      // Continuation after a continuation (allowed by prev2 / prev3 only)
+    CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS,
+};
+
+alignas(16) static const uint8_t byte1High[16] = {
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+    TOO_SHORT | OVERLONG_2,
+    TOO_SHORT,
+    TOO_SHORT | OVERLONG_3 | SURROGATE,
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+alignas(16) static const uint8_t byte1Low[16] = {
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+    CARRY | OVERLONG_2,
+    CARRY,
+    CARRY,
+    CARRY | TOO_LARGE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+};
+alignas(16) static const uint8_t byte2High[16] = {
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+};
+
+// Byte shuffles that gather each 3-byte (2-byte) sequence into one
+// little-endian 32-bit lane, last byte lowest; -1 clears the byte
+alignas(16) static const int8_t gather3[16] = {2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1};
+alignas(16) static const int8_t gather2Low[16] = {1, 0, -1, -1, 3, 2, -1, -1, 5, 4, -1, -1, 7, 6, -1, -1};
+alignas(16) static const int8_t gather2High[16] = {9, 8, -1, -1, 11, 10, -1, -1, 13, 12, -1, -1, 15, 14, -1, -1};
+
+#if defined(__SSE2__)
+
+UTF8_SIMD_TARGET static inline __m128i utf8Errors(__m128i input, __m128i prev) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    __m128i special = _mm_and_si128(
+        _mm_and_si128(_mm_shuffle_epi8(_mm_load_si128((const __m128i*)byte1High),
+                                       _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                      _mm_shuffle_epi8(_mm_load_si128((const __m128i*)byte1Low), _mm_and_si128(prev1, nibble))),
+        _mm_shuffle_epi8(_mm_load_si128((const __m128i*)byte2High), _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+    // High bit set where a third or fourth byte must be a continuation
+    __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14), _mm_set1_epi8(0xE0 - 0x80));
+    __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13), _mm_set1_epi8((char)(0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must23, special);
+}
+
+/**
+ * Utf8Check:
+ * Validation state carried from one block to the next. check() takes
+ * whole 16-byte blocks; finish() checks the remaining bytes padded with
+ * zeros (a whole zero block if none remain), so a sequence cut by the end
+ * fails as TOO_SHORT. ASCII blocks only need the previous block not to
+ * end inside a sequence.
+ */
+struct Utf8Check {
+    __m128i prev = _mm_setzero_si128(), error = _mm_setzero_si128(), incomplete = _mm_setzero_si128();
+
+    UTF8_SIMD_TARGET void check(const uint8_t *s, size_t blocks) {
+        // A lead in the last 3 / 2 / 1 positions starts a sequence the
+        // next block must finish
+        const __m128i lastLeads = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+        for (size_t b = 0; b < blocks; b++) {
+            __m128i input = _mm_loadu_si128((const __m128i*)(s + 16 * b));
+            if (_mm_movemask_epi8(input) == 0) {
+                error = _mm_or_si128(error, incomplete);
+            } else {
+                error = _mm_or_si128(error, utf8Errors(input, prev));
+                incomplete = _mm_subs_epu8(input, lastLeads);
+            }
+            prev = input;
+        }
+    }
+
+    UTF8_SIMD_TARGET void finish(const uint8_t *s, size_t length) {
+        alignas(16) uint8_t tail[16] = {};
+        std::copy(s, s + length, tail);
+        error = _mm_or_si128(error, utf8Errors(_mm_load_si128((const __m128i*)tail), prev));
+    }
+
+    UTF8_SIMD_TARGET bool ok() const { return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF; }
+};
+
+// Decodes the four 3-byte sequences at 'p' (the caller checked the leads)
+UTF8_SIMD_TARGET static inline void widen3(const uint8_t *p, uint32_t *dst) {
+    __m128i x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)p), _mm_load_si128((const __m128i*)gather3));
+    __m128i cp = _mm_or_si128(_mm_and_si128(x, _mm_set1_epi32(0x3F)),
+                              _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 2), _mm_set1_epi32(0xFC0)),
+                                           _mm_and_si128(_mm_srli_epi32(x, 4), _mm_set1_epi32(0xF000))));
+    _mm_storeu_si128((__m128i*)dst, cp);
+}
+
+// Decodes the eight 2-byte sequences at 'p' (the caller checked the leads)
+UTF8_SIMD_TARGET static inline void widen2(const uint8_t *p, uint32_t *dst) {
+    __m128i bytes = _mm_loadu_si128((const __m128i*)p);
+    const __m128i low6 = _mm_set1_epi32(0x3F), high5 = _mm_set1_epi32(0x7C0);
+    __m128i lo = _mm_shuffle_epi8(bytes, _mm_load_si128((const __m128i*)gather2Low));
+    __m128i hi = _mm_shuffle_epi8(bytes, _mm_load_si128((const __m128i*)gather2High));
+    _mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_and_si128(lo, low6), _mm_and_si128(_mm_srli_epi32(lo, 2), high5)));
+    _mm_storeu_si128((__m128i*)(dst + 4),
+                     _mm_or_si128(_mm_and_si128(hi, low6), _mm_and_si128(_mm_srli_epi32(hi, 2), high5)));
+}
+
+#else // NEON
+
+static inline uint8x16_t utf8Errors(uint8x16_t input, uint8x16_t prev) {
+    const uint8x16_t nibble = vdupq_n_u8(0x0F);
+    uint8x16_t prev1 = vextq_u8(prev, input, 15);
+    uint8x16_t special = vandq_u8(vandq_u8(vqtbl1q_u8(vld1q_u8(byte1High), vshrq_n_u8(prev1, 4)),
+                                           vqtbl1q_u8(vld1q_u8(byte1Low), vandq_u8(prev1, nibble))),
+                                  vqtbl1q_u8(vld1q_u8(byte2High), vshrq_n_u8(input, 4)));
+    uint8x16_t third = vqsubq_u8(vextq_u8(prev, input, 14), vdupq_n_u8(0xE0 - 0x80));
+    uint8x16_t fourth = vqsubq_u8(vextq_u8(prev, input, 13), vdupq_n_u8(0xF0 - 0x80));
+    uint8x16_t must23 = vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+    return veorq_u8(must23, special);
+}
+
+struct Utf8Check {
+    uint8x16_t prev = vdupq_n_u8(0), error = vdupq_n_u8(0), incomplete = vdupq_n_u8(0);
+
+    void check(const uint8_t *s, size_t blocks) {
+        static const uint8_t lastLeads[16] = {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+                                              0xF0 - 1, 0xE0 - 1, 0xC0 - 1};
+        for (size_t b = 0; b < blocks; b++) {
+            uint8x16_t input = vld1q_u8(s + 16 * b);
+            if (vmaxvq_u8(input) < 0x80) {
+                error = vorrq_u8(error, incomplete);
+            } else {
+                error = vorrq_u8(error, utf8Errors(input, prev));
+                incomplete = vqsubq_u8(input, vld1q_u8(lastLeads));
+            }
+            prev = input;
+        }
+    }
+
+    void finish(const uint8_t *s, size_t length) {
+        uint8_t tail[16] = {};
+        std::copy(s, s + length, tail);
+        error = vorrq_u8(error, utf8Errors(vld1q_u8(tail), prev));
+    }
+
+    bool ok() const { return vmaxvq_u8(error) == 0; }
+};
+
+static inline void widen3(const uint8_t *p, uint32_t *dst) {
+    uint32x4_t x = vreinterpretq_u32_u8(vqtbl1q_u8(vld1q_u8(p), vreinterpretq_u8_s8(vld1q_s8(gather3))));
+    uint32x4_t cp = vorrq_u32(vandq_u32(x, vdupq_n_u32(0x3F)),
+                              vorrq_u32(vandq_u32(vshrq_n_u32(x, 2), vdupq_n_u32(0xFC0)),
+                                        vandq_u32(vshrq_n_u32(x, 4), vdupq_n_u32(0xF000))));
+    vst1q_u32(dst, cp);
+}
+
+static inline void widen2(const uint8_t *p, uint32_t *dst) {
+    uint8x16_t bytes = vld1q_u8(p);
+    uint32x4_t lo = vreinterpretq_u32_u8(vqtbl1q_u8(bytes, vreinterpretq_u8_s8(vld1q_s8(gather2Low))));
+    uint32x4_t hi = vreinterpretq_u32_u8(vqtbl1q_u8(bytes, vreinterpretq_u8_s8(vld1q_s8(gather2High))));
+    vst1q_u32(dst, vorrq_u32(vandq_u32(lo, vdupq_n_u32(0x3F)), vandq_u32(vshrq_n_u32(lo, 2), vdupq_n_u32(0x7C0))));
+    vst1q_u32(dst + 4, vorrq_u32(vandq_u32(hi, vdupq_n_u32(0x3F)), vandq_u32(vshrq_n_u32(hi, 2), vdupq_n_u32(0x7C0))));
+}
+
+#endif
+
+/**
+ * decodeValid:
+ * Decodes the sequences starting in [i, stop) of input whose first
+ * 'checked' bytes Utf8Check accepted (every such sequence and 16-byte
+ * block lies within them), so nothing is checked again. Blocks of 16
+ * ASCII bytes, of four 3-byte sequences (CJK) or of eight 2-byte
+ * sequences (Cyrillic, Greek, Arabic...) are widened at once; anything
+ * else is decoded one sequence at a time.
+ */
+UTF8_SIMD_TARGET static void decodeValid(const uint8_t *s, size_t &from, size_t stop, size_t checked, uint32_t *dst,
+                                         int *at, size_t &count) {
+    size_t i = from, n = count;
+    while (i < stop) {
+        uint8_t b0 = s[i];
+        if (i + 16 <= checked) {
+            if (b0 < 0x80) {
+                int ascii = widenAscii(s + i, dst + n);
+                if (at) {
+                    for (int k = 0; k < ascii; k++) at[n + k] = (int)(i + k);
+                }
+                n += ascii;
+                i += ascii;
+                continue;
+            }
+            const uint8_t *p = s + i;
+            if ((p[0] & 0xF0) == 0xE0 && (p[3] & 0xF0) == 0xE0 && (p[6] & 0xF0) == 0xE0 && (p[9] & 0xF0) == 0xE0) {
+                widen3(p, dst + n);
+                if (at) {
+                    for (int k = 0; k < 4; k++) at[n + k] = (int)(i + 3 * k);
+                }
+                n += 4;
+                i += 12;
+                continue;
+            }
+            bool pairs = true;
+            for (int k = 0; k < 16 && pairs; k += 2) pairs = (p[k] & 0xE0) == 0xC0;
+            if (pairs) {
+                widen2(p, dst + n);
+                if (at) {
+                    for (int k = 0; k < 8; k++) at[n + k] = (int)(i + 2 * k);
+                }
+                n += 8;
+                i += 16;
+                continue;
+            }
+        }
+
+        uint32_t cp;
+        int len;
+        if (b0 < 0x80)                 { cp = b0;        len = 1; }
+        else if ((b0 & 0xE0) == 0xC0)  { cp = b0 & 0x1F; len = 2; }
+        else if ((b0 & 0xF0) == 0xE0)  { cp = b0 & 0x0F; len = 3; }
+        else                           { cp = b0 & 0x07; len = 4; }
+        for (int k = 1; k < len; k++) cp = (cp << 6) | (s[i + k] & 0x3F);
+        dst[n] = cp;
+        if (at) at[n] = (int)i;
+        n++;
+        i += len;
+    }
+    from = i;
+    count = n;
+}
+
+/**
+ * decodeVectorized:
+ * Validates 16 KiB at a time and decodes what that made safe while it is
+ * still in L1. Returns false, with a partial output, at the first
+ * chunk holding an error; the caller then finds it with the scalar loop.
+ */
+UTF8_SIMD_TARGET static bool decodeVectorized(const uint8_t *s, size_t length, uint32_t *dst, int *at, size_t &n) {
+    const size_t CHUNK_BLOCKS = 1024;
+    Utf8Check check;
+    size_t i = 0, checked = 0;
+    n = 0;
+    while (length - checked >= 16) {
+        size_t blocks = std::min((length - checked) / 16, CHUNK_BLOCKS);
+        check.check(s + checked, blocks);
+        checked += 16 * blocks;
+        if (!check.ok()) return false;
+        // A sequence starting before checked - 16 ends before 'checked'
+        decodeValid(s, i, checked - 16, checked, dst, at, n);
+    }
+    check.finish(s + checked, length - checked);
+    if (!check.ok()) return false;
+    decodeValid(s, i, length, length, dst, at, n);
+    return true;
+}
+
+#endif // UTF8_SIMD_MULTIBYTE
+
+// --- Utf8Decoder ---
+
+/**
+ * decode:
+ * 'out' and 'offsets' are sized once for the worst case (one code point
+ * per byte), filled by index and cut to size at the end. Where SSSE3 or
+ * NEON is available, decodeVectorized() validates with vector lookups and
+ * decodes without further checks. Otherwise, and to find the offset of an
+ * error, the loop below checks one sequence at a time, widening ASCII
+ * runs 16 bytes at a time.
+ */
+bool Utf8Decoder::decode(const char *data, size_t length, std::vector<uint32_t> &out,
+                         std::vector<int> *offsets, size_t *errorOffset) {
+    const uint8_t *s = (const uint8_t*)data;
+    out.resize(length);
+    if (offsets) offsets->resize(length + 1);
+    uint32_t *dst = out.data();
+    int *at = offsets ? offsets->data() : nullptr;
+    size_t n = 0; // Code points decoded; n <= i, so dst has room for 16 more
+
+    auto fail = [&](size_t where) {
+        if (errorOffset) *errorOffset = where;
+        out.resize(n);
+        if (offsets) offsets->resize(n);
+        return false;
+    };
+
+#if defined(UTF8_SIMD_MULTIBYTE)
+    if (hasMultiByteSimd() && decodeVectorized(s, length, dst, at, n)) {
+        out.resize(n);
+        if (offsets) {
+            (*offsets)[n] = (int)length;
+            offsets->resize(n + 1);
+        }
+        return true;
+    }
+    n = 0;
+#endif
+
+    size_t i = 0;
+    while (i < length) {
+        uint8_t b0 = s[i];
+
+        // 1. SIMD: up to 16 ASCII bytes at a time
+        if (b0 < 0x80 && i + 16 <= length) {
+            int ascii = widenAscii(s + i, dst + n);
+            if (at) {
+                for (int k = 0; k < ascii; k++) at[n + k] = (int)(i + k);
+            }
+            n += ascii;
+            i += ascii;
+            continue;
+        }
+
+        // 2. Scalar: one (possibly multi-byte) sequence
+        uint32_t cp;
+        int len;
+        if (b0 < 0x80)                 { cp = b0;        len = 1; }
+        else if ((b0 & 0xE0) == 0xC0)  { cp = b0 & 0x1F; len = 2; }
+        else if ((b0 & 0xF0) == 0xE0)  { cp = b0 & 0x0F; len = 3; }
+        else if ((b0 & 0xF8) == 0xF0)  { cp = b0 & 0x07; len = 4; }
+        else return fail(i);
+
+        if (i + len > length) return fail(i); // Truncated sequence
+        for (int k = 1; k < len; k++) {
+            uint8_t b = s[i + k];
+            if ((b & 0xC0) != 0x80) return fail(i);
+            cp = (cp << 6) | (b & 0x3F);
+        }
+
+        // Reject overlong forms, surrogates and out-of-range values
+        static const uint32_t minValue[5] = {0, 0, 0x80, 0x800, 0x10000};
+        if (cp < minValue[len] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return fail(i);
+
+        dst[n] = cp;
+        if (at) at[n] = (int)i;
+        n++;
+        i += len;
+    }
+
+    out.resize(n);
+    if (offsets) {
+        (*offsets)[n] = (int)length;
+        offsets->resize(n + 1);
+    }
+    return true;
+}
+
+void Utf8Decoder::encode(uint32_t cp, std::string &out) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+// --- Utf8SuffixTree ---
+
+Utf8SuffixTree::Utf8SuffixTree(std::string t) : text(std::move(t)) {
+    std::vector<uint32_t> codePoints;
+    size_t errorOffset = 0;
+    if (!Utf8Decoder::decode(text.data(), text.size(), codePoints, &byteOffsets, &errorOffset)) {
+        throw std::invalid_argument("Utf8SuffixTree: invalid UTF-8 at byte " + std::to_string(errorOffset));
+    }
+    tree = std::make_unique<SymbolSuffixTree<uint32_t>>(std::move(codePoints), TERMINATOR);
+}
+
+int Utf8SuffixTree::toCodePointOffset(int byteOffset) const {
+    // Index of the code point containing 'byteOffset'
+    auto it = std::upper_bound(byteOffsets.begin(), byteOffsets.end(), byteOffset);
+    return (int)(it - byteOffsets.begin()) - 1;
+}
+
+bool Utf8SuffixTree::search(const std::string &pattern) {
+    std::vector<uint32_t> codePoints;
+    return Utf8Decoder::decode(pattern.data(), pattern.size(), codePoints) && tree->search(codePoints);
+}
+
+std::vector<int> Utf8SuffixTree::findAll(const std::string &pattern, Unit unit) {
+    std::vector<uint32_t> codePoints;
+    if (!Utf8Decoder::decode(pattern.data(), pattern.size(), codePoints)) return {};
+
+    std::vector<int> positions = tree->findAll(codePoints);
+    // The empty pattern also matches the terminator suffix
+    positions.erase(std::remove(positions.begin(), positions.end(), getCodePointCount()), positions.end());
+    if (unit == Unit::Bytes) {
+        for (int &p : positions) p = byteOffsets[p];
+    }
+    return positions;
+}
+
+int Utf8SuffixTree::count(const std::string &pattern) {
+    std::vector<uint32_t> codePoints;
+    if (!Utf8Decoder::decode(pattern.data(), pattern.size(), codePoints)) return 0;
+    if (codePoints.empty()) return getCodePointCount();
+    return tree->count(codePoints);
+}
+
+void Utf8SuffixTree::printTree() {
+    tree->printTree([](std::ostream &out, uint32_t cp) {
+        std::string utf8;
+        if (cp == TERMINATOR) utf8 = "$";
+        else Utf8Decoder::encode(cp, utf8);
+        out << utf8;
+    });
+}
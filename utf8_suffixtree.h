@@ -0,0 +1,80 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ */
+
+#ifndef UTF8_SUFFIX_TREE_H
+#define UTF8_SUFFIX_TREE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "suffixtree_symbol.h"
+
+/**
+ * Utf8Decoder: validating UTF-8 to code point decoder.
+ * With SSSE3 (detected at run time) or NEON, input is validated 16 bytes
+ * at a time with the Keiser-Lemire nibble lookups, and blocks of ASCII,
+ * of 2-byte or of 3-byte sequences are widened at once. Elsewhere ASCII
+ * runs are widened with SSE2 and multi-byte sequences are checked one at
+ * a time. Overlong forms, surrogates, values above U+10FFFF and truncated
+ * sequences are rejected either way.
+ */
+class Utf8Decoder {
+public:
+    /**
+     * @brief Decode 'data' into code points.
+     * @param offsets If non-null, receives the byte offset of every code
+     * point followed by a final entry equal to 'length'.
+     * @param errorOffset If non-null, receives the byte offset of the first
+     * invalid sequence on failure.
+     * @return false if the input is not valid UTF-8.
+     */
+    static bool decode(const char *data, size_t length, std::vector<uint32_t> &out,
+                       std::vector<int> *offsets = nullptr, size_t *errorOffset = nullptr);
+
+    // Appends the UTF-8 encoding of code point 'cp' to 'out'
+    static void encode(uint32_t cp, std::string &out);
+};
+
+/**
+ * Utf8SuffixTree: suffix tree over Unicode code points.
+ * Multi-byte characters become single symbols, so CJK text needs about a
+ * third of the depth and nodes of the byte-level tree, and printTree never
+ * splits a character.
+ */
+class Utf8SuffixTree {
+public:
+    enum class Unit { CodePoints, Bytes };
+
+    // Throws std::invalid_argument if 'text' is not valid UTF-8
+    Utf8SuffixTree(std::string text);
+
+    // Patterns are UTF-8; invalid patterns never match
+    bool search(const std::string &pattern);
+    std::vector<int> findAll(const std::string &pattern, Unit unit = Unit::CodePoints);
+    int count(const std::string &pattern);
+
+    void printTree();
+
+    int getNodeCount() const { return tree->getNodeCount(); }
+    int getCodePointCount() const { return (int)byteOffsets.size() - 1; }
+    const std::string& getText() const { return text; }
+
+    // Conversions between code point and byte positions
+    int toByteOffset(int codePoint) const { return byteOffsets[codePoint]; }
+    int toCodePointOffset(int byteOffset) const;
+
+private:
+    // One past U+10FFFF: never produced by the decoder
+    static constexpr uint32_t TERMINATOR = 0x110000;
+
+    std::string text;
+    std::vector<int> byteOffsets;
+    std::unique_ptr<SymbolSuffixTree<uint32_t>> tree;
+};
+
+#endif // UTF8_SUFFIX_TREE_H
@@ -0,0 +1,146 @@
+/*
+ * Ukkonen's algorithm
+ *
+ * Author: Xinye Chen
+ * Affiliation: Postdoctoral Researcher, Sorbonne University, LIP6, CNRS
+ *
+ * Header-only wavelet matrix over a sequence of integers, used to answer
+ * value-range questions (how many / which values lie in [a, b)) about any
+ * contiguous slice of the sequence in O(log sigma) per level touched.
+ */
+
+#ifndef WAVELET_MATRIX_H
+#define WAVELET_MATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * WaveletMatrix: one bit vector per bit of the values, most significant
+ * first. Level k stably moves the values whose bit k is 0 in front of
+ * those whose bit is 1, so every value prefix owns one contiguous run per
+ * level and a slice [lo, hi) is followed down with two rank queries per
+ * level. Space is about 1.5 bits per value per level.
+ */
+class WaveletMatrix {
+public:
+    WaveletMatrix() : length(0) {}
+
+    // Indexes 'values'; every value must be below 2^32
+    explicit WaveletMatrix(std::vector<uint32_t> values) : length(values.size()) {
+        uint32_t maxValue = 0;
+        for (uint32_t v : values) maxValue = v > maxValue ? v : maxValue;
+        int bits = 1;
+        while (bits < 32 && (maxValue >> bits) != 0) bits++;
+
+        levels.resize(bits);
+        std::vector<uint32_t> next(values.size());
+        for (int k = 0; k < bits; k++) {
+            int shift = bits - 1 - k;
+            Level &level = levels[k];
+            level.words.assign(length / 64 + 1, 0);
+            for (size_t i = 0; i < length; i++) {
+                if ((values[i] >> shift) & 1) level.words[i / 64] |= 1ULL << (i % 64);
+            }
+            level.ranks.resize(level.words.size());
+            uint32_t ones = 0;
+            for (size_t w = 0; w < level.words.size(); w++) {
+                level.ranks[w] = ones;
+                ones += __builtin_popcountll(level.words[w]);
+            }
+            level.zeros = length - ones;
+
+            // Stable partition by the current bit for the next level
+            size_t zero = 0, one = level.zeros;
+            for (size_t i = 0; i < length; i++) {
+                next[(values[i] >> shift) & 1 ? one++ : zero++] = values[i];
+            }
+            values.swap(next);
+        }
+    }
+
+    size_t size() const { return length; }
+
+    // Number of i in [lo, hi) with a <= values[i] < b
+    size_t countRange(size_t lo, size_t hi, uint64_t a, uint64_t b) const {
+        if (a >= b || lo >= hi) return 0;
+        return countLess(lo, hi, b) - countLess(lo, hi, a);
+    }
+
+    /**
+     * @brief Appends the values of [lo, hi) lying in [a, b) to 'out' in
+     * increasing order, stopping after 'limit' values. Costs
+     * O(log sigma) per reported value plus O(log sigma) to find the first.
+     */
+    template <typename T>
+    void listRange(size_t lo, size_t hi, uint64_t a, uint64_t b, std::vector<T> &out,
+                   size_t limit = SIZE_MAX) const {
+        if (a >= b || lo >= hi || limit == 0) return;
+        size_t target = out.size() + limit < out.size() ? SIZE_MAX : out.size() + limit;
+        listRecursive(0, lo, hi, 0, a, b, out, target);
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = 0;
+        for (const Level &level : levels) bytes += level.words.size() * 12;
+        return bytes;
+    }
+
+private:
+    struct Level {
+        std::vector<uint64_t> words;
+        std::vector<uint32_t> ranks; // Ones before each word
+        size_t zeros;
+
+        size_t rank1(size_t i) const {
+            uint64_t below = words[i / 64] & ((1ULL << (i % 64)) - 1);
+            return ranks[i / 64] + __builtin_popcountll(below);
+        }
+        size_t rank0(size_t i) const { return i - rank1(i); }
+    };
+
+    std::vector<Level> levels;
+    size_t length;
+
+    // Number of i in [lo, hi) with values[i] < x
+    size_t countLess(size_t lo, size_t hi, uint64_t x) const {
+        int bits = levels.size();
+        if (x >> bits) return hi - lo;
+        size_t less = 0;
+        for (int k = 0; k < bits && lo < hi; k++) {
+            const Level &level = levels[k];
+            size_t lo0 = level.rank0(lo), hi0 = level.rank0(hi);
+            if ((x >> (bits - 1 - k)) & 1) {
+                less += hi0 - lo0;
+                lo = level.zeros + (lo - lo0);
+                hi = level.zeros + (hi - hi0);
+            } else {
+                lo = lo0;
+                hi = hi0;
+            }
+        }
+        return less;
+    }
+
+    // Visits the run of values with the given prefix at level k, zeros first
+    template <typename T>
+    void listRecursive(int k, size_t lo, size_t hi, uint64_t prefix, uint64_t a, uint64_t b,
+                       std::vector<T> &out, size_t target) const {
+        int bits = levels.size();
+        int rest = bits - k;
+        uint64_t first = prefix << rest, last = ((prefix + 1) << rest) - 1;
+        if (lo >= hi || last < a || first >= b || out.size() >= target) return;
+        if (k == bits) {
+            for (size_t i = lo; i < hi && out.size() < target; i++) out.push_back((T)prefix);
+            return;
+        }
+        const Level &level = levels[k];
+        size_t lo0 = level.rank0(lo), hi0 = level.rank0(hi);
+        listRecursive(k + 1, lo0, hi0, prefix << 1, a, b, out, target);
+        listRecursive(k + 1, level.zeros + (lo - lo0), level.zeros + (hi - hi0), (prefix << 1) | 1, a, b, out,
+                      target);
+    }
+};
+
+#endif // WAVELET_MATRIX_H